@@ -13,6 +13,7 @@ app.use(fileUpload());
 
 // Minimization
 const fs = require('fs');
+const zlib = require('zlib');
 const JavaScriptObfuscator = require('javascript-obfuscator');
 
 // Important, pass in port as in `npm run dev 1234`, do not change
@@ -45,6 +46,12 @@ app.post('/upload', function(req, res) {
   }
  
   let uploadFile = req.files.uploadFile;
+
+  // Parse and validate the upload from memory; invalid cards never touch the disk
+  let summary = takeResult(parserLib.getSummaryFromBuffer(summaryIndex, 'uploads/' + uploadFile.name, uploadFile.data, uploadFile.data.length));
+  if(summary.startsWith('Error')) {
+    return res.status(400).send(summary);
+  }
  
   // Use the mv() method to place the file somewhere on your server
   uploadFile.mv('uploads/' + uploadFile.name, function(err) {
@@ -52,6 +59,10 @@ app.post('/upload', function(req, res) {
       return res.status(500).send(err);
     }
 
+    // The upload was validated above, before it was written
+    parserLib.confirmUploadSummary(summaryIndex, 'uploads/' + uploadFile.name);
+    parserLib.markCardTrusted('uploads/' + uploadFile.name);
+    cardsChanged('uploads/' + uploadFile.name);
     res.redirect('/');
   });
 });
@@ -61,6 +72,9 @@ app.get('/uploads/:name', function(req , res){
   fs.stat('uploads/' + req.params.name, function(err, stat) {
     console.log(err);
     if(err == null) {
+      if (cardNotModified(req, res, stat)) {
+        return;
+      }
       res.sendFile(path.join(__dirname+'/uploads/' + req.params.name));
     } else {
       res.send('');
@@ -70,20 +84,474 @@ app.get('/uploads/:name', function(req , res){
 
 //******************** Your code goes here ******************** 
 let parserLib = ffi.Library('./libcparse', {
-	'getSummaryFromFile': ['string', ['string']],
-	'getPropertiesFromFile': ['string', ['string']]
+	'getSummaryFromFile': ['pointer', ['string']],
+	'getPropertiesFromFile': ['pointer', ['string']],
+	'openSummaryIndex': ['pointer', ['string']],
+	'getSummaryFromIndex': ['pointer', ['pointer', 'string']],
+	'getPropertiesFromIndex': ['pointer', ['pointer', 'string']],
+	'getSummaryFromBuffer': ['pointer', ['pointer', 'string', 'pointer', 'size_t']],
+	'confirmUploadSummary': ['int', ['pointer', 'string']],
+	'findDuplicates': ['pointer', ['string']],
+	'getPropertiesRange': ['pointer', ['string', 'int', 'int']],
+	'getCorpusStats': ['pointer', ['string']],
+	'loadCorpusColumns': ['pointer', ['string']],
+	'freeCorpusColumns': ['void', ['pointer']],
+	'getColumnStats': ['pointer', ['pointer']],
+	'exportCard': ['pointer', ['string', 'string']],
+	'buildDateIndex': ['pointer', ['string']],
+	'updateDateIndex': ['int', ['pointer', 'string']],
+	'freeDateIndex': ['void', ['pointer']],
+	'getUpcomingDates': ['pointer', ['pointer', 'int', 'int']],
+	'getDatesInRange': ['pointer', ['pointer', 'int', 'int']],
+	'getThreadParserContext': ['pointer', []],
+	'getSummaryFromFileCtx': ['string', ['pointer', 'string']],
+	'getPropertiesFromFileCtx': ['string', ['pointer', 'string']],
+	'getParserContextStats': ['string', ['pointer']],
+	'getSummaryFromFileInto': ['int', ['string', 'pointer', 'int']],
+	'getPropertiesFromFileInto': ['int', ['string', 'pointer', 'int']],
+	'freeResult': ['void', ['pointer']],
+	'openPropertyStream': ['pointer', ['string']],
+	'nextPropertyChunk': ['string', ['pointer', 'int']],
+	'closePropertyStream': ['void', ['pointer']],
+	'isPropertyStreamFailed': ['bool', ['pointer']],
+	'diffCardFiles': ['pointer', ['string', 'string']],
+	'patchCardFile': ['int', ['string', 'string']],
+	'printError': ['pointer', ['int']],
+	'openValueStream': ['pointer', ['string', 'string', 'int']],
+	'getValueMediaType': ['string', ['pointer']],
+	'getValueError': ['string', ['pointer']],
+	'readValueChunk': ['int', ['pointer', 'pointer', 'int']],
+	'closeValueStream': ['void', ['pointer']],
+	'setParserContextLevel': ['void', ['pointer', 'int']],
+	'markCardTrusted': ['int', ['string']],
+	'queryCardFiles': ['pointer', ['string', 'string']],
+	'buildSummaryList': ['pointer', ['string', 'string', 'int']],
+	'updateSummaryList': ['int', ['pointer', 'pointer', 'string']],
+	'freeSummaryList': ['void', ['pointer']],
+	'getSummaryPage': ['pointer', ['pointer', 'string', 'int', 'int', 'bool']]
+});
+
+// Allocating functions are declared as returning pointers so their strings can be freed once copied
+function takeResult(ptr) {
+  if (ptr.isNull()) {
+    return '';
+  }
+  const text = ptr.readCString();
+  parserLib.freeResult(ptr);
+  return text;
+}
+
+// Caller-owned buffer for the *Into functions, grown when a result does not fit
+let resultBuffer = Buffer.alloc(64 * 1024);
+
+function readInto(fn, fileName) {
+  let needed = fn(fileName, resultBuffer, resultBuffer.length);
+  if (needed > resultBuffer.length) {
+    resultBuffer = Buffer.alloc(needed * 2);
+    needed = fn(fileName, resultBuffer, resultBuffer.length);
+  }
+  return needed > 0 ? resultBuffer.toString('utf8', 0, needed - 1) : '';
+}
+
+// Native addon built from binding.gyp by `npm install`; it returns objects instead of JSON text.
+// The ffi functions above are used when it has not been built.
+let addon = null;
+try {
+  addon = require('./build/Release/vcardparser.node');
+} catch (err) {
+  console.log('vcardparser addon not built; using ffi');
+}
+
+// Summaries persist across restarts in a memory-mapped index, revalidated against file mtimes on lookup
+const summaryIndex = parserLib.openSummaryIndex('uploads/.summary.idx');
+
+// Node runs parser calls on one thread, so that thread's context keeps its buffers warm for every request
+const parserContext = parserLib.getThreadParserContext();
+
+// Cards this server wrote or accepted are marked trusted, so its reads skip validating them again
+const VALIDATE_TRUSTED = 3;
+parserLib.setParserContextLevel(parserContext, VALIDATE_TRUSTED);
+
+// Birthdays and anniversaries of every card, sorted for range queries, and summaries of every card,
+// presorted for paging.  Both are built off the event loop at startup, from the summary index where it
+// is current, and then updated one file at a time as cards change.  Until a build lands they are null,
+// which the parser answers as empty.
+let dateIndex = null;
+let summaryList = null;
+
+// Files changed while a build runs, applied to its result once it lands; null when no build is running
+let pendingChanges = null;
+
+// Column store of every card behind /stats, built on first use off the event loop and dropped when the
+// cards change.  A build started before a change is thrown away rather than cached.
+let corpusColumns = null;
+let corpusGeneration = 0;
+let corpusWaiters = null;
+
+function withCorpusColumns(callback) {
+  if (corpusColumns !== null) {
+    return callback(corpusColumns);
+  }
+  if (corpusWaiters !== null) {
+    return corpusWaiters.push(callback);
+  }
+  corpusWaiters = [callback];
+  const generation = corpusGeneration;
+  parserLib.loadCorpusColumns.async('uploads', function(err, columns) {
+    const waiters = corpusWaiters;
+    corpusWaiters = null;
+    if (generation !== corpusGeneration) {
+      if (!err) {
+        parserLib.freeCorpusColumns(columns);
+      }
+      return waiters.forEach(withCorpusColumns);
+    }
+    if (!err && !columns.isNull()) {
+      corpusColumns = columns;
+    }
+    waiters.forEach(function(waiter) {
+      waiter(corpusColumns);
+    });
+  });
+}
+
+function invalidateCorpusColumns() {
+  corpusGeneration++;
+  if (corpusColumns !== null) {
+    parserLib.freeCorpusColumns(corpusColumns);
+    corpusColumns = null;
+  }
+}
+
+// Duplicate groups across uploads/, found off the event loop on first use and kept until the cards change
+let duplicates = null;
+let duplicatesGeneration = 0;
+let duplicatesWaiters = null;
+
+function withDuplicates(callback) {
+  if (duplicates !== null) {
+    return callback(duplicates);
+  }
+  if (duplicatesWaiters !== null) {
+    return duplicatesWaiters.push(callback);
+  }
+  duplicatesWaiters = [callback];
+  const generation = duplicatesGeneration;
+  parserLib.findDuplicates.async('uploads', function(err, ptr) {
+    const waiters = duplicatesWaiters;
+    const result = err ? '' : takeResult(ptr);
+    duplicatesWaiters = null;
+    if (generation !== duplicatesGeneration) {
+      return waiters.forEach(withDuplicates);
+    }
+    if (result !== '') {
+      duplicates = result;
+    }
+    waiters.forEach(function(waiter) {
+      waiter(result);
+    });
+  });
+}
+
+function rebuildIndexes() {
+  if (pendingChanges !== null) {
+    return;
+  }
+  pendingChanges = [];
+  let dates = null;
+  let summaries = null;
+  let remaining = 2;
+
+  function landed() {
+    if (--remaining > 0) {
+      return;
+    }
+    if (dateIndex !== null) {
+      parserLib.freeDateIndex(dateIndex);
+    }
+    if (summaryList !== null) {
+      parserLib.freeSummaryList(summaryList);
+    }
+    dateIndex = dates;
+    summaryList = summaries;
+    const changes = pendingChanges;
+    pendingChanges = null;
+    changes.forEach(updateIndexes);
+  }
+  parserLib.buildDateIndex.async('uploads', function(err, index) {
+    dates = err || index.isNull() ? null : index;
+    landed();
+  });
+  parserLib.buildSummaryList.async('uploads', 'uploads/.summary.idx', VALIDATE_TRUSTED, function(err, list) {
+    summaries = err || list.isNull() ? null : list;
+    landed();
+  });
+}
+
+// Brings this process's indexes up to date for one written or patched card, reading only that file
+function updateIndexes(fileName) {
+  if (pendingChanges !== null) {
+    pendingChanges.push(fileName);
+  }
+  const dateErr = dateIndex === null ? 0 : parserLib.updateDateIndex(dateIndex, fileName);
+  const listErr = summaryList === null ? 0 : parserLib.updateSummaryList(summaryList, summaryIndex, fileName);
+  // Running out of memory part way can leave the file out, so start over from the directory
+  if (dateErr !== 0 || listErr !== 0) {
+    rebuildIndexes();
+  }
+  invalidateCorpusColumns();
+  duplicatesGeneration++;
+  duplicates = null;
+}
+
+// Updates this process's view of uploads/ and, when running under cluster.js, tells the other workers to
+function cardsChanged(fileName) {
+  updateIndexes(fileName);
+  if (process.send) {
+    process.send({type: 'cardsChanged', file: fileName});
+  }
+}
+
+process.on('message', function(message) {
+  if (message && message.type === 'cardsChanged') {
+    updateIndexes(message.file);
+  }
 });
 
+rebuildIndexes();
+
+// Today as YYYYMMDD in server local time
+function todayKey() {
+  const now = new Date();
+  return now.getFullYear() * 10000 + (now.getMonth() + 1) * 100 + now.getDate();
+}
+
 app.get('/endpoint', function(req, res) {
   const fileName = req.query.file; 
-  var c = parserLib.getSummaryFromFile("uploads/"+fileName);
-  res.send(c);
+  unlessCardNotModified(req, res, "uploads/"+fileName, function() {
+    var c;
+    if (summaryIndex.isNull() && addon) {
+      return addon.getSummaryAsync("uploads/"+fileName, function(err, summary) {
+        sendCompressed(req, res, err ? err.message : summary);
+      });
+    } else if (summaryIndex.isNull()) {
+      c = readInto(parserLib.getSummaryFromFileInto, "uploads/"+fileName);
+    } else {
+      c = takeResult(parserLib.getSummaryFromIndex(summaryIndex, "uploads/"+fileName));
+    }
+    sendCompressed(req, res, c);
+  });
+});
+
+// Sets ETag, Last-Modified and Cache-Control from the card file's inode, size and mtime, and answers 304
+// if the client's copy is current.  Only the file is stat'ed, so unchanged cards are never parsed.
+function cardNotModified(req, res, stat) {
+  const tag = '"' + stat.ino.toString(16) + '-' + stat.size.toString(16) + '-' + Math.floor(stat.mtimeMs).toString(16) + '"';
+  res.set('ETag', 'W/' + tag);
+  res.set('Last-Modified', stat.mtime.toUTCString());
+  // Browsers keep their copy but revalidate it on every load
+  res.set('Cache-Control', 'private, no-cache');
+
+  let fresh = false;
+  const ifNoneMatch = req.get('If-None-Match');
+  const ifModifiedSince = req.get('If-Modified-Since');
+  if (ifNoneMatch) {
+    // If-None-Match uses the weak comparison and takes precedence over If-Modified-Since
+    fresh = ifNoneMatch.trim() === '*' || ifNoneMatch.split(/\s*,\s*/).some(t => t.replace(/^W\//, '') === tag);
+  } else if (ifModifiedSince) {
+    const since = Date.parse(ifModifiedSince);
+    fresh = !isNaN(since) && Math.floor(stat.mtimeMs / 1000) * 1000 <= since;
+  }
+  if (fresh) {
+    res.status(304).end();
+  }
+  return fresh;
+}
+
+// Runs next(stat) unless the card is unchanged and a 304 has been sent.  Missing files fall through to
+// next(null), which reports them as before.
+function unlessCardNotModified(req, res, fileName, next) {
+  fs.stat(fileName, function(err, stat) {
+    if (err == null && stat.isFile() && cardNotModified(req, res, stat)) {
+      return;
+    }
+    next(err == null ? stat : null);
+  });
+}
+
+// Bodies smaller than this are sent uncompressed; the bytes saved would not pay for the encoding
+const compressionThreshold = 1024;
+
+// Properties are written in chunks of about this many bytes as they are built
+const propertyChunkSize = 16 * 1024;
+
+// Full listings of card files up to this size come from the summary index's cache; larger ones are streamed
+const maxIndexedListingSize = 64 * 1024;
+
+// Brotli arrived in zlib with Node 10.16 and 11.7; older Nodes only offer gzip
+const hasBrotli = typeof zlib.createBrotliCompress === 'function' && typeof zlib.brotliCompress === 'function';
+
+// The encoding to use for a body of size bytes: 'br' or 'gzip' if the client accepts one, otherwise null
+function chooseEncoding(req, res, size) {
+  res.vary('Accept-Encoding');
+  if (size < compressionThreshold) {
+    return null;
+  }
+  const encoding = hasBrotli ? req.acceptsEncodings('br', 'gzip', 'identity') : req.acceptsEncodings('gzip', 'identity');
+  return encoding === 'br' || encoding === 'gzip' ? encoding : null;
+}
+
+// A stream that compresses into res, at levels fast enough for per-request use
+function createEncoder(encoding) {
+  if (encoding === 'br') {
+    return zlib.createBrotliCompress({params: {[zlib.constants.BROTLI_PARAM_QUALITY]: 5}});
+  }
+  return zlib.createGzip({level: 6});
+}
+
+// Sends a string or object like res.send, compressed when it is large enough and the client accepts it
+function sendCompressed(req, res, body) {
+  if (typeof body !== 'string') {
+    res.type('json');
+    body = JSON.stringify(body);
+  } else if (!res.get('Content-Type')) {
+    res.type('html');
+  }
+  const encoding = chooseEncoding(req, res, Buffer.byteLength(body));
+  if (encoding === null) {
+    return res.send(body);
+  }
+  const compress = encoding === 'br' ? zlib.brotliCompress : zlib.gzip;
+  const options = encoding === 'br' ? {params: {[zlib.constants.BROTLI_PARAM_QUALITY]: 5}} : {level: 6};
+  compress(body, options, function(err, encoded) {
+    if (err) {
+      return res.send(body);
+    }
+    res.set('Content-Encoding', encoding);
+    res.send(encoded);
+  });
+}
+
+// Streams a card's full property listing as the parser builds it, compressed when the card file
+// is large enough.  Writing waits for 'drain' whenever the socket is backed up.
+function streamProperties(req, res, fileName, stat) {
+  const stream = parserLib.openPropertyStream(fileName);
+  if (stream.isNull()) {
+    return res.status(500).send('');
+  }
+  res.type('html');
+  const encoding = chooseEncoding(req, res, stat ? stat.size : 0);
+  let body = res;
+  if (encoding !== null) {
+    res.set('Content-Encoding', encoding);
+    body = createEncoder(encoding);
+    body.pipe(res);
+  }
+
+  let done = false;
+  function finish() {
+    if (!done) {
+      done = true;
+      parserLib.closePropertyStream(stream);
+    }
+  }
+  res.on('close', finish);
+
+  (function writeChunks() {
+    let chunk;
+    while (!done && (chunk = parserLib.nextPropertyChunk(stream, propertyChunkSize)) !== '') {
+      if (!body.write(chunk)) {
+        return body.once('drain', writeChunks);
+      }
+    }
+    // Part of the listing has been sent with a 200, so a failure can only cut the response off
+    if (!done && parserLib.isPropertyStreamFailed(stream)) {
+      finish();
+      return res.destroy();
+    }
+    finish();
+    body.end();
+  })();
+}
+
+// Decoded values are read from the card file in pieces of this size
+const valueChunkSize = 64 * 1024;
+
+// Streams a card's first PHOTO, LOGO or SOUND, or with ?number= the value of any property in /endpoint2's
+// numbering, decoded from base64 or quoted-printable as it is read from the card file.  Large values are
+// never held in memory or listed in the JSON.
+app.get('/uploads/:name/:property(photo|logo|sound)', function(req, res) {
+  const fileName = 'uploads/' + path.basename(req.params.name);
+  unlessCardNotModified(req, res, fileName, function() {
+    const stream = parserLib.openValueStream(fileName, req.params.property.toUpperCase(), parseInt(req.query.number, 10) || 0);
+    if (stream.isNull()) {
+      return res.status(500).send('');
+    }
+    const error = parserLib.getValueError(stream);
+    if (error !== '') {
+      parserLib.closeValueStream(stream);
+      return res.status(404).send(error);
+    }
+    // The type is the card's, so the browser is told not to second-guess it, and anything
+    // but an image is downloaded rather than shown
+    const mediaType = parserLib.getValueMediaType(stream);
+    res.type(mediaType);
+    res.set('X-Content-Type-Options', 'nosniff');
+    if (!mediaType.startsWith('image/')) {
+      res.set('Content-Disposition', 'attachment');
+    }
+
+    let done = false;
+    function finish() {
+      if (!done) {
+        done = true;
+        parserLib.closeValueStream(stream);
+      }
+    }
+    res.on('close', finish);
+
+    // Each piece gets its own buffer, since res may still hold the last one
+    (function writeChunks() {
+      while (!done) {
+        const chunk = Buffer.alloc(valueChunkSize);
+        const n = parserLib.readValueChunk(stream, chunk, valueChunkSize);
+        if (n <= 0) {
+          break;
+        }
+        if (!res.write(chunk.slice(0, n))) {
+          return res.once('drain', writeChunks);
+        }
+      }
+      finish();
+      res.end();
+    })();
+  });
 });
 
 app.get('/endpoint2', function(req, res) {
 	const fileName = req.query.file;
-  var c = parserLib.getPropertiesFromFile("uploads/"+fileName);
-  res.send(c);
+  unlessCardNotModified(req, res, "uploads/"+fileName, function(stat) {
+    const isRange = req.query.offset !== undefined || req.query.limit !== undefined;
+    var c;
+    if (!isRange && !summaryIndex.isNull() && (stat === null || stat.size <= maxIndexedListingSize)) {
+      // Small listings are cached in the shared index, so each card is listed once across all workers
+      c = takeResult(parserLib.getPropertiesFromIndex(summaryIndex, "uploads/"+fileName));
+    } else if (!isRange) {
+      // Larger cards are streamed, so their listing is never held whole in memory or in the index
+      return streamProperties(req, res, "uploads/"+fileName, stat);
+    } else if (addon) {
+      const offset = parseInt(req.query.offset, 10) || 0;
+      const limit = parseInt(req.query.limit, 10) || 50;
+      return addon.getPropertiesAsync("uploads/"+fileName, offset, limit, function(err, page) {
+        sendCompressed(req, res, err ? err.message : page);
+      });
+    } else {
+      const offset = parseInt(req.query.offset, 10) || 0;
+      const limit = parseInt(req.query.limit, 10) || 50;
+      c = takeResult(parserLib.getPropertiesRange("uploads/"+fileName, offset, limit));
+    }
+    sendCompressed(req, res, c);
+  });
 });
 
 app.get('/uploads', function(req, res) {
@@ -98,6 +566,145 @@ app.get('/uploads', function(req, res) {
 	});
 });
 
+app.get('/duplicates', function(req, res) {
+  withDuplicates(function(result) {
+    res.send(result);
+  });
+});
+
+// Streams every valid card in uploads/ as one .vcf or JSON Lines download.
+// Cards are serialized one at a time and writing pauses until 'drain' whenever the socket is backed up.
+app.get('/export', function(req, res) {
+  const format = req.query.format || 'vcf';
+  if (format !== 'vcf' && format !== 'jsonl') {
+    return res.status(400).send('Unknown export format');
+  }
+  fs.readdir('./uploads', function(err, items) {
+    if (err != null) {
+      return res.status(500).send('');
+    }
+    items = items.filter(item => !(/(^|\/)\.[^\/\.]/g).test(item)).sort();
+
+    let next = 0;
+    let closed = false;
+    req.on('close', function() { closed = true; });
+    res.type(format === 'vcf' ? 'text/vcard' : 'application/x-ndjson');
+    res.set('Content-Disposition', 'attachment; filename="cards.' + format + '"');
+
+    (function writeCards() {
+      for (let written = 0; next < items.length && !closed; written++) {
+        // Give other requests a turn between batches
+        if (written === 64) {
+          return setImmediate(writeCards);
+        }
+        const card = takeResult(parserLib.exportCard('uploads/' + items[next++], format));
+        if (card !== '' && !res.write(card)) {
+          return res.once('drain', writeCards);
+        }
+      }
+      res.end();
+    })();
+  });
+});
+
+// Birthdays and anniversaries in the next ?days= days (default 30), starting today
+app.get('/dates/upcoming', function(req, res) {
+  const days = parseInt(req.query.days, 10) || 30;
+  res.type('json').send(takeResult(parserLib.getUpcomingDates(dateIndex, todayKey(), days)));
+});
+
+// Birthdays and anniversaries with a full date between ?from= and ?to=, both YYYYMMDD
+app.get('/dates', function(req, res) {
+  const from = parseInt(req.query.from, 10);
+  const to = parseInt(req.query.to, 10);
+  if (isNaN(from) || isNaN(to)) {
+    return res.status(400).send('from and to must be YYYYMMDD');
+  }
+  res.type('json').send(takeResult(parserLib.getDatesInRange(dateIndex, from, to)));
+});
+
+// Call counts and buffer sizes of the shared parser context
+app.get('/parserStats', function(req, res) {
+  res.type('json').send(parserLib.getParserContextStats(parserContext));
+});
+
+// Property, count and parameter aggregates over every valid card in uploads/
+app.get('/stats', function(req, res) {
+  withCorpusColumns(function(columns) {
+    res.type('json').send(columns === null ? '{}' : takeResult(parserLib.getColumnStats(columns)));
+  });
+});
+
+// A page of card summaries: ?sort=name|file|count, ?order=desc, ?offset= and ?limit= (default 100, at most 1000)
+const summarySorts = ['name', 'file', 'count'];
+app.get('/summaries', function(req, res) {
+  const sort = req.query.sort || 'name';
+  if (summarySorts.indexOf(sort) < 0) {
+    return res.status(400).send('sort must be name, file or count');
+  }
+  const offset = Math.max(parseInt(req.query.offset, 10) || 0, 0);
+  const limit = Math.min(Math.max(parseInt(req.query.limit, 10) || 100, 1), 1000);
+  res.type('json');
+  sendCompressed(req, res, takeResult(parserLib.getSummaryPage(summaryList, sort, offset, limit, req.query.order === 'desc')));
+});
+
+// Cards in uploads/ matching ?q=, such as  TEL;TYPE=work AND EMAIL $ @example.com
+app.get('/query', function(req, res) {
+  if (typeof req.query.q !== 'string' || req.query.q === '') {
+    return res.status(400).send('q must be a query');
+  }
+  // Every card is scanned, so the query runs off the event loop
+  parserLib.queryCardFiles.async('uploads', req.query.q, function(err, ptr) {
+    const result = err ? '' : takeResult(ptr);
+    if (result === '' || result.startsWith('Error')) {
+      return res.status(400).send(result || 'Query failed');
+    }
+    res.type('json');
+    sendCompressed(req, res, result);
+  });
+});
+
+// Property-level diff that turns uploads/?from= into uploads/?to=, in the wire form patchCardFile reads
+app.get('/diff', function(req, res) {
+  const from = req.query.from, to = req.query.to;
+  if (!from || !to || from !== path.basename(from) || to !== path.basename(to)) {
+    return res.status(400).send('from and to must name uploaded cards');
+  }
+  const diff = takeResult(parserLib.diffCardFiles('uploads/' + from, 'uploads/' + to));
+  if (diff === '') {
+    return res.status(400).send('Both cards must exist and be valid');
+  }
+  res.type('json');
+  sendCompressed(req, res, diff);
+});
+
+// Patches an uploaded card in place with a diff sent as the request body
+const maxPatchSize = 1024 * 1024;
+app.post('/uploads/:name/patch', function(req, res) {
+  const chunks = [];
+  let size = 0;
+  req.on('data', function(chunk) {
+    size += chunk.length;
+    if (size > maxPatchSize) {
+      res.status(413).send('Patch too large');
+      return req.destroy();
+    }
+    chunks.push(chunk);
+  });
+  req.on('end', function() {
+    if (res.headersSent) {
+      return;
+    }
+    const fileName = 'uploads/' + path.basename(req.params.name);
+    const err = parserLib.patchCardFile(fileName, Buffer.concat(chunks).toString('utf8'));
+    if (err !== 0) {
+      return res.status(400).send('Patch failed: ' + takeResult(parserLib.printError(err)));
+    }
+    cardsChanged(fileName);
+    res.send('');
+  });
+});
+
 //Sample endpoint
 app.get('/someendpoint', function(req , res){
   //let c = parserLib.getSummaryFromFile("uploads/testCardMin.vcf");
@@ -0,0 +1,34 @@
+{
+  "targets": [
+    {
+      "target_name": "vcardparser",
+      "sources": [
+        "parser/addon/VCardAddon.c",
+        "parser/src/VCardParser.c",
+        "parser/src/LinkedListAPI.c",
+        "parser/src/ParserFunctions.c",
+        "parser/src/SummaryIndex.c",
+        "parser/src/Corpus.c",
+        "parser/src/CardFingerprint.c",
+        "parser/src/CompressedStream.c",
+        "parser/src/CardScanner.c",
+        "parser/src/LazyCard.c",
+        "parser/src/StringIntern.c",
+        "parser/src/CorpusColumns.c",
+        "parser/src/CardExport.c",
+        "parser/src/DateIndex.c",
+        "parser/src/ParserContext.c",
+        "parser/src/PropertyStream.c",
+        "parser/src/CardDiff.c",
+        "parser/src/CardTrust.c",
+        "parser/src/ValueStream.c",
+        "parser/src/ValueDecode.c",
+        "parser/src/CardQuery.c",
+        "parser/src/SummaryList.c"
+      ],
+      "include_dirs": ["parser/include"],
+      "cflags_c": ["-std=c11", "-pthread"],
+      "libraries": ["-lz", "-pthread"]
+    }
+  ]
+}
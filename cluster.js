@@ -0,0 +1,59 @@
+'use strict'
+
+// Cluster mode: runs app.js in one worker process per core, all listening on the same port.
+// Workers share parsed summaries and property listings through the memory-mapped
+// uploads/.summary.idx, so a card parsed by one worker is served from the cache by the others.
+// Usage: `npm run cluster PORT [WORKERS]`
+
+const cluster = require('cluster');
+const os = require('os');
+const path = require('path');
+
+const portNum = process.argv[2];
+const workerCount = parseInt(process.argv[3], 10) || os.cpus().length;
+
+// setupMaster rather than setupPrimary, which needs a Node newer than the ffi stack builds on
+cluster.setupMaster({
+  exec: path.join(__dirname, 'app.js'),
+  args: [portNum]
+});
+
+// Restart delays for workers that die soon after starting, doubling up to a limit, so a worker
+// that cannot start does not become a fork loop
+const minRestartDelay = 1000;
+const maxRestartDelay = 60 * 1000;
+const stableUptime = 30 * 1000;
+let restartDelay = 0;
+
+function startWorker() {
+  const worker = cluster.fork();
+  worker.startedAt = Date.now();
+
+  // An upload in one worker changes the cards every worker has indexed
+  worker.on('message', function(message) {
+    if (message && message.type === 'cardsChanged') {
+      for (const id in cluster.workers) {
+        if (cluster.workers[id] !== worker) {
+          cluster.workers[id].send(message);
+        }
+      }
+    }
+  });
+}
+
+for (let i = 0; i < workerCount; i++) {
+  startWorker();
+}
+
+// Replace workers that die so the pool keeps its size, backing off while they keep dying young
+cluster.on('exit', function(worker, code, signal) {
+  if (Date.now() - worker.startedAt >= stableUptime) {
+    restartDelay = 0;
+  } else {
+    restartDelay = Math.min(Math.max(restartDelay * 2, minRestartDelay), maxRestartDelay);
+  }
+  console.log('Worker ' + worker.process.pid + ' exited (' + (signal || code) + '), restarting in ' + restartDelay + ' ms');
+  setTimeout(startWorker, restartDelay);
+});
+
+console.log('Running ' + workerCount + ' workers at localhost: ' + portNum);
@@ -0,0 +1,414 @@
+/**
+ * @file VCardAddon.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#include <limits.h>
+#include <node_api.h>
+
+#include "VCardParser.h"
+#include "ParserFunctions.h"
+#include "LazyCard.h"
+
+/*  Node addon over the parser.  Results are built as JavaScript objects straight from
+    the Card, Property and DateTime structures, so no JSON text is produced in C or
+    parsed in JavaScript.  Each function has an *Async form that parses on the libuv
+    thread pool and calls back (error, result) once the objects are built.
+*/
+
+// Largest path accepted from JavaScript, including the NUL terminator
+#define MAX_PATH_LENGTH 4096
+
+typedef enum { JOB_CARD, JOB_SUMMARY, JOB_PROPERTIES } JobKind;
+
+// One call's arguments and parse results, shared by the sync and async paths
+typedef struct job {
+    JobKind         kind;
+    char            fileName[MAX_PATH_LENGTH];
+    int             offset;
+    int             limit;
+    VCardErrorCode  err;
+
+    // JOB_CARD
+    Card*           card;
+
+    // JOB_SUMMARY
+    char*           name;
+    int             opLength;
+    bool            isInvalid;
+
+    // JOB_PROPERTIES; the requested range is built before the job completes
+    LazyCard*       lazyCard;
+
+    napi_async_work work;
+    napi_ref        callback;
+} Job;
+
+/* End of the property range a JOB_PROPERTIES job asks for, clamped to the card without overflowing. */
+static int rangeEnd(const Job* job) {
+    int total = getLazyPropertyCount(job->lazyCard);
+
+    return job->limit > total - job->offset ? total : job->offset + job->limit;
+}
+
+/* Runs the parse for a job.  Touches no JavaScript values, so it is safe off the main thread. */
+static void runJob(Job* job) {
+    switch (job->kind) {
+    case JOB_CARD:
+        if ((job->err = createCard(job->fileName, &job->card)) == OK && (job->err = validateCard(job->card)) != OK)
+            job->isInvalid = true;
+        break;
+    case JOB_SUMMARY:
+        job->err = summarizeFile(job->fileName, &job->name, &job->opLength, &job->isInvalid);
+        break;
+    case JOB_PROPERTIES:
+        if ((job->err = createLazyCard(job->fileName, &job->lazyCard)) == OK) {
+            int end = rangeEnd(job);
+
+            job->err = job->lazyCard->validation;
+            job->isInvalid = job->err != OK;
+            for (int i = job->offset; job->err == OK && i < end; i++)
+                if (!getLazyProperty(job->lazyCard, i)) job->err = OTHER_ERROR;
+        }
+        break;
+    }
+}
+
+static void deleteJob(Job* job) {
+    if (job == NULL) return;
+
+    deleteCard(job->card);
+    deleteLazyCard(job->lazyCard);
+    free(job->name);
+    free(job);
+}
+
+/*********************************** JavaScript values ***********************************/
+
+static napi_value makeString(napi_env env, const char* str) {
+    napi_value value;
+
+    if (napi_create_string_utf8(env, str ? str : "", NAPI_AUTO_LENGTH, &value) != napi_ok) return NULL;
+    return value;
+}
+
+static napi_value makeInt(napi_env env, int number) {
+    napi_value value;
+
+    if (napi_create_int32(env, number, &value) != napi_ok) return NULL;
+    return value;
+}
+
+static napi_value makeBool(napi_env env, bool flag) {
+    napi_value value;
+
+    if (napi_get_boolean(env, flag, &value) != napi_ok) return NULL;
+    return value;
+}
+
+static bool setField(napi_env env, napi_value object, const char* key, napi_value value) {
+    return value != NULL && napi_set_named_property(env, object, key, value) == napi_ok;
+}
+
+/* Builds an array of a List's strings. */
+static napi_value makeValues(napi_env env, const List* values) {
+    ListIterator iter = createIterator((List*) values);
+    napi_value array;
+    napi_value item;
+    char* value;
+    uint32_t i = 0;
+
+    if (napi_create_array_with_length(env, getLength((List*) values), &array) != napi_ok) return NULL;
+    while ((value = nextElement(&iter)) != NULL) {
+        if (!(item = makeString(env, value)) || napi_set_element(env, array, i++, item) != napi_ok) return NULL;
+    }
+    return array;
+}
+
+/* Builds {group, name, parameters: [{name, value}], values: [...]}, the shape cardToJSONLine writes. */
+static napi_value makeProperty(napi_env env, const Property* prop) {
+    ListIterator iter = createIterator(prop->parameters);
+    napi_value object;
+    napi_value parameters;
+    napi_value item;
+    Parameter* param;
+    uint32_t i = 0;
+
+    if (napi_create_object(env, &object) != napi_ok
+            || napi_create_array_with_length(env, getLength(prop->parameters), &parameters) != napi_ok)
+        return NULL;
+    while ((param = nextElement(&iter)) != NULL) {
+        if (napi_create_object(env, &item) != napi_ok || !setField(env, item, "name", makeString(env, param->name))
+                || !setField(env, item, "value", makeString(env, param->value))
+                || napi_set_element(env, parameters, i++, item) != napi_ok)
+            return NULL;
+    }
+
+    if (!setField(env, object, "group", makeString(env, prop->group)) || !setField(env, object, "name", makeString(env, prop->name))
+            || !setField(env, object, "parameters", parameters) || !setField(env, object, "values", makeValues(env, prop->values)))
+        return NULL;
+    return object;
+}
+
+static napi_value makeDate(napi_env env, const DateTime* date) {
+    napi_value object;
+
+    if (date == NULL) {
+        if (napi_get_null(env, &object) != napi_ok) return NULL;
+        return object;
+    }
+    if (napi_create_object(env, &object) != napi_ok || !setField(env, object, "isText", makeBool(env, date->isText))
+            || !setField(env, object, "date", makeString(env, date->date)) || !setField(env, object, "time", makeString(env, date->time))
+            || !setField(env, object, "text", makeString(env, date->text)) || !setField(env, object, "isUTC", makeBool(env, date->UTC)))
+        return NULL;
+    return object;
+}
+
+static napi_value makeCard(napi_env env, const Card* card) {
+    ListIterator iter = createIterator(card->optionalProperties);
+    napi_value object;
+    napi_value properties;
+    napi_value item;
+    Property* prop;
+    uint32_t i = 0;
+
+    if (napi_create_object(env, &object) != napi_ok
+            || napi_create_array_with_length(env, getLength(card->optionalProperties), &properties) != napi_ok)
+        return NULL;
+    while ((prop = nextElement(&iter)) != NULL) {
+        if (!(item = makeProperty(env, prop)) || napi_set_element(env, properties, i++, item) != napi_ok) return NULL;
+    }
+
+    if (!setField(env, object, "fn", makeProperty(env, card->fn)) || !setField(env, object, "properties", properties)
+            || !setField(env, object, "birthday", makeDate(env, card->birthday))
+            || !setField(env, object, "anniversary", makeDate(env, card->anniversary)))
+        return NULL;
+    return object;
+}
+
+/* Builds {file, name, opLength}, with the file named as getSummaryFromFile names it. */
+static napi_value makeSummary(napi_env env, const Job* job) {
+    const char* file = strchr(job->fileName, '/');
+    napi_value object;
+
+    if (napi_create_object(env, &object) != napi_ok
+            || !setField(env, object, "file", makeString(env, file ? file + 1 : job->fileName))
+            || !setField(env, object, "name", makeString(env, job->name))
+            || !setField(env, object, "opLength", makeInt(env, job->opLength)))
+        return NULL;
+    return object;
+}
+
+/* Builds {total, offset, properties: [...]}; FN is property number 1, as in getPropertiesRange. */
+static napi_value makePropertyRange(napi_env env, Job* job) {
+    int total = getLazyPropertyCount(job->lazyCard);
+    int end = rangeEnd(job);
+    long size;
+    napi_value object;
+    napi_value properties;
+    napi_value item;
+
+    if (napi_create_object(env, &object) != napi_ok
+            || napi_create_array_with_length(env, end > job->offset ? end - job->offset : 0, &properties) != napi_ok)
+        return NULL;
+    for (int i = job->offset; i < end; i++) {
+        if (!(item = makeProperty(env, getLazyProperty(job->lazyCard, i))) || !setField(env, item, "number", makeInt(env, i + 1))
+                || napi_set_element(env, properties, i - job->offset, item) != napi_ok)
+            return NULL;
+        // Values left in the file are listed with their size, as in getPropertiesRange
+        if ((size = getLazyValueSize(job->lazyCard, i)) >= 0 && !setField(env, item, "size", makeInt(env, size > INT_MAX ? INT_MAX : (int) size)))
+            return NULL;
+    }
+
+    if (!setField(env, object, "total", makeInt(env, total)) || !setField(env, object, "offset", makeInt(env, job->offset))
+            || !setField(env, object, "properties", properties))
+        return NULL;
+    return object;
+}
+
+/* Builds the Error for a failed job.  Its message is the text the string functions return and its code the VCardErrorCode name. */
+static napi_value makeJobError(napi_env env, const Job* job) {
+    StringBuffer text;
+    char* code;
+    napi_value error = NULL;
+    napi_value message;
+
+    if (!initStringBuffer(&text)) return NULL;
+    code = printError(job->err);
+    if (appendSummaryError(&text, job->fileName, job->isInvalid) && (message = makeString(env, text.str))
+            && napi_create_error(env, NULL, message, &error) == napi_ok)
+        setField(env, error, "code", makeString(env, code));
+    free(code);
+    free(text.str);
+
+    return error;
+}
+
+/* Builds a finished job's result, or NULL with *error set if the parse failed. */
+static napi_value makeJobResult(napi_env env, Job* job, napi_value* error) {
+    *error = NULL;
+    if (job->err != OK) {
+        *error = makeJobError(env, job);
+        return NULL;
+    }
+
+    switch (job->kind) {
+    case JOB_CARD:
+        return makeCard(env, job->card);
+    case JOB_SUMMARY:
+        return makeSummary(env, job);
+    case JOB_PROPERTIES:
+        return makePropertyRange(env, job);
+    }
+    return NULL;
+}
+
+/*********************************** Arguments ***********************************/
+
+/* Reads a job's arguments: fileName, then offset and limit for JOB_PROPERTIES, then a callback if async. */
+static Job* readJobArgs(napi_env env, napi_callback_info info, JobKind kind, bool isAsync, napi_value* callback) {
+    napi_value argv[4];
+    size_t argc = 4;
+    size_t expected = (kind == JOB_PROPERTIES ? 3 : 1) + (isAsync ? 1 : 0);
+    size_t length;
+    napi_valuetype type;
+    Job* job;
+
+    if (napi_get_cb_info(env, info, &argc, argv, NULL, NULL) != napi_ok) return NULL;
+    if (argc < expected) {
+        napi_throw_type_error(env, NULL, "Wrong number of arguments");
+        return NULL;
+    }
+    if (!(job = calloc(1, sizeof(Job)))) {
+        napi_throw_error(env, NULL, "Out of memory");
+        return NULL;
+    }
+    job->kind = kind;
+
+    if (napi_get_value_string_utf8(env, argv[0], job->fileName, MAX_PATH_LENGTH, &length) != napi_ok
+            || length >= MAX_PATH_LENGTH - 1) {
+        napi_throw_type_error(env, NULL, "fileName must be a string path");
+        free(job);
+        return NULL;
+    }
+    if (kind == JOB_PROPERTIES && (napi_get_value_int32(env, argv[1], &job->offset) != napi_ok
+            || napi_get_value_int32(env, argv[2], &job->limit) != napi_ok)) {
+        napi_throw_type_error(env, NULL, "offset and limit must be numbers");
+        free(job);
+        return NULL;
+    }
+    if (job->offset < 0) job->offset = 0;
+    if (job->limit < 0) job->limit = 0;
+
+    if (isAsync) {
+        if (napi_typeof(env, argv[expected - 1], &type) != napi_ok || type != napi_function) {
+            napi_throw_type_error(env, NULL, "callback must be a function");
+            free(job);
+            return NULL;
+        }
+        *callback = argv[expected - 1];
+    }
+    return job;
+}
+
+/*********************************** Sync and async entry points ***********************************/
+
+static napi_value runSync(napi_env env, napi_callback_info info, JobKind kind) {
+    napi_value result;
+    napi_value error;
+    Job* job;
+
+    if (!(job = readJobArgs(env, info, kind, false, NULL))) return NULL;
+
+    runJob(job);
+    if (!(result = makeJobResult(env, job, &error)) && error) napi_throw(env, error);
+    deleteJob(job);
+
+    return result;
+}
+
+static void executeJob(napi_env env, void* data) {
+    runJob((Job*) data);
+}
+
+static void completeJob(napi_env env, napi_status status, void* data) {
+    Job* job = (Job*) data;
+    napi_value callback;
+    napi_value global;
+    napi_value argv[2];
+
+    if (napi_get_reference_value(env, job->callback, &callback) == napi_ok && napi_get_global(env, &global) == napi_ok) {
+        if (status != napi_ok) {
+            job->err = OTHER_ERROR;
+        }
+        argv[1] = makeJobResult(env, job, &argv[0]);
+        if (argv[0] == NULL) napi_get_null(env, &argv[0]);
+        if (argv[1] == NULL) napi_get_undefined(env, &argv[1]);
+        napi_call_function(env, global, callback, 2, argv, NULL);
+    }
+
+    napi_delete_reference(env, job->callback);
+    napi_delete_async_work(env, job->work);
+    deleteJob(job);
+}
+
+static napi_value runAsync(napi_env env, napi_callback_info info, JobKind kind) {
+    napi_value callback;
+    napi_value name;
+    Job* job;
+
+    if (!(job = readJobArgs(env, info, kind, true, &callback))) return NULL;
+
+    if (!(name = makeString(env, "vcardparser")) || napi_create_reference(env, callback, 1, &job->callback) != napi_ok) {
+        deleteJob(job);
+        return NULL;
+    }
+    if (napi_create_async_work(env, NULL, name, executeJob, completeJob, job, &job->work) != napi_ok
+            || napi_queue_async_work(env, job->work) != napi_ok) {
+        napi_delete_reference(env, job->callback);
+        deleteJob(job);
+        napi_throw_error(env, NULL, "Could not queue parser work");
+    }
+    return NULL;
+}
+
+static napi_value jsCreateCard(napi_env env, napi_callback_info info) {
+    return runSync(env, info, JOB_CARD);
+}
+
+static napi_value jsCreateCardAsync(napi_env env, napi_callback_info info) {
+    return runAsync(env, info, JOB_CARD);
+}
+
+static napi_value jsGetSummary(napi_env env, napi_callback_info info) {
+    return runSync(env, info, JOB_SUMMARY);
+}
+
+static napi_value jsGetSummaryAsync(napi_env env, napi_callback_info info) {
+    return runAsync(env, info, JOB_SUMMARY);
+}
+
+static napi_value jsGetProperties(napi_env env, napi_callback_info info) {
+    return runSync(env, info, JOB_PROPERTIES);
+}
+
+static napi_value jsGetPropertiesAsync(napi_env env, napi_callback_info info) {
+    return runAsync(env, info, JOB_PROPERTIES);
+}
+
+static napi_value init(napi_env env, napi_value exports) {
+    napi_property_descriptor functions[] = {
+        { "createCard", NULL, jsCreateCard, NULL, NULL, NULL, napi_default, NULL },
+        { "createCardAsync", NULL, jsCreateCardAsync, NULL, NULL, NULL, napi_default, NULL },
+        { "getSummary", NULL, jsGetSummary, NULL, NULL, NULL, napi_default, NULL },
+        { "getSummaryAsync", NULL, jsGetSummaryAsync, NULL, NULL, NULL, napi_default, NULL },
+        { "getProperties", NULL, jsGetProperties, NULL, NULL, NULL, napi_default, NULL },
+        { "getPropertiesAsync", NULL, jsGetPropertiesAsync, NULL, NULL, NULL, napi_default, NULL },
+    };
+
+    if (napi_define_properties(env, exports, sizeof(functions) / sizeof(functions[0]), functions) != napi_ok) return NULL;
+    return exports;
+}
+
+NAPI_MODULE(NODE_GYP_MODULE_NAME, init)
@@ -0,0 +1,125 @@
+/**
+ * @file CardDiff.h
+ * @author Joshua Sarabdial
+ * @date October 2026
+ * @brief Property-level differences between two versions of a card, and patching
+ **/
+
+#ifndef _CARDDIFF_H
+#define _CARDDIFF_H
+
+#include "VCardParser.h"
+
+typedef enum changeKind { CHANGE_ADD, CHANGE_REMOVE, CHANGE_REPLACE } ChangeKind;
+
+// One change to a card's optional properties
+typedef struct propertyChange {
+    ChangeKind          kind;
+
+    // fingerprintProperty of the property removed or replaced, so the patch touches exactly that
+    // property even when several share a name.  0 for CHANGE_ADD.
+    unsigned long long  target;
+
+    // Name of the property removed or replaced, kept for readers of the wire form.  From internName.
+    const char*         name;
+
+    // The added or replacing property, owned by the change.  NULL for CHANGE_REMOVE.
+    Property*           property;
+} PropertyChange;
+
+/*  The changes that turn one card into another.  Optional properties are matched by
+    group, name and parameters (see fingerprintPropertyKey): a property whose key
+    appears in both cards with different values is replaced, others are added or
+    removed, and unchanged properties are not listed.  FN, BDAY and ANNIVERSARY are
+    carried whole when they change.
+*/
+typedef struct cardDiff {
+    // PropertyChange elements, removals and replacements first, then additions
+    List*       changes;
+
+    // The new FN, or NULL if FN is unchanged
+    Property*   fn;
+
+    // The new dates, when the matching flag is set.  NULL with the flag set removes the date.
+    bool        isBirthdayChanged;
+    DateTime*   birthday;
+    bool        isAnniversaryChanged;
+    DateTime*   anniversary;
+} CardDiff;
+
+/** Function to compute the changes that turn one card into another.
+ *@pre from and to are valid cards
+ *@post diff holds a newly allocated CardDiff, or NULL on failure
+ *@return OK, or OTHER_ERROR if memory runs out
+ *@param from - the card as the receiver has it
+ *@param to - the updated card
+ *@param diff - set to the new CardDiff
+ **/
+VCardErrorCode diffCards(const Card* from, const Card* to, CardDiff** diff);
+
+/** Function to apply a diff to a card.  Every target is located before anything is changed,
+ *  so a diff that does not fit the card leaves it untouched.
+ *@pre obj is a valid card
+ *@post obj equals the diff's "to" card, up to the order of added properties
+ *@return OK, INV_PROP if a removed or replaced property is not in obj, or OTHER_ERROR if memory runs out
+ *@param obj - the card to patch
+ *@param diff - a pointer to a CardDiff
+ **/
+VCardErrorCode applyCardDiff(Card* obj, const CardDiff* diff);
+
+/** Function to free a CardDiff and everything it owns.  Safe to call with NULL.
+ *@param diff - a pointer to a CardDiff
+ **/
+void deleteCardDiff(CardDiff* diff);
+
+/** Function to get the number of changes in a diff, counting FN and date changes.
+ *@return number of changes, or 0 if diff is NULL
+ *@param diff - a pointer to a CardDiff
+ **/
+int getCardDiffLength(const CardDiff* diff);
+
+/** Function to convert a diff to its JSON wire form:
+ *  {"changes":[{"op":"add","property":PROP},{"op":"remove","name":"...","target":"HEX"},
+ *  {"op":"replace","name":"...","target":"HEX","property":PROP}],"fn":PROP,"birthday":DT|null,"anniversary":DT|null}
+ *  where PROP and DT are the forms cardToJSONLine writes.  fn, birthday and anniversary are present only when changed.
+ *@return newly allocated JSON string, or NULL if memory runs out
+ *@param diff - a pointer to a CardDiff
+ **/
+char* cardDiffToJSON(const CardDiff* diff);
+
+/** Function to read a diff from its JSON wire form.  Unknown keys are ignored.
+ *@post diff holds a newly allocated CardDiff, or NULL on failure
+ *@return OK, INV_PROP if the text is not a valid diff, or OTHER_ERROR if memory runs out
+ *@param str - JSON text written by cardDiffToJSON
+ *@param diff - set to the new CardDiff
+ **/
+VCardErrorCode JSONtoCardDiff(const char* str, CardDiff** diff);
+
+/** Function to read a card from the JSON line cardToJSONLine writes, with the same reader as diffs.
+ *  Unknown keys are ignored.  The card is not validated.
+ *@post obj holds a newly allocated Card, or NULL on failure
+ *@return OK, INV_CARD if the text is not a card with an FN, or OTHER_ERROR if memory runs out
+ *@param str - one JSON line, with or without its newline
+ *@param obj - set to the new Card
+ **/
+VCardErrorCode JSONLineToCard(const char* str, Card** obj);
+
+/** Function to diff two card files.
+ *@return newly allocated JSON wire form, or an empty string if either file is not a valid card
+ *@param fromFile - path of the card as the receiver has it
+ *@param toFile - path of the updated card
+ **/
+char* diffCardFiles(char* fromFile, char* toFile);
+
+/** Function to patch a card file in place with a diff in JSON wire form.
+ *  The file is replaced only if the patched card is valid, and is written back in the
+ *  compression its extension names.
+ *@return OK, the error createCard or validateCard gives for the file or the patched card,
+ *        INV_PROP if the diff is malformed or does not fit the card, or WRITE_ERROR,
+ *        also when the file is .vcf.zst and this build cannot write it
+ *@param fileName - path of the card file
+ *@param diffJSON - the diff
+ **/
+VCardErrorCode patchCardFile(char* fileName, char* diffJSON);
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ * @file CardExport.h
+ * @author Joshua Sarabdial
+ * @date October 2026
+ * @brief Per-card serializers used to stream a whole corpus
+ **/
+
+#ifndef _CARDEXPORT_H
+#define _CARDEXPORT_H
+
+#include "VCardParser.h"
+#include "ParserFunctions.h"
+
+/** Function to append a property as {"group":"...","name":"...","parameters":[{"name":"...","value":"..."}],"values":[...]}.
+ *@return false if memory runs out
+ *@param buffer - buffer to append to
+ *@param prop - a pointer to a Property
+ **/
+bool appendPropertyJSON(StringBuffer* buffer, const Property* prop);
+
+/** Function to append a date as {"isText":..,"date":"...","time":"...","text":"...","isUTC":..}, or null if date is NULL.
+ *@return false if memory runs out
+ *@param buffer - buffer to append to
+ *@param date - a pointer to a DateTime, or NULL
+ **/
+bool appendDateJSON(StringBuffer* buffer, const DateTime* date);
+
+/** Function to serialize a card as one line of JSON, including parameters.
+ *  Every string is escaped, and the line ends in a newline.
+ *@pre obj is not NULL
+ *@return newly allocated string of the form
+ *        {"fn":PROP,"properties":[PROP,...],"birthday":DT|null,"anniversary":DT|null}\n
+ *        where PROP is {"group":"...","name":"...","parameters":[{"name":"...","value":"..."}],"values":[...]}
+ *        and DT is {"isText":..,"date":"...","time":"...","text":"...","isUTC":..}, or NULL if memory runs out
+ *@param obj - a pointer to a Card
+ **/
+char* cardToJSONLine(const Card* obj);
+
+/** Function to serialize a card in vCard format, the same way writeCard does.
+ *@pre obj is not NULL
+ *@return newly allocated string, or NULL if serialization fails
+ *@param obj - a pointer to a Card
+ **/
+char* cardToVCard(const Card* obj);
+
+/** Function to parse, validate and serialize one card file for a bulk export.
+ *  Only one card is in memory at a time, so a caller streaming a directory file by file
+ *  uses constant memory.
+ *@return newly allocated serialized card, or an empty string if the file is not a valid card
+ *        or format is unknown
+ *@param fileName - path of the card file
+ *@param format - "vcf" or "jsonl"
+ **/
+char* exportCard(char* fileName, char* format);
+
+#endif
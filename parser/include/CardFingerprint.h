@@ -0,0 +1,49 @@
+/**
+ * @file CardFingerprint.h
+ * @author Joshua Sarabdial
+ * @date October 2026
+ * @brief Normalized content fingerprints and corpus-wide duplicate detection
+ **/
+
+#ifndef _CARDFINGERPRINT_H
+#define _CARDFINGERPRINT_H
+
+#include "VCardParser.h"
+
+/** Function to compute a 64-bit hash of a property's normalized form.
+ *  Group and property names are upper-cased, parameters are sorted by upper-cased
+ *  name and then value, and values are hashed in order.
+ *@pre prop is not NULL and is valid
+ *@return the property hash
+ *@param prop - a pointer to a Property struct
+ **/
+unsigned long long fingerprintProperty(const Property* prop);
+
+/** Function to compute a 64-bit hash of a property's normalized group, name and parameters, ignoring its values.
+ *  Properties with equal keys are the same field of a card, possibly with different values.
+ *@pre prop is not NULL and is valid
+ *@return the key hash
+ *@param prop - a pointer to a Property struct
+ **/
+unsigned long long fingerprintPropertyKey(const Property* prop);
+
+/** Function to compute a stable 64-bit fingerprint of a card's content.
+ *  The fingerprint does not depend on the order of properties in the file, so
+ *  re-exports of the same contact produce the same value.
+ *@pre obj is not NULL and is valid
+ *@return the card fingerprint
+ *@param obj - a pointer to a Card struct
+ **/
+unsigned long long fingerprintCard(const Card* obj);
+
+/** Function to find duplicate cards across a directory in a single parallel pass.
+ *  Cards are grouped by UID, by fingerprint, and by FN together with any EMAIL or TEL value.
+ *@pre dirName is not NULL
+ *@return newly allocated JSON string of the form
+ *        {"byUID":[{"key":"...","files":[...]}],"byFingerprint":[...],"byContact":[...]},
+ *        listing only groups with more than one file.  Returns "{}" if the directory cannot be read.
+ *@param dirName - directory of card files
+ **/
+char* findDuplicates(char* dirName);
+
+#endif
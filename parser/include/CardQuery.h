@@ -0,0 +1,114 @@
+/**
+ * @file CardQuery.h
+ * @author Joshua Sarabdial
+ * @date October 2026
+ * @brief Queries over properties and parameters, compiled once and run across a directory of cards
+ **/
+
+#ifndef _CARDQUERY_H
+#define _CARDQUERY_H
+
+#include "VCardParser.h"
+#include "LazyCard.h"
+
+// Limits on a compiled query, so a card's term results fit in one 64-bit mask
+#define QUERY_MAX_TERMS 64
+#define QUERY_MAX_STEPS 256
+#define QUERY_MAX_DEPTH 32
+
+// How a term compares a property's values
+typedef enum vm { MATCH_ANY, MATCH_EQUALS, MATCH_CONTAINS, MATCH_PREFIX, MATCH_SUFFIX } ValueMatch;
+
+// One step of a compiled query, run on a stack of booleans
+typedef enum qo { QUERY_TERM, QUERY_AND, QUERY_OR, QUERY_NOT } QueryOp;
+
+// A parameter a term requires.  value is NULL when any value will do.
+typedef struct queryParam {
+    char*   name;
+    char*   value;
+} QueryParam;
+
+/*  A term is true for a card when one of its properties meets every condition of the
+    term: its name, its group if one is given, each parameter, and the value match,
+    which any one of the property's values can satisfy.  Names and values are compared
+    without regard to case.  A required parameter value matches one item of a comma
+    separated list, so TYPE=work matches TYPE=work,voice.
+*/
+typedef struct queryTerm {
+    // NULL matches any group
+    char*       group;
+    char*       name;
+
+    int         paramCount;
+    QueryParam* params;
+
+    ValueMatch  match;
+    char*       value;
+} QueryTerm;
+
+typedef struct queryStep {
+    QueryOp op;
+    // Index into terms for QUERY_TERM
+    int     term;
+} QueryStep;
+
+/*  A query compiled to a postfix program.  A card is checked in one pass over its
+    properties, which records every term it satisfies in a mask; the steps then
+    combine the mask's bits.  Immutable once compiled, so it can be shared between threads.
+
+    query   := or
+    or      := and { OR and }
+    and     := unary { AND unary }
+    unary   := NOT unary | '(' or ')' | term
+    term    := [ group '.' ] name { ';' param [ '=' value ] } [ op value ]
+    op      := '=' equals | '~' contains | '^' starts with | '$' ends with
+
+    AND, OR and NOT are matched in any case.  A value is a double-quoted string, with \"
+    and \\ escaped, or a run of characters other than whitespace, '(', ')', ';' and '"'.
+    For example:  TEL;TYPE=work AND EMAIL $ @example.com
+*/
+typedef struct cardQuery {
+    int         termCount;
+    QueryTerm*  terms;
+
+    int         stepCount;
+    QueryStep*  steps;
+} CardQuery;
+
+/** Function to compile a query.
+ *@post errorOffset is set if the query could not be compiled
+ *@return a newly allocated CardQuery, or NULL if text is not a valid query or memory runs out
+ *@param text - the query
+ *@param errorOffset - set to the offset in text where the query stopped making sense, or -1 if memory ran out
+ **/
+CardQuery* compileCardQuery(const char* text, int* errorOffset);
+
+/** Function to free a CardQuery.  Safe to call with NULL.
+ *@param query - a pointer to a CardQuery
+ **/
+void freeCardQuery(CardQuery* query);
+
+/** Function to run a query against a card.  Only properties whose names appear in the
+ *  query are built.  BDAY and ANNIVERSARY are compared as they appear in the card, or as
+ *  date, "T", time and "Z" for dates that are not text, and have no group or parameters.
+ *  Values left in the file, such as large PHOTOs, compare as empty.
+ *@return whether the card matches
+ *@param query - a pointer to a CardQuery
+ *@param card - a pointer to a LazyCard
+ **/
+bool matchCardQuery(const CardQuery* query, LazyCard* card);
+
+/** Function to run a query against every card in a directory.  Files are scanned in
+ *  parallel as lazy cards, and cards that do not validate are counted but never match.
+ *@pre dirName is not NULL
+ *@return newly allocated JSON of the form
+ *        {"matches":[{"file":"...","name":"..."}],"cards":N,"invalid":N}
+ *        with matches in file name order and cards counting the valid cards,
+ *        "Error: Invalid query at character N" if the query does not compile,
+ *        or "Error: Cannot read directory" if the directory cannot be read
+ *@param dirName - directory of card files
+ *@param text - the query
+ **/
+char* queryCardFiles(char* dirName, char* text);
+
+#endif
@@ -0,0 +1,237 @@
+/**
+ * @file CardScanner.h
+ * @author Joshua Sarabdial
+ * @date October 2026
+ * @brief Single-pass content line scanner that checks a card without building it
+ **/
+
+#ifndef _CARDSCANNER_H
+#define _CARDSCANNER_H
+
+#include "VCardParser.h"
+
+// Longest unfolded content line, without its CRLF, that a card may have.  Build with
+// -DMAX_LINE_LENGTH=n to change it; the default leaves room for large inline PHOTOs.
+#ifndef MAX_LINE_LENGTH
+#define MAX_LINE_LENGTH (64 * 1024 * 1024)
+#endif
+
+/*  Reads unfolded content lines from a stream into one reusable buffer, and records
+    where each line came from.  The buffer starts at BUFFERSIZE and grows up to
+    MAX_LINE_LENGTH; a longer line is rejected rather than read.
+*/
+typedef struct cardScanner {
+    FILE*   fp;
+
+    // Current unfolded content line, without its CRLF.  Valid until the next call.
+    char*   line;
+    size_t  lineLength;
+    size_t  capacity;
+
+    // Byte offset and raw length (including folds and CRLF) of the current line
+    long    offset;
+    long    length;
+
+    // Bytes consumed from the stream so far
+    long    position;
+
+    // Set when the current line is the last one in the stream
+    bool    isLast;
+
+    // Set when there are no more lines
+    bool    isEnd;
+} CardScanner;
+
+// How a content line is used by the parser
+typedef enum lk { LINE_HEADER, LINE_FN, LINE_BDAY, LINE_ANNIVERSARY, LINE_OPTIONAL } LineKind;
+
+// Which of validateCard's rules applies to an optional property, by name
+typedef enum nr { RULE_KIND, RULE_N, RULE_GENDER, RULE_PRODID, RULE_REV, RULE_UID, RULE_ADR, RULE_TEL, RULE_ORG,
+        RULE_CLIENTPIDMAP, RULE_STRUCTURE, RULE_DATE, RULE_SINGLE, RULE_UNKNOWN } NameRule;
+
+/*  What the card rules need to know about one content line, wherever it appears in
+    the card.  A card can be checked again from these without reading its bytes.
+*/
+typedef struct lineFacts {
+    // Name or value part is missing or empty.  The other fields are not set.
+    bool            isEmpty;
+
+    bool            isBeginCard;
+    bool            isVersion;
+    bool            isVersionFour;
+    bool            isEndCard;
+
+    // LINE_FN, LINE_BDAY or LINE_ANNIVERSARY by name, LINE_HEADER for VERSION, otherwise LINE_OPTIONAL
+    LineKind        kind;
+
+    // Date without parameters or with VALUE=text, which readCard keeps
+    bool            isTextDate;
+
+    // Result of checking the parameters the way addParams parses them
+    VCardErrorCode  paramsError;
+
+    int             valueCount;
+    NameRule        rule;
+} LineFacts;
+
+/*  Tracks the rules that readCard and validateCard apply to a card, one line at a time.
+    Parse errors are returned by checkContentLine and finishCardCheck; the first
+    validation error is kept in validation so callers can report both the way
+    getSummaryFromFile does.
+*/
+typedef struct cardCheck {
+    bool    isFirstLine;
+    bool    isVersionFour;
+    bool    isEnd;
+    bool    hasFN;
+    int     fnValueCount;
+    // Set when readCard would keep a BDAY or ANNIVERSARY date
+    bool    hasBirthday;
+    bool    hasAnniversary;
+
+    // Properties that may appear at most once
+    bool    hasKind;
+    bool    hasN;
+    bool    hasGender;
+    bool    hasProdID;
+    bool    hasRev;
+    bool    hasUID;
+
+    // Number of properties that would be in optionalProperties
+    int     optionalCount;
+
+    VCardErrorCode validation;
+
+    // Rules applied by getCheckResult, and the first error among validateCard's INV_CARD rules
+    ValidationLevel level;
+    VCardErrorCode  structure;
+} CardCheck;
+
+/** Function to initialize a scanner over an open stream.
+ *@return OK, or OTHER_ERROR if the line buffer cannot be allocated
+ *@param scanner - a pointer to the scanner
+ *@param fp - stream positioned at the start of a card
+ **/
+VCardErrorCode initCardScanner(CardScanner* scanner, FILE* fp);
+
+/** Function to initialize a scanner that reuses a line buffer from an earlier scan.
+ *@post the scanner owns line.  It may be reallocated, so take scanner->line and
+        scanner->capacity back instead of calling freeCardScanner to keep it.
+ *@return OK, or OTHER_ERROR if a buffer cannot be allocated
+ *@param scanner - a pointer to the scanner
+ *@param fp - stream positioned at the start of a card
+ *@param line - buffer to reuse, or NULL to allocate one
+ *@param capacity - size of line
+ **/
+VCardErrorCode initCardScannerBuffer(CardScanner* scanner, FILE* fp, char* line, size_t capacity);
+
+/** Function to read the next unfolded content line.
+ *@return OK, with isEnd set if there are no more lines; INV_PROP if a line does not end in CRLF,
+ *        is longer than MAX_LINE_LENGTH, or the stream is empty;
+ *        INV_FILE if reading the stream fails
+ *@param scanner - a pointer to the scanner
+ **/
+VCardErrorCode nextContentLine(CardScanner* scanner);
+
+/** Function to free the scanner's line buffer.  The stream is not closed.
+ *@param scanner - a pointer to the scanner
+ **/
+void freeCardScanner(CardScanner* scanner);
+
+/** Function to split a content line in place into its group, name, parameters and values.
+ *@post pointers are set into line, or to NULL for absent parts
+ *@param line - content line, modified in place
+ **/
+void splitContentLine(char* line, char** groupName, char** propertyName, char** parameterValues, char** propertyValues);
+
+/** Function to count the values addValues would create from a property value string.
+ *@return number of values
+ *@param propertyValues - value part of a content line
+ **/
+int countValues(const char* propertyValues);
+
+/** Function to build a Property from the parts of a split content line.
+ *@post parameterValues and propertyValues are modified in place
+ *@return OK, or the error encountered while adding parameters or values
+ *@param newProperty - set to the newly allocated Property, which is deleted on failure
+ **/
+VCardErrorCode buildProperty(Property** newProperty, char* groupName, char* propertyName, char* parameterValues, char* propertyValues);
+
+/** Function to initialize a CardCheck.
+ *@param check - a pointer to the CardCheck
+ **/
+void initCardCheck(CardCheck* check);
+
+/** Function to initialize a CardCheck for a validation level.  initCardCheck uses VALIDATE_STRICT.
+ *  With VALIDATE_NONE, optional property names are not looked up and validation stays OK.
+ *@param check - a pointer to the CardCheck
+ *@param level - VALIDATE_NONE, VALIDATE_STRUCTURAL or VALIDATE_STRICT
+ **/
+void initCardCheckLevel(CardCheck* check, ValidationLevel level);
+
+/** Function to get the validation result for the check's level, once finishCardCheck has returned OK.
+ *@return validation for VALIDATE_STRICT, structure for VALIDATE_STRUCTURAL, and OK for VALIDATE_NONE
+ *@param check - a pointer to the CardCheck
+ **/
+VCardErrorCode getCheckResult(const CardCheck* check);
+
+/** Function to check a split content line against the parser and validation rules.
+ *@return OK, or the error readCard would return for this line
+ *@param check - a pointer to the CardCheck
+ *@param kind - set to how the parser uses the line
+ *@param isLast - whether this is the last line of the card
+ **/
+VCardErrorCode checkContentLine(CardCheck* check, LineKind* kind, const char* propertyName, const char* parameterValues,
+        const char* propertyValues, bool isLast);
+
+/** Function to record what the card rules need to know about a split content line.
+ *@param facts - set to the line's facts
+ **/
+void describeContentLine(LineFacts* facts, const char* propertyName, const char* parameterValues, const char* propertyValues);
+
+/** Function to check a described content line, as checkContentLine does.
+ *@return OK, or the error readCard would return for this line
+ *@param check - a pointer to the CardCheck
+ *@param kind - set to how the parser uses the line
+ *@param facts - the line's facts
+ *@param isLast - whether this is the last line of the card
+ **/
+VCardErrorCode checkLineFacts(CardCheck* check, LineKind* kind, const LineFacts* facts, bool isLast);
+
+/** Function to apply the end-of-card rules once every line has been checked.
+ *@return OK, or the error createCard would return.  check->validation holds the result validateCard would return.
+ *@param check - a pointer to the CardCheck
+ **/
+VCardErrorCode finishCardCheck(CardCheck* check);
+
+/** Function to build a card from a scanner that has not read any lines yet.  This is how
+ *  readCard builds every card, so all parsers share its rules.
+ *@post newCardObject is allocated even on failure, and must be deleted by the caller
+ *@return OK, or the error createCard returns
+ *@param scanner - an initialized scanner, which is not freed
+ *@param newCardObject - set to the new Card
+ **/
+VCardErrorCode readCardFromScanner(CardScanner* scanner, Card** newCardObject);
+
+/** Function to summarize a card in one pass without building it.  Only the FN property is built.
+ *@post name is allocated on success and must be freed by the caller
+ *@return OK, or the error createCard or validateCard would return
+ *@param fp - stream positioned at the start of a card.  The stream is not closed.
+ *@param name - set to the first FN value
+ *@param opLength - set to the number of optional properties, counting BDAY and ANNIVERSARY
+ *@param isInvalid - set when the card parses but does not validate
+ **/
+VCardErrorCode summarizeStream(FILE* fp, char** name, int* opLength, bool* isInvalid);
+
+/** Function to summarize a card from a scanner that has not read any lines yet, as summarizeStream does.
+ *@param scanner - an initialized scanner, which is not freed
+ **/
+VCardErrorCode summarizeScanner(CardScanner* scanner, char** name, int* opLength, bool* isInvalid);
+
+/** Function to summarize a card from a scanner as summarizeScanner does, validating it only as far as level asks.
+ *@param scanner - an initialized scanner, which is not freed
+ *@param level - VALIDATE_NONE, VALIDATE_STRUCTURAL or VALIDATE_STRICT
+ **/
+VCardErrorCode summarizeScannerLevel(CardScanner* scanner, ValidationLevel level, char** name, int* opLength, bool* isInvalid);
+
+#endif
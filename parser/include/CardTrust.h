@@ -0,0 +1,52 @@
+/**
+ * @file CardTrust.h
+ * @author Joshua Sarabdial
+ * @date October 2026
+ * @brief Trusted-file markers that let reads of already validated cards skip validation
+ **/
+
+#ifndef _CARDTRUST_H
+#define _CARDTRUST_H
+
+#include "VCardParser.h"
+
+/*  A card file is trusted while the marker markCardTrusted left beside it still matches it.
+    The marker is a hidden sidecar, ".<name>.trusted" in the card's directory, recording the
+    card's inode, size, modification time and change time, so any later write to the card,
+    including a rename over it, makes the marker stale.
+*/
+
+/** Function to record that a card file has been validated.
+ *@pre the file was just written from, or read into, a card that validateCard accepted
+ *@return OK, INV_FILE if the card cannot be stat'ed, or WRITE_ERROR if the marker cannot be written
+ *@param fileName - path of the card file
+ **/
+VCardErrorCode markCardTrusted(const char* fileName);
+
+/** Function to check for a current trusted marker.
+ *@return true if markCardTrusted recorded the file and it has not changed since
+ *@param fileName - path of the card file
+ **/
+bool isCardTrusted(const char* fileName);
+
+/** Function to remove a card's trusted marker, if it has one.
+ *@param fileName - path of the card file
+ **/
+void clearCardTrust(const char* fileName);
+
+/** Function to validate a card strictly, write it and mark the file trusted.
+ *@return OK, the error validateCard gives, or the error writeCard or markCardTrusted gives
+ *@param fileName - path of the card file
+ *@param obj - a pointer to a Card struct
+ **/
+VCardErrorCode writeTrustedCard(const char* fileName, const Card* obj);
+
+/** Function to settle VALIDATE_TRUSTED for a file.
+ *@return VALIDATE_NONE if level is VALIDATE_TRUSTED and the file is trusted, VALIDATE_STRICT
+ *        if it is not, and level itself otherwise
+ *@param fileName - path of the card file
+ *@param level - the requested validation level
+ **/
+ValidationLevel resolveValidationLevel(const char* fileName, ValidationLevel level);
+
+#endif
@@ -0,0 +1,63 @@
+/**
+ * @file CompressedStream.h
+ * @author Joshua Sarabdial
+ * @date October 2026
+ * @brief Streams that decompress .vcf.gz and .vcf.zst input, and compress output, on the fly
+ **/
+
+#ifndef _COMPRESSEDSTREAM_H
+#define _COMPRESSEDSTREAM_H
+
+#include "VCardParser.h"
+
+typedef enum cmp { PLAIN, GZIP, ZSTD } Compression;
+
+// Most bytes a compressed card may decompress to.  Reading past it fails, so a small
+// file that inflates without end cannot exhaust memory.
+#ifndef MAX_CARD_SIZE
+#define MAX_CARD_SIZE (128 * 1024 * 1024)
+#endif
+
+/** Function to determine the compression of a card file from its extension.
+ *@return PLAIN for .vcf, GZIP for .vcf.gz, ZSTD for .vcf.zst
+ *@param fileName - name of the card file
+ **/
+Compression compressionFromName(const char* fileName);
+
+/** Function to determine the compression of in-memory data from its magic bytes.
+ *@return GZIP or ZSTD if data starts with the matching magic number, otherwise PLAIN
+ *@param data - start of the data
+ *@param len - number of bytes in data
+ **/
+Compression compressionFromData(const char* data, size_t len);
+
+/** Function to open a card file for reading, decompressing it on the fly if needed.
+ *  Decompressed bytes are never written to disk; the returned stream inflates one
+ *  block at a time as the tokenizer reads from it.  A read that would go past
+ *  MAX_CARD_SIZE decompressed bytes fails with the stream's error indicator set.
+ *@pre fileName has a card extension (see hasCardExtension)
+ *@return a stream to be closed with fclose, or NULL if the file cannot be opened,
+ *        or uses a compression this build does not support
+ *@param fileName - name of the card file
+ **/
+FILE* openCardFile(const char* fileName);
+
+/** Function to open in-memory card data for reading, decompressing it on the fly if needed.
+ *  Compressed data is capped at MAX_CARD_SIZE decompressed bytes, as for openCardFile.
+ *@pre data points to at least len bytes, which must outlive the stream
+ *@return a stream to be closed with fclose, or NULL on failure
+ *@param data - the contents of a card file, plain or compressed
+ *@param len - number of bytes in data
+ **/
+FILE* openCardBuffer(const char* data, size_t len);
+
+/** Function to create a card file for writing, compressing what is written on the fly.
+ *@post the file is complete once the stream is closed with fclose
+ *@return a stream to be closed with fclose, which returns EOF if compressing or writing failed,
+ *        or NULL if the file cannot be created, or type is not supported by this build
+ *@param fileName - name of the file to create
+ *@param type - compression to write, usually compressionFromName of the file the data is meant for
+ **/
+FILE* createCardFile(const char* fileName, Compression type);
+
+#endif
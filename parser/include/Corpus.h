@@ -0,0 +1,43 @@
+/**
+ * @file Corpus.h
+ * @author Joshua Sarabdial
+ * @date October 2026
+ * @brief Helpers for running work over every card file in a directory
+ **/
+
+#ifndef _CORPUS_H
+#define _CORPUS_H
+
+#include "VCardParser.h"
+
+/** Function to list the card files in a directory.
+ *  Hidden files are skipped and the result is sorted by name.
+ *@pre dirName is not NULL
+ *@post files holds count newly allocated paths of the form dirName/name
+ *@return OK, INV_FILE if the directory cannot be read, or OTHER_ERROR
+ *@param dirName - directory to list
+ *@param files - set to a newly allocated array of paths
+ *@param count - set to the number of paths in files
+ **/
+VCardErrorCode listCardFiles(const char* dirName, char*** files, int* count);
+
+/** Function to free the array returned by listCardFiles.
+ *@param files - array of paths
+ *@param count - number of paths in files
+ **/
+void freeCardFiles(char** files, int count);
+
+/** Function to run work once for every file, spread across threads.
+ *  Each call receives the index of its file, so results can be written to
+ *  per-file slots of a caller-owned array without locking.
+ *@pre files holds count paths
+ *@post work has been called exactly once for each file
+ *@param files - array of paths
+ *@param count - number of paths in files
+ *@param work - function run for each file
+ *@param arg - passed through to work
+ *@param threads - number of threads to use.  0 uses one thread per online CPU.
+ **/
+void forEachCardFile(char** files, int count, void (*work)(int index, const char* file, void* arg), void* arg, int threads);
+
+#endif
@@ -0,0 +1,139 @@
+/**
+ * @file CorpusColumns.h
+ * @author Joshua Sarabdial
+ * @date October 2026
+ * @brief Column-oriented store of every card in a directory, for aggregate queries
+ **/
+
+#ifndef _CORPUSCOLUMNS_H
+#define _CORPUSCOLUMNS_H
+
+#include "VCardParser.h"
+
+/*  A corpus of cards stored as a structure of arrays.  Every property of every valid
+    card is one row; the rows of card c are [cardFirstRow[c], cardFirstRow[c + 1]).
+    FN comes first, then the optional properties, then BDAY and ANNIVERSARY if present.
+    Property names, groups and parameters are ids into a dictionary of strings, so
+    aggregates are integer scans over contiguous arrays.  Property and parameter names
+    are stored in upper case.  Values of LARGE_VALUE_SIZE bytes or more, such as embedded
+    photos, are stored as empty strings, so a store can be kept between queries.
+*/
+typedef struct corpusColumns {
+    // Files listed in the directory, including ones that did not parse
+    char**  files;
+    int     fileCount;
+    int     invalidCount;
+
+    // Per card
+    int     cardCount;
+    int*    cardFile;
+    int*    cardFirstRow;
+
+    // Per property row.  rowFirstParam and rowFirstValue have rowCount + 1 entries.
+    int     rowCount;
+    int*    rowCard;
+    int*    rowName;
+    int*    rowGroup;
+    int*    rowFirstParam;
+    int*    rowFirstValue;
+
+    // Per parameter, as name and value ids
+    int     paramCount;
+    int*    paramName;
+    int*    paramValue;
+
+    // Per value, as an offset of a NUL-terminated string in valueHeap
+    int     valueCount;
+    size_t* valueOffset;
+    char*   valueHeap;
+    size_t  heapUsed;
+
+    // Dictionary of names, groups and parameter values
+    int     stringCount;
+    char**  strings;
+    int*    stringSlots;
+
+    // Allocated sizes
+    int     cardCapacity;
+    int     rowCapacity;
+    int     paramCapacity;
+    int     valueCapacity;
+    size_t  heapCapacity;
+    int     stringCapacity;
+    int     slotCapacity;
+} CorpusColumns;
+
+/** Function to parse every card in a directory into columns.  Cards are parsed in parallel.
+ *@pre dirName is not NULL
+ *@post columns holds every card that parses and validates
+ *@return OK, INV_FILE if the directory cannot be read, or OTHER_ERROR
+ *@param dirName - directory of card files
+ *@param columns - set to a newly allocated CorpusColumns
+ **/
+VCardErrorCode buildCorpusColumns(const char* dirName, CorpusColumns** columns);
+
+/** Function to free a CorpusColumns.  Safe to call with NULL.
+ *@param columns - a pointer to a CorpusColumns
+ **/
+void freeCorpusColumns(CorpusColumns* columns);
+
+/** Function to look up the dictionary id of a string.
+ *@return the id, or -1 if the string does not occur in the corpus
+ *@param columns - a pointer to a CorpusColumns
+ *@param str - string to look up.  Names must be given in upper case.
+ **/
+int findColumnString(const CorpusColumns* columns, const char* str);
+
+/** Function to count how often each dictionary id occurs in an id column.
+ *@pre counts has columns->stringCount entries
+ *@post counts[id] is increased by the number of rows holding id
+ *@param column - id column, such as rowName or paramValue
+ *@param rows - number of rows in column
+ *@param counts - per-id totals
+ **/
+void countByString(const int* column, int rows, int* counts);
+
+/** Function to count, for every card, its properties with a given name.
+ *@pre perCard has columns->cardCount entries
+ *@post perCard[c] is the number of matching properties of card c
+ *@param columns - a pointer to a CorpusColumns
+ *@param nameId - dictionary id of the property name, or -1 to count every property
+ *@param perCard - per-card totals
+ **/
+void countPerCard(const CorpusColumns* columns, int nameId, int* perCard);
+
+/** Function to get the value of a property row.
+ *@return the value string, owned by columns, or NULL if index is out of range
+ *@param columns - a pointer to a CorpusColumns
+ *@param row - property row
+ *@param index - value index within the row
+ **/
+const char* getColumnValue(const CorpusColumns* columns, int row, int index);
+
+/** Function to parse every card in a directory into columns, as buildCorpusColumns does.
+ *@return a newly allocated CorpusColumns, or NULL if dirName is NULL, the directory cannot be read or memory runs out
+ *@param dirName - directory of card files
+ **/
+CorpusColumns* loadCorpusColumns(char* dirName);
+
+/** Function to compute corpus statistics over columns that have already been built, so
+ *  repeated queries over an unchanged directory do not parse it again.
+ *@return newly allocated JSON string of the form
+ *        {"cards":N,"invalid":N,"properties":N,
+ *         "propertyNames":[{"name":"...","count":N,"cards":N,"multiple":N}],
+ *         "propertyCounts":[{"properties":N,"cards":N}],
+ *         "parameters":[{"name":"...","value":"...","count":N}]}
+ *        where multiple is the number of cards with more than one such property, and
+ *        parameters lists the 20 most common pairs.  Returns "{}" if columns is NULL or memory runs out.
+ *@param columns - a pointer to a CorpusColumns
+ **/
+char* getColumnStats(const CorpusColumns* columns);
+
+/** Function to compute corpus statistics for a directory, building and freeing its columns.
+ *@pre dirName is not NULL
+ *@return newly allocated JSON as getColumnStats gives it, or "{}" if the directory cannot be read
+ *@param dirName - directory of card files
+ **/
+char* getCorpusStats(char* dirName);
+
+#endif
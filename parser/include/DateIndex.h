@@ -0,0 +1,79 @@
+/**
+ * @file DateIndex.h
+ * @author Joshua Sarabdial
+ * @date October 2026
+ * @brief Sorted index of birthdays and anniversaries across a directory of cards
+ **/
+
+#ifndef _DATEINDEX_H
+#define _DATEINDEX_H
+
+#include "VCardParser.h"
+
+// One BDAY or ANNIVERSARY of one card
+typedef struct dateEntry {
+    int     monthDay;
+    int     fullDate;
+    int     card;
+    bool    isAnniversary;
+} DateEntry;
+
+/*  Dates of every valid card in a directory, kept in two sorted arrays: every dated
+    entry by monthDay (for yearly recurrences) and entries with a year by fullDate
+    (for absolute ranges).  Queries are a binary search followed by a scan of the
+    matching entries.  updateDateIndex changes an index in place, so it must not run
+    while another thread reads the index.
+*/
+typedef struct dateIndex {
+    // Per card: file name without its directory and first FN value
+    int         cardCount;
+    char**      files;
+    char**      names;
+
+    int         monthDayCount;
+    DateEntry*  byMonthDay;
+
+    int         fullDateCount;
+    DateEntry*  byFullDate;
+} DateIndex;
+
+/** Function to build the date index of a directory.  Only BDAY and ANNIVERSARY are parsed,
+ *  using lazy cards, and files are scanned in parallel.
+ *@pre dirName is not NULL
+ *@return a newly allocated DateIndex, or NULL if the directory cannot be read
+ *@param dirName - directory of card files
+ **/
+DateIndex* buildDateIndex(char* dirName);
+
+/** Function to bring an index up to date after one card file was written, replaced or removed.
+ *  Only that file is read, and its entries are moved into place in each order.
+ *@post the index describes fileName as it is now.  If memory runs out, the file may be left out.
+ *@return OK, or OTHER_ERROR if index or fileName is NULL or memory runs out
+ *@param index - a pointer to a DateIndex
+ *@param fileName - path of the card file, in the directory the index was built from
+ **/
+VCardErrorCode updateDateIndex(DateIndex* index, char* fileName);
+
+/** Function to free a DateIndex.  Safe to call with NULL.
+ *@param index - a pointer to a DateIndex
+ **/
+void freeDateIndex(DateIndex* index);
+
+/** Function to list the birthdays and anniversaries falling in the next days days, in order.
+ *@return newly allocated JSON array of {"file":"...","name":"...","type":"BDAY"|"ANNIVERSARY","monthDay":N,"fullDate":N},
+ *        or "[]" if index is NULL or the arguments are invalid
+ *@param index - a pointer to a DateIndex
+ *@param today - first day of the window as YYYYMMDD
+ *@param days - length of the window in days, including today.  Windows of a year or more list every date once.
+ **/
+char* getUpcomingDates(DateIndex* index, int today, int days);
+
+/** Function to list the birthdays and anniversaries with a full date inside a range, in date order.
+ *@return newly allocated JSON array in the same form as getUpcomingDates
+ *@param index - a pointer to a DateIndex
+ *@param from - first date of the range as YYYYMMDD
+ *@param to - last date of the range as YYYYMMDD
+ **/
+char* getDatesInRange(DateIndex* index, int from, int to);
+
+#endif
@@ -0,0 +1,208 @@
+/**
+ * @file LazyCard.h
+ * @author Joshua Sarabdial
+ * @date October 2026
+ * @brief Cards whose properties are built from an offset index on first access
+ **/
+
+#ifndef _LAZYCARD_H
+#define _LAZYCARD_H
+
+#include <time.h>
+
+#include "VCardParser.h"
+#include "CardScanner.h"
+#include "ParserFunctions.h"
+
+// PHOTO, LOGO, SOUND and KEY lines at least this long leave their value in the file
+#define LARGE_VALUE_SIZE 4096
+
+// Cards kept by acquireLazyCard, and the most card bytes they may hold between them, large values aside
+#define LAZY_CACHE_SLOTS 32
+#define LAZY_CACHE_BYTES (64 * 1024 * 1024)
+
+// Location of one content line in the card
+typedef struct lazyLine {
+    long    offset;
+    long    length;
+} LazyLine;
+
+// Location of a property's value in the card, folds and the closing CRLF included
+typedef struct valueRef {
+    long    offset;
+    long    length;
+} ValueRef;
+
+// A content line as last scanned, kept so a changed file can be re-scanned in part
+typedef struct scannedLine {
+    long                offset;
+    long                length;
+
+    // Hash of the line's raw bytes, used to recognize it after the file changes
+    unsigned long long  hash;
+
+    LineFacts           facts;
+
+    // How the parser used the line where it appeared, and the property built from it, or -1
+    LineKind            kind;
+    int                 property;
+} ScannedLine;
+
+/*  A card that has been scanned but not built.
+    Creating one records the byte offset and length of every FN and optional property
+    line; a Property is built the first time it is accessed and kept until the card is
+    deleted.  The file is read and decompressed once to scan it, so unopened properties
+    are never built, and a file rewritten while the card is open does not change them.
+    Once scanned, large PHOTO, LOGO, SOUND and KEY values are cut out of the bytes the
+    card keeps, and only their locations remain: the Property gets one empty value, and
+    a ValueStream reads the value back from the file.  Offsets are into the card as in
+    the file, decompressed, whatever has been cut out.
+    Not safe for concurrent access.
+*/
+typedef struct lazyCard {
+    // Card bytes, read from the file and decompressed if needed, less the large values
+    char*       data;
+    size_t      dataSize;
+
+    // Size of the whole card, large values included
+    size_t      size;
+
+    // Large values left in the file, in file order
+    int         largeValueCount;
+    ValueRef*   largeValues;
+
+    // The file's mtime and size when it was read
+    struct timespec mtime;
+    long long       fileSize;
+
+    // Property 0 is FN, followed by the optional properties in file order
+    int         propertyCount;
+    LazyLine*   lines;
+    Property**  properties;
+
+    DateTime*   birthday;
+    DateTime*   anniversary;
+
+    // Every content line in file order
+    int             lineCount;
+    ScannedLine*    scanned;
+
+    // Result validateCard would return for the fully built card
+    VCardErrorCode validation;
+} LazyCard;
+
+typedef struct lazyIter {
+    LazyCard*   card;
+    int         next;
+} LazyIterator;
+
+/** Function to scan a card file and index its properties without building them.
+ *@pre fileName has a card extension
+ *@post newCardObject holds the index, or is NULL on failure
+ *@return the error code createCard would return for the same file
+ *@param fileName - path of the card file
+ *@param newCardObject - set to a newly allocated LazyCard
+ **/
+VCardErrorCode createLazyCard(char* fileName, LazyCard** newCardObject);
+
+/** Function to bring a LazyCard up to date after its file was edited or appended to.
+ *  Content lines unchanged at the start and end of the file are not scanned again, only
+ *  the lines between them, and properties whose lines are unchanged, even if they moved,
+ *  keep their Property objects.  Lines are recognized by length and 64-bit hash.
+ *@post on failure obj is left as it was
+ *@return the error createLazyCard would return for the file
+ *@param obj - a LazyCard created from fileName
+ *@param fileName - path of the card file
+ *@param rescanned - if not NULL, set to the number of content lines scanned again
+ **/
+VCardErrorCode refreshLazyCard(LazyCard* obj, char* fileName, int* rescanned);
+
+/** Function to get a LazyCard for a file from a cache shared by the process, as createLazyCard
+ *  would create it.  A cached card whose file has a new mtime or size is brought up to date
+ *  with refreshLazyCard, so properties built from unchanged lines are kept.  Each card is
+ *  handed to one caller at a time; a caller asking for a file whose card is out gets a new
+ *  card that is not cached.
+ *@post newCardObject holds the card, or is NULL on failure.  Release it with releaseLazyCard.
+ *@return the error code createLazyCard would return for the same file
+ *@param fileName - path of the card file
+ *@param newCardObject - set to the card
+ **/
+VCardErrorCode acquireLazyCard(char* fileName, LazyCard** newCardObject);
+
+/** Function to give back a card from acquireLazyCard.  A cached card is kept for the next
+ *  caller, and any other is deleted.  Safe to call with NULL.
+ *@param obj - a pointer to a LazyCard from acquireLazyCard
+ **/
+void releaseLazyCard(LazyCard* obj);
+
+/** Function to free a LazyCard and every property built from it.  Safe to call with NULL.
+ *@param obj - a pointer to a LazyCard
+ **/
+void deleteLazyCard(LazyCard* obj);
+
+/** Function to get the number of properties, counting FN.
+ *@return number of properties, or 0 if obj is NULL
+ *@param obj - a pointer to a LazyCard
+ **/
+int getLazyPropertyCount(const LazyCard* obj);
+
+/** Function to get a property by index, building it on first access.
+ *@return the Property, owned by the LazyCard, or NULL if index is out of range or the property cannot be built
+ *@param obj - a pointer to a LazyCard
+ *@param index - 0 for FN, 1 and above for optional properties in file order
+ **/
+Property* getLazyProperty(LazyCard* obj, int index);
+
+/** Function to get the raw bytes of a property's content line that the card keeps.
+ *@return a pointer into obj->data, or NULL if index is out of range or the property has no line
+ *@param obj - a pointer to a LazyCard
+ *@param index - 0 for FN, 1 and above for optional properties in file order
+ *@param length - set to the number of bytes kept, which stop after the ':' of a value left in the file
+ **/
+const char* getLazyLine(const LazyCard* obj, int index, long* length);
+
+/** Function to find where a property's value lies in the card.
+ *@return true if ref was set, false if index is out of range or the line has no value part
+ *@param obj - a pointer to a LazyCard
+ *@param index - 0 for FN, 1 and above for optional properties in file order
+ *@param ref - set to the value's location in the card, as decompressed from the file
+ **/
+bool findLazyValue(const LazyCard* obj, int index, ValueRef* ref);
+
+/** Function to tell whether a property's value was cut out of the card's bytes and must be read from the file.
+ *@return true if the value is only in the file
+ *@param obj - a pointer to a LazyCard
+ *@param index - 0 for FN, 1 and above for optional properties in file order
+ **/
+bool isLazyValueInFile(const LazyCard* obj, int index);
+
+/** Function to get the size of a value left in the file instead of its Property.
+ *@return the raw length of the value, folds included, or -1 if the Property holds the value
+ *@param obj - a pointer to a LazyCard
+ *@param index - 0 for FN, 1 and above for optional properties in file order
+ **/
+long getLazyValueSize(const LazyCard* obj, int index);
+
+/** Function to append a property's entry to a listing, as appendPropertyEntry does.  The entry
+ *  of a value left in the file has an empty "values" and its raw length in "size".
+ *@return false if the property cannot be built or memory runs out
+ *@param buffer - the listing
+ *@param number - the property's number in the listing
+ *@param obj - a pointer to a LazyCard
+ *@param index - 0 for FN, 1 and above for optional properties in file order
+ **/
+bool appendLazyPropertyEntry(StringBuffer* buffer, int number, LazyCard* obj, int index);
+
+/** Function for creating an iterator over a LazyCard's properties, starting at FN.
+ *@return the iterator
+ *@param obj - a pointer to a LazyCard
+ **/
+LazyIterator createLazyIterator(LazyCard* obj);
+
+/** Function that returns the next property through the iterator, building it if needed.
+ *@return the next Property, or NULL once the end is reached
+ *@param iter - an iterator for a LazyCard
+ **/
+Property* nextLazyProperty(LazyIterator* iter);
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ * @file ParserContext.h
+ * @author Joshua Sarabdial
+ * @date October 2026
+ * @brief Reusable buffers and statistics for repeated parser calls
+ **/
+
+#ifndef _PARSERCONTEXT_H
+#define _PARSERCONTEXT_H
+
+#include "VCardParser.h"
+#include "ParserFunctions.h"
+
+/*  Owns the buffers a parser call would otherwise allocate and free: the content line
+    buffer, the output string and a scratch string.  They keep their size between calls,
+    so a warm context parses without growing any of them.  A context is not thread-safe;
+    create one per worker thread.
+*/
+typedef struct parserContext {
+    // Content line buffer handed to each CardScanner
+    char*           line;
+    size_t          lineCapacity;
+
+    // Result of the last *Ctx call that returns a string
+    StringBuffer    output;
+
+    // Temporary text, such as a property's joined values
+    StringBuffer    scratch;
+
+    // Validation applied by the *Ctx reads, VALIDATE_STRICT unless setParserContextLevel changes it
+    ValidationLevel level;
+
+    // Statistics since the context was created
+    unsigned long   calls;
+    unsigned long   errors;
+    unsigned long   bytesScanned;
+    unsigned long   lineGrowths;
+    unsigned long   outputGrowths;
+} ParserContext;
+
+/** Function to create a parser context with empty statistics.
+ *@return a newly allocated ParserContext, or NULL if memory runs out
+ **/
+ParserContext* createParserContext(void);
+
+/** Function to free a parser context and its buffers.  Safe to call with NULL.
+ *@param ctx - a pointer to a ParserContext
+ **/
+void deleteParserContext(ParserContext* ctx);
+
+/** Function to choose how much the context's reads validate.  With VALIDATE_TRUSTED, files
+ *  carrying a current trusted marker are read without validation and others strictly.
+ *@param ctx - a pointer to a ParserContext
+ *@param level - the validation level for later *Ctx calls
+ **/
+void setParserContextLevel(ParserContext* ctx, ValidationLevel level);
+
+/** Function to create a card as createCard does, reusing the context's line buffer.
+ *@return the error code createCard would return
+ *@param ctx - a pointer to a ParserContext
+ *@param fileName - path of the card file
+ *@param newCardObject - set to the new Card, which the caller deletes
+ **/
+VCardErrorCode createCardCtx(ParserContext* ctx, char* fileName, Card** newCardObject);
+
+/** Function to summarize a card file as getSummaryFromFile does, without building the card.
+ *@return the same text as getSummaryFromFile, owned by ctx and valid until the next call with ctx
+ *@param ctx - a pointer to a ParserContext
+ *@param fileName - path of the card file
+ **/
+const char* getSummaryFromFileCtx(ParserContext* ctx, char* fileName);
+
+/** Function to list a card's properties as getPropertiesFromFile does.
+ *@return the same text as getPropertiesFromFile, owned by ctx and valid until the next call with ctx
+ *@param ctx - a pointer to a ParserContext
+ *@param fileName - path of the card file
+ **/
+const char* getPropertiesFromFileCtx(ParserContext* ctx, char* fileName);
+
+/** Function to report a context's statistics and current buffer sizes.
+ *@return JSON text owned by ctx and valid until the next call with ctx
+ *@param ctx - a pointer to a ParserContext
+ **/
+const char* getParserContextStats(ParserContext* ctx);
+
+/** Function to get the calling thread's own context, which the *Into functions use.
+ *@return the thread's context, created on first use and kept for the thread's lifetime, or NULL if memory runs out
+ **/
+ParserContext* getThreadParserContext(void);
+
+/** Function to write getSummaryFromFile's text into a caller-owned buffer.
+ *  Uses a context private to the calling thread, so no memory is allocated once it is warm.
+ *@post if size is large enough, buffer holds the NUL-terminated text; otherwise buffer is not modified
+ *@return the size the text needs, including its NUL terminator, or 0 if memory runs out
+ *@param fileName - path of the card file
+ *@param buffer - caller-owned buffer
+ *@param size - size of buffer
+ **/
+int getSummaryFromFileInto(char* fileName, char* buffer, int size);
+
+/** Function to write getPropertiesFromFile's text into a caller-owned buffer, as getSummaryFromFileInto does.
+ *@return the size the text needs, including its NUL terminator, or 0 if memory runs out
+ *@param fileName - path of the card file
+ *@param buffer - caller-owned buffer
+ *@param size - size of buffer
+ **/
+int getPropertiesFromFileInto(char* fileName, char* buffer, int size);
+
+#endif
@@ -14,14 +14,21 @@
 #define TRUE 1
 #define FALSE 0
 
-//*****************************************************************
-VCardErrorCode readProperty(FILE* fp, char** line);
+// Growable string used when building large outputs, to avoid realloc/strcat per piece
+typedef struct stringBuffer {
+    char*   str;
+    size_t  length;
+    size_t  capacity;
+} StringBuffer;
 
-VCardErrorCode divideProperty(char* line, char** groupName, char** propertyName, char** parameterValue, char** propertyValue);
+//*****************************************************************
+VCardErrorCode readCard(FILE* fp, Card** newCardObject);
 
 VCardErrorCode createProperty(Property** newProperty);
 
-VCardErrorCode createParameter(Parameter** newParameter, char* theValue);
+VCardErrorCode createParameter(Parameter** newParameter, const char* theName, const char* theValue);
+
+void setDateKeys(DateTime* dateTime);
 
 VCardErrorCode createDateTime(DateTime** newDateTime, char* parameterValue, char* propertyValue);
 
@@ -36,6 +43,34 @@ int replaceString(char** toReplace, char* toCopy);
 char* strTokenizer(char* str, char delimiter);
 
 int stricasecmp(const char* s1, const char* s2);
+
+unsigned long long hashString(const char* str);
+
+bool hasCardExtension(const char* fileName);
+
+char* escapeJSON(const char* str);
+
+bool initStringBuffer(StringBuffer* buffer);
+
+bool appendString(StringBuffer* buffer, const char* str);
+
+bool appendJSONString(StringBuffer* buffer, const char* str);
+
+VCardErrorCode summarizeFile(const char* fileName, char** name, int* opLength, bool* isInvalid);
+
+VCardErrorCode summarizeFileLevel(const char* fileName, ValidationLevel level, char** name, int* opLength, bool* isInvalid);
+
+char* summaryToJSON(const char* fileName, const char* name, int opLength);
+
+char* summaryErrorToJSON(const char* fileName, bool isInvalid);
+
+bool appendSummaryJSON(StringBuffer* buffer, const char* fileName, const char* name, int opLength);
+
+bool appendSummaryError(StringBuffer* buffer, const char* fileName, bool isInvalid);
+
+bool appendPropertyEntry(StringBuffer* buffer, int number, const Property* prop);
+
+VCardErrorCode writeCardToStream(FILE* fp, const Card* obj);
 //*****************************************************************
 
 #endif
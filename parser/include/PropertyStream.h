@@ -0,0 +1,69 @@
+/**
+ * @file PropertyStream.h
+ * @author Joshua Sarabdial
+ * @date October 2026
+ * @brief A card's property listing produced in bounded chunks
+ **/
+
+#ifndef _PROPERTYSTREAM_H
+#define _PROPERTYSTREAM_H
+
+#include "VCardParser.h"
+#include "ParserFunctions.h"
+#include "LazyCard.h"
+
+/*  Produces the JSON array getPropertiesRange lists, for every property, a chunk at a
+    time.  Properties are built lazily as each chunk is requested, so a caller can send
+    the first bytes before the last property has been built.
+*/
+typedef struct propertyStream {
+    // NULL if the card could not be created or is invalid; the only chunk is then the error text
+    LazyCard*       card;
+    char*           fileName;
+    bool            isInvalid;
+
+    // Index of the next property to write, and whether the closing ']' has been written
+    int             next;
+    bool            isDone;
+
+    // Set when a property could not be built, which ends the listing before its ']'
+    bool            isFailed;
+
+    // Text of the last chunk
+    StringBuffer    chunk;
+} PropertyStream;
+
+/** Function to open a property stream over a card file.
+ *@return a newly allocated PropertyStream, or NULL if memory runs out
+ *@param fileName - path of the card file
+ **/
+PropertyStream* openPropertyStream(char* fileName);
+
+/** Function to produce the next chunk of the listing.  A chunk holds whole properties and ends
+ *  at the first property boundary at or past maxBytes; the first starts with '[' and the last ends with ']'.
+ *  For a card that cannot be listed the only chunk is the error text getPropertiesFromFile returns.
+ *@return the chunk, owned by stream and valid until the next call, or "" once the listing is complete
+ *@param stream - a pointer to a PropertyStream
+ *@param maxBytes - preferred chunk size
+ **/
+const char* nextPropertyChunk(PropertyStream* stream, int maxBytes);
+
+/** Function to tell whether a listing ended because a property could not be built.  The chunks
+ *  already produced are then an unfinished array, and a response carrying them should be aborted.
+ *@return true if nextPropertyChunk returned "" before the listing was complete
+ *@param stream - a pointer to a PropertyStream
+ **/
+bool isPropertyStreamFailed(PropertyStream* stream);
+
+/** Function to produce a card's whole listing at once, as the chunks of a property stream joined together.
+ *@return newly allocated listing or error text, or NULL if memory runs out
+ *@param fileName - path of the card file
+ **/
+char* listProperties(char* fileName);
+
+/** Function to free a property stream.  Safe to call with NULL.
+ *@param stream - a pointer to a PropertyStream
+ **/
+void closePropertyStream(PropertyStream* stream);
+
+#endif
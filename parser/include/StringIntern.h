@@ -0,0 +1,34 @@
+/**
+ * @file StringIntern.h
+ * @author Joshua Sarabdial
+ * @date October 2026
+ * @brief Shared copies of the property and parameter names vCard defines
+ **/
+
+#ifndef _STRINGINTERN_H
+#define _STRINGINTERN_H
+
+#include "VCardParser.h"
+
+/*  Property names, group names and parameter names go through internName.  A name
+    vCard defines, spelled as the RFCs spell it, is shared from a fixed table, so
+    most cards allocate nothing for their names.  Any other name, such as an X-
+    property or a group, is copied, since names come from uploaded files and a table
+    of them would only grow.  Either way the name is released with releaseName.
+    Both functions are safe to call from several threads at once.
+*/
+
+/** Function to get a name to keep in a Property or Parameter.
+ *@post the result must be released with releaseName, not free
+ *@return the shared copy of a known name, a new copy of any other, or NULL if str is NULL or memory runs out
+ *@param str - name to keep
+ **/
+const char* internName(const char* str);
+
+/** Function to release a name returned by internName.
+ *@post a copied name is freed; a shared one is left alone
+ *@param name - name from internName, or NULL
+ **/
+void releaseName(const char* name);
+
+#endif
@@ -0,0 +1,115 @@
+/**
+ * @file SummaryIndex.h
+ * @author Joshua Sarabdial
+ * @date October 2026
+ * @brief Persistent, memory-mapped index of per-file card summaries
+ **/
+
+#ifndef _SUMMARYINDEX_H
+#define _SUMMARYINDEX_H
+
+#include "VCardParser.h"
+
+/*  Opaque handle to an open summary index.
+    The index file holds one record per card file (file name, FN, property count,
+    mtime, size and the result of the last parse/validation) in an open-addressed
+    hash table, followed by a string heap.  It is mapped with MAP_SHARED, so updates
+    are persisted by the kernel without explicit writes.
+
+    Several processes may open the same index, for example the workers of a cluster, and
+    share its records.  Every access holds a flock on "<indexFile>.lock", and a process
+    remaps the file when another one has grown and replaced it.  A handle itself must be
+    used by one thread at a time.
+*/
+typedef struct summaryIndex SummaryIndex;
+
+/** Function to open (or create) a summary index file and map it into memory.
+ *@pre indexFile is not NULL
+ *@post the index file exists and is mapped.  No card files are parsed.
+ *@return a newly allocated SummaryIndex, or NULL if the file could not be opened or mapped
+ *@param indexFile - path of the on-disk index
+ **/
+SummaryIndex* openSummaryIndex(const char* indexFile);
+
+/** Function to unmap and close a summary index.  Safe to call with NULL.
+ *@param index - a pointer to a SummaryIndex
+ **/
+void closeSummaryIndex(SummaryIndex* index);
+
+/** Function to get the JSON summary of a card file through the index.
+ *  The stored record is used when the file's mtime and size still match; otherwise
+ *  the file is re-parsed and the record is updated in place.
+ *@pre fileName is not NULL
+ *@post the record for fileName is current
+ *@return newly allocated string in the same format as getSummaryFromFile
+ *@param index - a pointer to a SummaryIndex.  If NULL, falls back to getSummaryFromFile.
+ *@param fileName - path of the card file
+ **/
+char* getSummaryFromIndex(SummaryIndex* index, char* fileName);
+
+/** Function to get the summary of a card file through the index, as its parts rather than JSON.
+ *  The stored record is used when it is current; otherwise the file is re-parsed and the record is updated.
+ *@pre fileName is not NULL
+ *@post the record for fileName is current.  name is newly allocated if OK is returned, and NULL otherwise.
+ *@return OK, or the error the card's summary failed with
+ *@param index - a pointer to a SummaryIndex.  If NULL, falls back to summarizeFile.
+ *@param fileName - path of the card file
+ *@param name - set to the card's FN
+ *@param opLength - set to the number of optional properties
+ *@param isInvalid - set to whether a failure came from validateCard
+ **/
+VCardErrorCode getIndexedSummary(SummaryIndex* index, char* fileName, char** name, int* opLength, bool* isInvalid);
+
+/** Function to bring the records of many card files up to date at once.  Files whose records
+ *  are current are not read; the rest are parsed in parallel and stored under one lock.
+ *@pre files holds count paths, as listCardFiles gives them
+ *@post every file that could be stat'd has a record matching what was stat'd
+ *@return OK, or OTHER_ERROR if the index cannot be locked or memory runs out
+ *@param index - a pointer to a SummaryIndex
+ *@param files - paths of the card files
+ *@param count - number of paths in files
+ *@param level - validation level for the files parsed, as summarizeFileLevel takes.  VALIDATE_TRUSTED is settled per file.
+ **/
+VCardErrorCode refreshSummaryIndex(SummaryIndex* index, char** files, int count, ValidationLevel level);
+
+/** Function to get a card's full property listing through the index.
+ *  The listing is cached with the file's summary and rebuilt when the file's mtime or size changes.
+ *@pre fileName is not NULL
+ *@post the record for fileName is current and holds the listing if the card is valid
+ *@return newly allocated string in the same format as listProperties
+ *@param index - a pointer to a SummaryIndex.  If NULL, falls back to listProperties.
+ *@param fileName - path of the card file
+ **/
+char* getPropertiesFromIndex(SummaryIndex* index, char* fileName);
+
+/** Function to parse and validate an upload from memory and record its summary before it is written.
+ *  The data must be compressed as fileName's extension says, since that is how the file will be read.
+ *  The record is keyed by fileName and stays pending, matching no file, until confirmUploadSummary
+ *  is called once the upload has been written.
+ *@pre fileName is not NULL, data points to at least len bytes
+ *@post if the card is valid and index is not NULL, a pending record for fileName has been stored
+ *@return newly allocated string in the same format as getSummaryFromFile
+ *@param index - a pointer to a SummaryIndex.  May be NULL, in which case nothing is recorded.
+ *@param fileName - path the upload will be written to
+ *@param data - the uploaded bytes
+ *@param len - number of bytes in data
+ **/
+char* getSummaryFromBuffer(SummaryIndex* index, char* fileName, const char* data, size_t len);
+
+/** Function to confirm that an upload recorded by getSummaryFromBuffer has been written.
+ *  The pending record takes the file's mtime, so later lookups use it without parsing.
+ *@pre the upload has been written to fileName in full
+ *@post the record for fileName is current if it was pending and the file has the upload's size
+ *@return OK, INV_FILE if the file is missing or no pending record matches it, or OTHER_ERROR
+ *@param index - a pointer to a SummaryIndex
+ *@param fileName - path the upload was written to, as given to getSummaryFromBuffer
+ **/
+VCardErrorCode confirmUploadSummary(SummaryIndex* index, char* fileName);
+
+/** Function to get the number of records held by a summary index.
+ *@return number of records, or -1 if index is NULL
+ *@param index - a pointer to a SummaryIndex
+ **/
+int getSummaryIndexCount(SummaryIndex* index);
+
+#endif
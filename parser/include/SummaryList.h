@@ -0,0 +1,88 @@
+/**
+ * @file SummaryList.h
+ * @author Joshua Sarabdial
+ * @date October 2026
+ * @brief Card summaries of a directory, presorted by name, file and property count for paging
+ **/
+
+#ifndef _SUMMARYLIST_H
+#define _SUMMARYLIST_H
+
+#include "VCardParser.h"
+#include "SummaryIndex.h"
+
+// One valid card's summary
+typedef struct summaryEntry {
+    // Path as listed, such as uploads/name.vcf
+    char*               file;
+    char*               name;
+    int                 opLength;
+
+    // FN folded to lower case, and its first 8 bytes as a big-endian integer, so most
+    // comparisons are one integer compare and never reach the strings
+    char*               key;
+    unsigned long long  keyPrefix;
+} SummaryEntry;
+
+/*  Summaries of every valid card in a directory.  Entries are kept in file name order,
+    with two orders over them computed when the list is built and kept sorted as files
+    change, so a page in any order is a slice of an array.  Names compare by their folded
+    keys, ASCII and Latin-1 letters without regard to case; ties fall back to file name
+    order, so pages are stable.  updateSummaryList changes a list in place, so it must
+    not run while another thread reads the list.
+*/
+typedef struct summaryList {
+    // Card files listed, and those of them that did not summarize, in file name order
+    int             fileCount;
+    int             invalidCount;
+    char**          invalidFiles;
+
+    int             count;
+    SummaryEntry*   entries;
+
+    // Entry indices by name, and by property count then name
+    int*            byName;
+    int*            byCount;
+} SummaryList;
+
+/** Function to summarize every card in a directory and sort the summaries.  Summaries come from
+ *  the summary index where its records are current; other files are summarized in parallel.
+ *@pre dirName is not NULL
+ *@post the index's records of the directory's files are current, if it could be opened
+ *@return a newly allocated SummaryList, or NULL if the directory cannot be read or memory runs out
+ *@param dirName - directory of card files
+ *@param indexFile - path of the summary index, opened for the build alone.  If NULL or it cannot
+ *       be opened, every file is summarized.
+ *@param level - validation level for each card, as summarizeFileLevel takes.  VALIDATE_TRUSTED is settled per file.
+ **/
+SummaryList* buildSummaryList(char* dirName, char* indexFile, ValidationLevel level);
+
+/** Function to bring a list up to date after one card file was written, replaced or removed.
+ *  Only that file is summarized, through the index, and its entry is moved into place in each order.
+ *@pre fileName is given as listCardFiles gives it, such as uploads/name.vcf
+ *@post the list describes fileName as it is now.  If memory runs out, the file may be left out.
+ *@return OK, or OTHER_ERROR if list or fileName is NULL or memory runs out
+ *@param list - a pointer to a SummaryList
+ *@param index - a pointer to a SummaryIndex.  If NULL, the file is summarized directly.
+ *@param fileName - path of the card file
+ **/
+VCardErrorCode updateSummaryList(SummaryList* list, SummaryIndex* index, char* fileName);
+
+/** Function to free a SummaryList.  Safe to call with NULL.
+ *@param list - a pointer to a SummaryList
+ **/
+void freeSummaryList(SummaryList* list);
+
+/** Function to get one page of summaries in a given order.
+ *@return newly allocated JSON of the form {"total":N,"invalid":N,"offset":N,"summaries":[...]}, each
+ *        summary as getSummaryFromFile gives it, or {"total":0,"invalid":0,"offset":0,"summaries":[]}
+ *        if list is NULL
+ *@param list - a pointer to a SummaryList
+ *@param sort - "name", "file" or "count".  Anything else sorts by name.
+ *@param offset - number of summaries to skip
+ *@param limit - most summaries to return
+ *@param isDescending - whether to walk the order from its end
+ **/
+char* getSummaryPage(SummaryList* list, char* sort, int offset, int limit, bool isDescending);
+
+#endif
@@ -10,6 +10,9 @@
 
 typedef enum ers {OK, INV_FILE, INV_CARD, INV_PROP, INV_DT, WRITE_ERROR, OTHER_ERROR } VCardErrorCode;
 
+// How much checking a read applies (see validateCardLevel)
+typedef enum vl { VALIDATE_NONE, VALIDATE_STRUCTURAL, VALIDATE_STRICT, VALIDATE_TRUSTED } ValidationLevel;
+
 /*	Represents vCard Date-time, needed for date-related properties, i.e. birthday and anniversary
 	We assume that the type of date-related parameters is either unspecified or is "date-and-or-time"
 */
@@ -29,6 +32,12 @@ typedef struct dt {
 	//Must be an empty string if DateTime is text, 
 	//or if the time portion of the date-and-or-time is unspecificed
 	char 	time[7]; 
+
+	//Numeric keys derived from date, for sorting and range queries.  Both are 0 if unknown.
+	//monthDay is MMDD, e.g. 415 for April 15, set for YYYYMMDD and --MMDD dates.
+	//fullDate is YYYYMMDD, set only when the year is present.
+	int		monthDay;
+	int		fullDate;
 	
 	//Text value for the DateTime. Must be an empty string if DateTime is not text
 	//We use a C99 flexible array member, which we will discuss in class.
@@ -39,8 +48,8 @@ typedef struct dt {
 
 //Represents a generic vCard parameter
 typedef struct param {
-	//Parameter name.  We will assume that the parameter name, even if malformed, does not exceed 200 bytes
-	char 	name[200]; 
+	//Parameter name, from internName (see StringIntern.h).  Released by deleteParameter.
+	const char*	name; 
 
 	//Property description.  
 	char	value[]; 
@@ -50,11 +59,11 @@ typedef struct param {
 
 //Represents a generic vCard property
 typedef struct prop {
-	//Property name.  Must not be empty string.  Must not be NULL.
-	char* 		name; 
+	//Property name.  Must not be empty string.  Must not be NULL.  From internName, and released by deleteProperty.
+	const char*	name; 
 
-	//Group name.  Groups are optional, so this may be an empty string.  Must not be NULL.
-	char* 		group;
+	//Group name.  Groups are optional, so this may be an empty string.  Must not be NULL.  From internName, and released by deleteProperty.
+	const char*	group;
 
 	/* 	List of property parameters.  All objects in the list will be of type Parameter.
 		List may be empty if property parameters are absent.  List must never be NULL.  
@@ -230,6 +239,61 @@ char* getSummaryFromFile(char* fileName);
 
 char* getPropertiesFromFile(char* fileName);
 
+/** Function to check a card as far as a validation level asks.
+ *  VALIDATE_NONE accepts any card the parser built.  VALIDATE_STRUCTURAL applies only the rules
+ *  validateCard reports as INV_CARD: FN is present, and BEGIN, END and VERSION do not appear
+ *  among the optional properties.  VALIDATE_STRICT, and VALIDATE_TRUSTED since there is no file
+ *  to check for a trusted marker, apply every rule of validateCard.
+ *@return OK, or the error validateCard would return for a rule the level applies
+ *@param obj - a pointer to a Card struct
+ *@param level - the validation level
+ **/
+VCardErrorCode validateCardLevel(const Card* obj, ValidationLevel level);
+
+/** Function to summarize a card file as getSummaryFromFile does, validating it only as far as level asks.
+ *  With VALIDATE_TRUSTED the card is not validated if markCardTrusted recorded it, and is validated strictly otherwise.
+ *@return newly allocated summary, or an error message as getSummaryFromFile gives
+ *@param fileName - path of the card file
+ *@param level - the validation level; VALIDATE_STRICT gives getSummaryFromFile's result
+ **/
+char* getSummaryFromFileLevel(char* fileName, ValidationLevel level);
+
+/** Function to list a card file's properties as getPropertiesFromFile does, validating it only as far as level asks.
+ *  With VALIDATE_TRUSTED the card is not validated if markCardTrusted recorded it, and is validated strictly otherwise.
+ *@return newly allocated property list, or an error message as getPropertiesFromFile gives
+ *@param fileName - path of the card file
+ *@param level - the validation level; VALIDATE_STRICT gives getPropertiesFromFile's result
+ **/
+char* getPropertiesFromFileLevel(char* fileName, ValidationLevel level);
+
+/** Function to get one page of a card's properties as JSON.
+ *  Properties are numbered as in getPropertiesFromFile, with FN always first.  The whole
+ *  file is scanned to count and check properties, but only those in the page are built.
+ *@pre fileName is not NULL
+ *@return newly allocated string {"total":N,"offset":offset,"properties":[...]}, or an error
+ *        message in the same form as getPropertiesFromFile
+ *@param fileName - path of the card file
+ *@param offset - index of the first property to return, where FN is 0
+ *@param limit - maximum number of properties to return
+ **/
+char* getPropertiesRange(char* fileName, int offset, int limit);
+
+/** Function to create a Card object from an in-memory vCard, e.g. an upload that has not been written to disk.
+ *@pre data points to at least len bytes
+ *@post data has not been modified in any way, and a Card has been created
+ *@return the error code indicating success or the error encountered when parsing the card
+ *@param data - the contents of a .vcf file, or of a gzip or zstd compressed one
+ *@param len - number of bytes in data
+ *@param newCardObject - a pointer to a Card pointer
+ **/
+VCardErrorCode createCardFromBuffer(const char* data, size_t len, Card** newCardObject);
+
+/** Function to free a string returned by any of the library's allocating functions.
+ *  Lets callers that cannot use free directly, such as ffi bindings, release results.  Safe to call with NULL.
+ *@param result - string returned by the library
+ **/
+void freeResult(char* result);
+
 char* valuesToJSON(const List* strList);
 
 #endif	
@@ -0,0 +1,80 @@
+/**
+ * @file ValueDecode.h
+ * @author Joshua Sarabdial
+ * @date October 2026
+ * @brief Base64 and quoted-printable decoding of inline property values
+ **/
+
+#ifndef _VALUEDECODE_H
+#define _VALUEDECODE_H
+
+#include "VCardParser.h"
+
+// How a property value is encoded
+typedef enum ve { VALUE_TEXT, VALUE_BASE64, VALUE_QUOTED_PRINTABLE } ValueEncoding;
+
+/*  Decodes a value that arrives in runs, such as the pieces between a content line's
+    folds.  Base64 is decoded 32 characters at a time with AVX2 where the processor has
+    it, and one character at a time otherwise.  Characters that are not base64 digits,
+    such as whitespace, are skipped, and '=' ends the data.  In quoted-printable, "=XX"
+    is decoded and any other '=' is kept as it is.
+*/
+typedef struct valueDecoder {
+    ValueEncoding   encoding;
+
+    // Base64 bits not yet written, and whether padding has been seen
+    unsigned int    bits;
+    int             bitCount;
+    bool            isDone;
+
+    // Quoted-printable "=" or "=X" left at the end of the last run
+    char            pending[2];
+    int             pendingCount;
+} ValueDecoder;
+
+// Room decodeValueRun needs for a run of length characters
+#define DECODED_SIZE(length) ((length) + 3)
+
+/** Function to initialize a decoder.
+ *@param decoder - a pointer to the ValueDecoder
+ *@param encoding - the value's encoding
+ **/
+void initValueDecoder(ValueDecoder* decoder, ValueEncoding encoding);
+
+/** Function to decode the next run of a value.
+ *@pre out has room for DECODED_SIZE(length) bytes
+ *@return number of bytes written to out
+ *@param decoder - a pointer to the ValueDecoder
+ *@param in - the run's characters
+ *@param length - number of characters in the run
+ *@param out - receives the decoded bytes
+ **/
+size_t decodeValueRun(ValueDecoder* decoder, const char* in, size_t length, unsigned char* out);
+
+/** Function to end a value, writing whatever an incomplete quoted-printable escape left pending.
+ *@pre out has room for 2 bytes
+ *@return number of bytes written to out
+ *@param decoder - a pointer to the ValueDecoder
+ *@param out - receives the remaining bytes
+ **/
+size_t finishValueDecoder(ValueDecoder* decoder, unsigned char* out);
+
+/** Function to decode a whole base64 string.
+ *@pre out has room for DECODED_SIZE(length) bytes
+ *@return number of bytes written to out
+ **/
+size_t decodeBase64(const char* in, size_t length, unsigned char* out);
+
+/** Function to decode a whole quoted-printable string.
+ *@pre out has room for DECODED_SIZE(length) bytes
+ *@return number of bytes written to out
+ **/
+size_t decodeQuotedPrintable(const char* in, size_t length, unsigned char* out);
+
+/** Function to get the encoding a property's ENCODING parameter gives.
+ *@return VALUE_BASE64 for b or BASE64, VALUE_QUOTED_PRINTABLE for QUOTED-PRINTABLE, otherwise VALUE_TEXT
+ *@param prop - a pointer to a Property
+ **/
+ValueEncoding getValueEncoding(const Property* prop);
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ * @file ValueStream.h
+ * @author Joshua Sarabdial
+ * @date October 2026
+ * @brief A property's value read and decoded from the card file on demand
+ **/
+
+#ifndef _VALUESTREAM_H
+#define _VALUESTREAM_H
+
+#include "VCardParser.h"
+#include "ParserFunctions.h"
+#include "LazyCard.h"
+#include "ValueDecode.h"
+
+/*  Reads one property's value a window at a time, from the card's bytes or, for a large
+    value the card left in the file, from the file itself, unfolding it into a small
+    staging buffer and decoding it from there, so a multi-megabyte PHOTO is never held in
+    memory whole.  A value is base64 when its property has ENCODING=b or BASE64, or when it is
+    a data: URI marked ";base64", and quoted-printable when it has ENCODING=QUOTED-PRINTABLE;
+    any other value is read as it appears in the file.
+*/
+typedef struct valueStream {
+    // NULL if the card could not be created, is invalid or has no such property
+    LazyCard*       card;
+
+    // Media type of the decoded value
+    char*           mediaType;
+
+    // Where the raw value is read from: the card file, or a stream over the card's bytes.
+    // NULL for an empty value.
+    FILE*           source;
+
+    // Raw bytes of the value still to read, as offsets from its start
+    long            position;
+    long            end;
+
+    // Raw bytes read from source, the first of them at windowStart
+    char*           window;
+    long            windowStart;
+    long            windowLength;
+
+    ValueDecoder    decoder;
+    bool            isFinished;
+
+    // Unfolded characters waiting to be decoded
+    char*           staging;
+
+    // Text of the last error
+    StringBuffer    error;
+} ValueStream;
+
+/** Function to open a stream over a property's value.
+ *@return a newly allocated ValueStream, or NULL if memory runs out
+ *@param fileName - path of the card file
+ *@param name - property whose first value is read when number is 0, such as "PHOTO"
+ *@param number - the property's number in getPropertiesRange's listing, or 0
+ **/
+ValueStream* openValueStream(char* fileName, const char* name, int number);
+
+/** Function to get the media type of a stream's value.  A type the card gives is kept only
+ *  if it is an image, audio or application type that browsers do not run as a page or
+ *  script; any other becomes application/octet-stream.  Values without a type are
+ *  text/plain, or application/octet-stream if they are encoded.
+ *@return the media type, or "" if the stream has no value.  Owned by stream.
+ *@param stream - a pointer to a ValueStream
+ **/
+const char* getValueMediaType(ValueStream* stream);
+
+/** Function to get why a stream has no value.
+ *@return error text in the form getPropertiesFromFile uses, or "" if the stream has a value.  Owned by stream.
+ *@param stream - a pointer to a ValueStream
+ **/
+const char* getValueError(ValueStream* stream);
+
+/** Function to read the next decoded bytes of a value.
+ *@return number of bytes written to buffer, 0 once the value is complete, or -1 if the stream has no value
+ *@param stream - a pointer to a ValueStream
+ *@param buffer - receives up to size bytes
+ *@param size - size of buffer, at least 4
+ **/
+int readValueChunk(ValueStream* stream, char* buffer, int size);
+
+/** Function to free a value stream.  Safe to call with NULL.
+ *@param stream - a pointer to a ValueStream
+ **/
+void closeValueStream(ValueStream* stream);
+
+#endif
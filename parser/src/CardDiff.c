@@ -0,0 +1,966 @@
+/**
+ * @file CardDiff.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#define _DEFAULT_SOURCE
+
+#include <unistd.h>
+
+#include "CardDiff.h"
+#include "CardExport.h"
+#include "CardFingerprint.h"
+#include "CardTrust.h"
+#include "CompressedStream.h"
+#include "ParserFunctions.h"
+#include "StringIntern.h"
+
+// An optional property of a card being diffed or patched, with its hashes
+typedef struct propertySlot {
+    Property*           prop;
+    Node*               node;
+    unsigned long long  key;
+    unsigned long long  full;
+    // Index of the slot it was paired with in the other card, or -1
+    int                 match;
+} PropertySlot;
+
+/*********************************** Copies and comparisons ***********************************/
+
+static Property* copyProperty(const Property* prop) {
+    Property* copy = NULL;
+    Parameter* param;
+    Parameter* paramCopy;
+    ListIterator iter;
+    char* value;
+    char* valueCopy;
+
+    if (createProperty(&copy) != OK) {
+        deleteProperty(copy);
+        return NULL;
+    }
+    copy->name = internName(prop->name);
+    copy->group = internName(prop->group);
+    if (copy->name == NULL || copy->group == NULL) {
+        deleteProperty(copy);
+        return NULL;
+    }
+
+    iter = createIterator(prop->parameters);
+    while ((param = nextElement(&iter)) != NULL) {
+        if (createParameter(&paramCopy, param->name, param->value) != OK) {
+            deleteProperty(copy);
+            return NULL;
+        }
+        insertBack(copy->parameters, paramCopy);
+    }
+    iter = createIterator(prop->values);
+    while ((value = nextElement(&iter)) != NULL) {
+        if (!(valueCopy = duplicateString(value))) {
+            deleteProperty(copy);
+            return NULL;
+        }
+        insertBack(copy->values, valueCopy);
+    }
+    return copy;
+}
+
+static DateTime* copyDate(const DateTime* date) {
+    DateTime* copy;
+    size_t size = sizeof(DateTime) + strlen(date->text) + 1;
+
+    if (!(copy = malloc(size))) return NULL;
+    memcpy(copy, date, size);
+    return copy;
+}
+
+static bool isSameDate(const DateTime* one, const DateTime* two) {
+    if (one == NULL || two == NULL) return one == two;
+
+    return one->UTC == two->UTC && one->isText == two->isText && strcmp(one->date, two->date) == 0
+            && strcmp(one->time, two->time) == 0 && strcmp(one->text, two->text) == 0;
+}
+
+/* Lists a card's optional properties with their key and full fingerprints. */
+static PropertySlot* collectSlots(const List* properties, int* count) {
+    PropertySlot* slots;
+    Node* node;
+    int i = 0;
+
+    *count = getLength((List*) properties);
+    if (!(slots = malloc(sizeof(PropertySlot) * (*count + 1)))) return NULL;
+
+    for (node = properties->head; node != NULL; node = node->next, i++) {
+        slots[i].prop = (Property*) node->data;
+        slots[i].node = node;
+        slots[i].key = fingerprintPropertyKey(slots[i].prop);
+        slots[i].full = fingerprintProperty(slots[i].prop);
+        slots[i].match = -1;
+    }
+    return slots;
+}
+
+static PropertyChange* createChange(ChangeKind kind, const Property* old, const Property* property) {
+    PropertyChange* change;
+
+    if (!(change = calloc(1, sizeof(PropertyChange)))) return NULL;
+    change->kind = kind;
+    if (old != NULL) {
+        change->target = fingerprintProperty(old);
+        if (!(change->name = internName(old->name))) {
+            free(change);
+            return NULL;
+        }
+    }
+    if (property != NULL && !(change->property = copyProperty(property))) {
+        releaseName(change->name);
+        free(change);
+        return NULL;
+    }
+    return change;
+}
+
+static void deleteChange(void* toBeDeleted) {
+    PropertyChange* change = (PropertyChange*) toBeDeleted;
+
+    if (change == NULL) return;
+
+    deleteProperty(change->property);
+    releaseName(change->name);
+    free(change);
+}
+
+static char* printChange(void* toBePrinted) {
+    PropertyChange* change = (PropertyChange*) toBePrinted;
+    const char* ops[] = { "add", "remove", "replace" };
+    char* text;
+
+    if (change == NULL) return NULL;
+    if (!(text = malloc(sizeof(char) * (strlen(ops[change->kind]) + 20)))) return NULL;
+    sprintf(text, "%s %016llx", ops[change->kind], change->target);
+
+    return text;
+}
+
+static int compareChanges(const void* first, const void* second) {
+    const PropertyChange* changeOne = (const PropertyChange*) first;
+    const PropertyChange* changeTwo = (const PropertyChange*) second;
+
+    return (changeOne->target > changeTwo->target) - (changeOne->target < changeTwo->target);
+}
+
+static CardDiff* createCardDiff(void) {
+    CardDiff* diff;
+
+    if (!(diff = calloc(1, sizeof(CardDiff)))) return NULL;
+    if (!(diff->changes = initializeList(printChange, deleteChange, compareChanges))) {
+        free(diff);
+        return NULL;
+    }
+    return diff;
+}
+
+void deleteCardDiff(CardDiff* diff) {
+    if (diff == NULL) return;
+
+    freeList(diff->changes);
+    deleteProperty(diff->fn);
+    deleteDate(diff->birthday);
+    deleteDate(diff->anniversary);
+    free(diff);
+}
+
+int getCardDiffLength(const CardDiff* diff) {
+    if (diff == NULL) return 0;
+
+    return getLength(diff->changes) + (diff->fn != NULL) + diff->isBirthdayChanged + diff->isAnniversaryChanged;
+}
+
+/*********************************** Diff ***********************************/
+
+/* Pairs each new slot with the first unpaired old slot whose hash (key or full) is equal. */
+static void pairSlots(PropertySlot* from, int fromCount, PropertySlot* to, int toCount, bool isByKey) {
+    for (int j = 0; j < toCount; j++) {
+        if (to[j].match != -1) continue;
+        for (int i = 0; i < fromCount; i++) {
+            if (from[i].match == -1 && (isByKey ? from[i].key == to[j].key
+                    : from[i].full == to[j].full && from[i].key == to[j].key)) {
+                from[i].match = j;
+                to[j].match = i;
+                break;
+            }
+        }
+    }
+}
+
+/* Sets a date change if the dates differ. */
+static bool diffDate(const DateTime* from, const DateTime* to, bool* isChanged, DateTime** date) {
+    if (isSameDate(from, to)) return true;
+
+    *isChanged = true;
+    return to == NULL || (*date = copyDate(to)) != NULL;
+}
+
+VCardErrorCode diffCards(const Card* from, const Card* to, CardDiff** diff) {
+    PropertySlot* fromSlots = NULL;
+    PropertySlot* toSlots = NULL;
+    PropertyChange* change;
+    int fromCount;
+    int toCount;
+    bool isComplete;
+
+    *diff = NULL;
+    if (from == NULL || to == NULL) return OTHER_ERROR;
+    if (!(*diff = createCardDiff())) return OTHER_ERROR;
+
+    fromSlots = collectSlots(from->optionalProperties, &fromCount);
+    toSlots = collectSlots(to->optionalProperties, &toCount);
+    isComplete = fromSlots != NULL && toSlots != NULL;
+
+    if (isComplete) {
+        // Identical properties first, so a changed value is only paired with what is left
+        pairSlots(fromSlots, fromCount, toSlots, toCount, false);
+        for (int i = 0; i < fromCount; i++) {
+            if (fromSlots[i].match != -1) fromSlots[i].match = -2;
+        }
+        for (int j = 0; j < toCount; j++) {
+            if (toSlots[j].match != -1) toSlots[j].match = -2;
+        }
+        pairSlots(fromSlots, fromCount, toSlots, toCount, true);
+    }
+
+    // Removals and replacements in the old card's order, then additions in the new card's
+    for (int i = 0; isComplete && i < fromCount; i++) {
+        if (fromSlots[i].match == -2) continue;
+
+        change = fromSlots[i].match == -1 ? createChange(CHANGE_REMOVE, fromSlots[i].prop, NULL)
+                : createChange(CHANGE_REPLACE, fromSlots[i].prop, toSlots[fromSlots[i].match].prop);
+        if (!(isComplete = change != NULL)) break;
+        insertBack((*diff)->changes, change);
+    }
+    for (int j = 0; isComplete && j < toCount; j++) {
+        if (toSlots[j].match != -1) continue;
+
+        if (!(isComplete = (change = createChange(CHANGE_ADD, NULL, toSlots[j].prop)) != NULL)) break;
+        insertBack((*diff)->changes, change);
+    }
+
+    if (isComplete && fingerprintProperty(from->fn) != fingerprintProperty(to->fn))
+        isComplete = ((*diff)->fn = copyProperty(to->fn)) != NULL;
+    isComplete = isComplete && diffDate(from->birthday, to->birthday, &(*diff)->isBirthdayChanged, &(*diff)->birthday)
+            && diffDate(from->anniversary, to->anniversary, &(*diff)->isAnniversaryChanged, &(*diff)->anniversary);
+
+    free(fromSlots);
+    free(toSlots);
+    if (!isComplete) {
+        deleteCardDiff(*diff);
+        *diff = NULL;
+        return OTHER_ERROR;
+    }
+    return OK;
+}
+
+/*********************************** Patch ***********************************/
+
+static void unlinkNode(List* list, Node* node) {
+    if (node->previous != NULL) node->previous->next = node->next;
+    else list->head = node->next;
+
+    if (node->next != NULL) node->next->previous = node->previous;
+    else list->tail = node->previous;
+
+    list->length--;
+    free(node);
+}
+
+VCardErrorCode applyCardDiff(Card* obj, const CardDiff* diff) {
+    PropertySlot* slots;
+    PropertyChange* change;
+    ListIterator iter;
+    Property** copies;
+    int* targets;
+    int changeCount;
+    int slotCount;
+    int n = 0;
+    Property* fn = NULL;
+    DateTime* birthday = NULL;
+    DateTime* anniversary = NULL;
+    VCardErrorCode err = OK;
+
+    if (obj == NULL || diff == NULL) return OTHER_ERROR;
+
+    changeCount = getLength(diff->changes);
+    slots = collectSlots(obj->optionalProperties, &slotCount);
+    copies = calloc(changeCount + 1, sizeof(Property*));
+    targets = malloc(sizeof(int) * (changeCount + 1));
+    if (!slots || !copies || !targets) err = OTHER_ERROR;
+
+    // Locate every target and copy every new value before the card is touched
+    iter = createIterator(diff->changes);
+    while (err == OK && (change = nextElement(&iter)) != NULL) {
+        targets[n] = -1;
+        if (change->kind != CHANGE_ADD) {
+            for (int i = 0; i < slotCount && targets[n] == -1; i++) {
+                if (slots[i].match == -1 && slots[i].full == change->target) {
+                    slots[i].match = n;
+                    targets[n] = i;
+                }
+            }
+            if (targets[n] == -1) err = INV_PROP;
+        }
+        if (err == OK && change->kind != CHANGE_REMOVE && !(copies[n] = copyProperty(change->property)))
+            err = OTHER_ERROR;
+        n++;
+    }
+    if (err == OK && diff->fn && !(fn = copyProperty(diff->fn))) err = OTHER_ERROR;
+    if (err == OK && diff->birthday && !(birthday = copyDate(diff->birthday))) err = OTHER_ERROR;
+    if (err == OK && diff->anniversary && !(anniversary = copyDate(diff->anniversary))) err = OTHER_ERROR;
+
+    if (err != OK) {
+        for (int i = 0; i < n; i++)
+            deleteProperty(copies[i]);
+        deleteProperty(fn);
+        deleteDate(birthday);
+        deleteDate(anniversary);
+        free(slots);
+        free(copies);
+        free(targets);
+        return err;
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (targets[i] == -1) {
+            insertBack(obj->optionalProperties, copies[i]);
+            continue;
+        }
+        deleteProperty(slots[targets[i]].prop);
+        if (copies[i] != NULL) slots[targets[i]].node->data = copies[i];
+        else unlinkNode(obj->optionalProperties, slots[targets[i]].node);
+    }
+    if (fn != NULL) {
+        deleteProperty(obj->fn);
+        obj->fn = fn;
+    }
+    if (diff->isBirthdayChanged) {
+        deleteDate(obj->birthday);
+        obj->birthday = birthday;
+    }
+    if (diff->isAnniversaryChanged) {
+        deleteDate(obj->anniversary);
+        obj->anniversary = anniversary;
+    }
+
+    free(slots);
+    free(copies);
+    free(targets);
+    return OK;
+}
+
+/*********************************** JSON wire form ***********************************/
+
+char* cardDiffToJSON(const CardDiff* diff) {
+    const char* ops[] = { "add", "remove", "replace" };
+    StringBuffer buffer;
+    PropertyChange* change;
+    ListIterator iter;
+    char target[20];
+    bool isFirst = true;
+    bool result;
+
+    if (diff == NULL || !initStringBuffer(&buffer)) return NULL;
+
+    result = appendString(&buffer, "{\"changes\":[");
+    iter = createIterator(diff->changes);
+    while (result && (change = nextElement(&iter)) != NULL) {
+        result = appendString(&buffer, isFirst ? "{\"op\":\"" : ",{\"op\":\"") && appendString(&buffer, ops[change->kind])
+                && appendString(&buffer, "\"");
+        if (result && change->kind != CHANGE_ADD) {
+            sprintf(target, "%016llx", change->target);
+            result = appendString(&buffer, ",\"name\":") && appendJSONString(&buffer, change->name)
+                    && appendString(&buffer, ",\"target\":\"") && appendString(&buffer, target) && appendString(&buffer, "\"");
+        }
+        if (result && change->property != NULL)
+            result = appendString(&buffer, ",\"property\":") && appendPropertyJSON(&buffer, change->property);
+        result = result && appendString(&buffer, "}");
+        isFirst = false;
+    }
+    result = result && appendString(&buffer, "]");
+
+    if (result && diff->fn)
+        result = appendString(&buffer, ",\"fn\":") && appendPropertyJSON(&buffer, diff->fn);
+    if (result && diff->isBirthdayChanged)
+        result = appendString(&buffer, ",\"birthday\":") && appendDateJSON(&buffer, diff->birthday);
+    if (result && diff->isAnniversaryChanged)
+        result = appendString(&buffer, ",\"anniversary\":") && appendDateJSON(&buffer, diff->anniversary);
+    result = result && appendString(&buffer, "}");
+
+    if (!result) {
+        free(buffer.str);
+        return NULL;
+    }
+    return buffer.str;
+}
+
+// Position in the JSON text being read.  Any syntax error sets isError and stops the reader.
+typedef struct jsonReader {
+    const char* p;
+    bool        isError;
+} JSONReader;
+
+static void skipSpace(JSONReader* reader) {
+    while (*reader->p == ' ' || *reader->p == '\t' || *reader->p == '\n' || *reader->p == '\r')
+        reader->p++;
+}
+
+/* Consumes c, after any whitespace, if it is next. */
+static bool acceptChar(JSONReader* reader, char c) {
+    skipSpace(reader);
+    if (*reader->p != c) return false;
+    reader->p++;
+    return true;
+}
+
+static bool expectChar(JSONReader* reader, char c) {
+    if (!acceptChar(reader, c)) reader->isError = true;
+    return !reader->isError;
+}
+
+static bool acceptWord(JSONReader* reader, const char* word) {
+    skipSpace(reader);
+    if (strncmp(reader->p, word, strlen(word)) != 0) return false;
+    reader->p += strlen(word);
+    return true;
+}
+
+static void appendCodePoint(StringBuffer* buffer, unsigned long code) {
+    char bytes[5] = { 0 };
+
+    if (code < 0x80) {
+        bytes[0] = code;
+    }
+    else if (code < 0x800) {
+        bytes[0] = 0xC0 | (code >> 6);
+        bytes[1] = 0x80 | (code & 0x3F);
+    }
+    else if (code < 0x10000) {
+        bytes[0] = 0xE0 | (code >> 12);
+        bytes[1] = 0x80 | ((code >> 6) & 0x3F);
+        bytes[2] = 0x80 | (code & 0x3F);
+    }
+    else {
+        bytes[0] = 0xF0 | (code >> 18);
+        bytes[1] = 0x80 | ((code >> 12) & 0x3F);
+        bytes[2] = 0x80 | ((code >> 6) & 0x3F);
+        bytes[3] = 0x80 | (code & 0x3F);
+    }
+    appendString(buffer, bytes);
+}
+
+static bool readHex4(JSONReader* reader, unsigned long* code) {
+    char hex[5];
+    char* end;
+
+    strncpy(hex, reader->p, 4);
+    hex[4] = '\0';
+    *code = strtoul(hex, &end, 16);
+    if (end != hex + 4) return false;
+    reader->p += 4;
+    return true;
+}
+
+/* Reads a string, decoding its escapes.  Returns NULL on error. */
+static char* readString(JSONReader* reader) {
+    StringBuffer buffer;
+    const char* start;
+    unsigned long code;
+    unsigned long low;
+
+    if (!expectChar(reader, '"') || !initStringBuffer(&buffer)) {
+        reader->isError = true;
+        return NULL;
+    }
+
+    while (!reader->isError && *reader->p != '"') {
+        start = reader->p;
+        while (*reader->p && *reader->p != '"' && *reader->p != '\\' && (unsigned char) *reader->p >= 0x20)
+            reader->p++;
+        if (reader->p > start) {
+            char saved[256];
+            size_t length;
+
+            // Copy the unescaped run in pieces, since appendString needs NUL-terminated text
+            while (start < reader->p) {
+                length = reader->p - start < (long) sizeof(saved) - 1 ? reader->p - start : sizeof(saved) - 1;
+                memcpy(saved, start, length);
+                saved[length] = '\0';
+                appendString(&buffer, saved);
+                start += length;
+            }
+        }
+        if (*reader->p == '"') break;
+        if (*reader->p != '\\') {
+            reader->isError = true;
+            break;
+        }
+
+        if (*++reader->p == '\0') {
+            reader->isError = true;
+            break;
+        }
+        switch (*reader->p++) {
+        case '"': appendString(&buffer, "\""); break;
+        case '\\': appendString(&buffer, "\\"); break;
+        case '/': appendString(&buffer, "/"); break;
+        case 'b': appendString(&buffer, "\b"); break;
+        case 'f': appendString(&buffer, "\f"); break;
+        case 'n': appendString(&buffer, "\n"); break;
+        case 'r': appendString(&buffer, "\r"); break;
+        case 't': appendString(&buffer, "\t"); break;
+        case 'u':
+            if (!readHex4(reader, &code)) {
+                reader->isError = true;
+                break;
+            }
+            // Join a surrogate pair into one code point
+            if (code >= 0xD800 && code < 0xDC00 && reader->p[0] == '\\' && reader->p[1] == 'u') {
+                reader->p += 2;
+                if (!readHex4(reader, &low) || low < 0xDC00 || low >= 0xE000) {
+                    reader->isError = true;
+                    break;
+                }
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+            // NUL cannot be held in the parser's strings
+            if (code == 0) reader->isError = true;
+            else appendCodePoint(&buffer, code);
+            break;
+        default:
+            reader->isError = true;
+        }
+    }
+
+    if (reader->isError || !expectChar(reader, '"')) {
+        free(buffer.str);
+        return NULL;
+    }
+    return buffer.str;
+}
+
+static bool readBool(JSONReader* reader) {
+    if (acceptWord(reader, "true")) return true;
+    if (!acceptWord(reader, "false")) reader->isError = true;
+    return false;
+}
+
+/* Skips any value, for keys the reader does not know. */
+static void skipValue(JSONReader* reader) {
+    skipSpace(reader);
+    if (*reader->p == '"') {
+        free(readString(reader));
+    }
+    else if (acceptChar(reader, '{')) {
+        if (acceptChar(reader, '}')) return;
+        do {
+            free(readString(reader));
+            if (expectChar(reader, ':')) skipValue(reader);
+        } while (!reader->isError && acceptChar(reader, ','));
+        expectChar(reader, '}');
+    }
+    else if (acceptChar(reader, '[')) {
+        if (acceptChar(reader, ']')) return;
+        do {
+            skipValue(reader);
+        } while (!reader->isError && acceptChar(reader, ','));
+        expectChar(reader, ']');
+    }
+    else if (!acceptWord(reader, "true") && !acceptWord(reader, "false") && !acceptWord(reader, "null")) {
+        const char* start = reader->p;
+
+        strtod(start, (char**) &reader->p);
+        if (reader->p == start) reader->isError = true;
+    }
+}
+
+/* Reads the next key of an object, or returns NULL at its end.  The reader is left at the key's value. */
+static char* readKey(JSONReader* reader, bool* isFirst) {
+    char* key;
+
+    if (reader->isError) return NULL;
+    if (acceptChar(reader, '}')) return NULL;
+    if (!*isFirst && !expectChar(reader, ',')) return NULL;
+    *isFirst = false;
+
+    if (!(key = readString(reader))) return NULL;
+    if (!expectChar(reader, ':')) {
+        free(key);
+        return NULL;
+    }
+    return key;
+}
+
+static bool readParameters(JSONReader* reader, Property* prop) {
+    Parameter* param;
+    char* key;
+    char* name;
+    char* value;
+    bool isFirst;
+
+    if (!expectChar(reader, '[')) return false;
+    if (acceptChar(reader, ']')) return true;
+    do {
+        name = NULL;
+        value = NULL;
+        isFirst = true;
+        if (!expectChar(reader, '{')) return false;
+        while ((key = readKey(reader, &isFirst)) != NULL) {
+            if (strcmp(key, "name") == 0 && !name) name = readString(reader);
+            else if (strcmp(key, "value") == 0 && !value) value = readString(reader);
+            else skipValue(reader);
+            free(key);
+        }
+        if (!reader->isError && name && value && *name && *value && createParameter(&param, name, value) == OK)
+            insertBack(prop->parameters, param);
+        else
+            reader->isError = true;
+        free(name);
+        free(value);
+    } while (!reader->isError && acceptChar(reader, ','));
+
+    return expectChar(reader, ']');
+}
+
+static bool readValues(JSONReader* reader, Property* prop) {
+    char* value;
+
+    if (!expectChar(reader, '[')) return false;
+    if (acceptChar(reader, ']')) return true;
+    do {
+        if ((value = readString(reader)) != NULL) insertBack(prop->values, value);
+    } while (!reader->isError && acceptChar(reader, ','));
+
+    return expectChar(reader, ']');
+}
+
+/* Reads a property in the form appendPropertyJSON writes.  It needs a name and at least one value. */
+static Property* readPropertyJSON(JSONReader* reader) {
+    Property* prop = NULL;
+    char* key;
+    char* text;
+    bool isFirst = true;
+
+    if (!expectChar(reader, '{')) return NULL;
+    if (createProperty(&prop) != OK) {
+        deleteProperty(prop);
+        reader->isError = true;
+        return NULL;
+    }
+
+    while ((key = readKey(reader, &isFirst)) != NULL) {
+        if (strcmp(key, "group") == 0 || strcmp(key, "name") == 0) {
+            if ((text = readString(reader)) != NULL) {
+                const char* interned = internName(text);
+
+                if (!interned) {
+                    reader->isError = true;
+                }
+                else if (key[0] == 'g') {
+                    releaseName(prop->group);
+                    prop->group = interned;
+                }
+                else {
+                    releaseName(prop->name);
+                    prop->name = interned;
+                }
+                free(text);
+            }
+        }
+        else if (strcmp(key, "parameters") == 0) {
+            readParameters(reader, prop);
+        }
+        else if (strcmp(key, "values") == 0) {
+            readValues(reader, prop);
+        }
+        else {
+            skipValue(reader);
+        }
+        free(key);
+    }
+
+    if (reader->isError || *prop->name == '\0' || getLength(prop->values) == 0) {
+        reader->isError = true;
+        deleteProperty(prop);
+        return NULL;
+    }
+    return prop;
+}
+
+/* Reads a date in the form appendDateJSON writes, or null. */
+static DateTime* readDateJSON(JSONReader* reader, bool* isNull) {
+    DateTime* date;
+    char* key;
+    char* date8 = NULL;
+    char* time6 = NULL;
+    char* text = NULL;
+    bool isText = false;
+    bool isUTC = false;
+    bool isFirst = true;
+
+    *isNull = acceptWord(reader, "null");
+    if (*isNull || !expectChar(reader, '{')) return NULL;
+
+    while ((key = readKey(reader, &isFirst)) != NULL) {
+        if (strcmp(key, "isText") == 0) isText = readBool(reader);
+        else if (strcmp(key, "isUTC") == 0) isUTC = readBool(reader);
+        else if (strcmp(key, "date") == 0 && !date8) date8 = readString(reader);
+        else if (strcmp(key, "time") == 0 && !time6) time6 = readString(reader);
+        else if (strcmp(key, "text") == 0 && !text) text = readString(reader);
+        else skipValue(reader);
+        free(key);
+    }
+
+    date = NULL;
+    if (!reader->isError && (!date8 || strlen(date8) <= 8) && (!time6 || strlen(time6) <= 6)
+            && (date = malloc(sizeof(DateTime) + strlen(text ? text : "") + 1))) {
+        date->UTC = isUTC;
+        date->isText = isText;
+        strcpy(date->date, date8 ? date8 : "");
+        strcpy(date->time, time6 ? time6 : "");
+        strcpy(date->text, text ? text : "");
+        setDateKeys(date);
+    }
+    else {
+        reader->isError = true;
+    }
+    free(date8);
+    free(time6);
+    free(text);
+
+    return date;
+}
+
+static unsigned long long readTarget(JSONReader* reader) {
+    unsigned long long target;
+    char* text;
+    char* end;
+
+    if (!(text = readString(reader))) return 0;
+    target = strtoull(text, &end, 16);
+    if (*text == '\0' || *end != '\0') reader->isError = true;
+    free(text);
+
+    return target;
+}
+
+static PropertyChange* readChange(JSONReader* reader) {
+    PropertyChange* change;
+    char* key;
+    char* text;
+    bool isFirst = true;
+    bool hasOp = false;
+
+    if (!expectChar(reader, '{')) return NULL;
+    if (!(change = calloc(1, sizeof(PropertyChange)))) {
+        reader->isError = true;
+        return NULL;
+    }
+
+    while ((key = readKey(reader, &isFirst)) != NULL) {
+        if (strcmp(key, "op") == 0 && (text = readString(reader)) != NULL) {
+            hasOp = true;
+            if (strcmp(text, "add") == 0) change->kind = CHANGE_ADD;
+            else if (strcmp(text, "remove") == 0) change->kind = CHANGE_REMOVE;
+            else if (strcmp(text, "replace") == 0) change->kind = CHANGE_REPLACE;
+            else reader->isError = true;
+            free(text);
+        }
+        else if (strcmp(key, "target") == 0) {
+            change->target = readTarget(reader);
+        }
+        else if (strcmp(key, "name") == 0 && (text = readString(reader)) != NULL) {
+            releaseName(change->name);
+            if (!(change->name = internName(text))) reader->isError = true;
+            free(text);
+        }
+        else if (strcmp(key, "property") == 0 && change->property == NULL) {
+            change->property = readPropertyJSON(reader);
+        }
+        else {
+            skipValue(reader);
+        }
+        free(key);
+    }
+
+    // Adds and replacements carry a property, removals and replacements a target
+    if (reader->isError || !hasOp || (change->kind != CHANGE_REMOVE) != (change->property != NULL)
+            || (change->kind == CHANGE_ADD) != (change->target == 0)) {
+        reader->isError = true;
+        deleteChange(change);
+        return NULL;
+    }
+    if (change->kind == CHANGE_ADD) {
+        releaseName(change->name);
+        if (!(change->name = internName(change->property->name))) {
+            reader->isError = true;
+            deleteChange(change);
+            return NULL;
+        }
+    }
+    return change;
+}
+
+VCardErrorCode JSONtoCardDiff(const char* str, CardDiff** diff) {
+    JSONReader reader = { str, false };
+    PropertyChange* change;
+    char* key;
+    bool isFirst = true;
+    bool isNull;
+
+    *diff = NULL;
+    if (str == NULL) return INV_PROP;
+    if (!(*diff = createCardDiff())) return OTHER_ERROR;
+
+    expectChar(&reader, '{');
+    while ((key = readKey(&reader, &isFirst)) != NULL) {
+        if (strcmp(key, "changes") == 0) {
+            if (expectChar(&reader, '[') && !acceptChar(&reader, ']')) {
+                do {
+                    if ((change = readChange(&reader)) != NULL) insertBack((*diff)->changes, change);
+                } while (!reader.isError && acceptChar(&reader, ','));
+                expectChar(&reader, ']');
+            }
+        }
+        else if (strcmp(key, "fn") == 0 && (*diff)->fn == NULL) {
+            (*diff)->fn = readPropertyJSON(&reader);
+        }
+        else if (strcmp(key, "birthday") == 0 && !(*diff)->isBirthdayChanged) {
+            (*diff)->isBirthdayChanged = true;
+            (*diff)->birthday = readDateJSON(&reader, &isNull);
+        }
+        else if (strcmp(key, "anniversary") == 0 && !(*diff)->isAnniversaryChanged) {
+            (*diff)->isAnniversaryChanged = true;
+            (*diff)->anniversary = readDateJSON(&reader, &isNull);
+        }
+        else {
+            skipValue(&reader);
+        }
+        free(key);
+    }
+    skipSpace(&reader);
+
+    if (reader.isError || *reader.p != '\0') {
+        deleteCardDiff(*diff);
+        *diff = NULL;
+        return INV_PROP;
+    }
+    return OK;
+}
+
+VCardErrorCode JSONLineToCard(const char* str, Card** obj) {
+    JSONReader reader = { str, false };
+    Property* prop;
+    char* key;
+    bool isFirst = true;
+    bool isNull;
+
+    *obj = NULL;
+    if (str == NULL) return INV_CARD;
+    if (!(*obj = calloc(1, sizeof(Card)))) return OTHER_ERROR;
+    if (!((*obj)->optionalProperties = initializeList(printProperty, deleteProperty, compareProperties))) {
+        free(*obj);
+        *obj = NULL;
+        return OTHER_ERROR;
+    }
+
+    expectChar(&reader, '{');
+    while ((key = readKey(&reader, &isFirst)) != NULL) {
+        if (strcmp(key, "fn") == 0 && (*obj)->fn == NULL) {
+            (*obj)->fn = readPropertyJSON(&reader);
+        }
+        else if (strcmp(key, "properties") == 0) {
+            if (expectChar(&reader, '[') && !acceptChar(&reader, ']')) {
+                do {
+                    if ((prop = readPropertyJSON(&reader)) != NULL) insertBack((*obj)->optionalProperties, prop);
+                } while (!reader.isError && acceptChar(&reader, ','));
+                expectChar(&reader, ']');
+            }
+        }
+        else if (strcmp(key, "birthday") == 0 && (*obj)->birthday == NULL) {
+            (*obj)->birthday = readDateJSON(&reader, &isNull);
+        }
+        else if (strcmp(key, "anniversary") == 0 && (*obj)->anniversary == NULL) {
+            (*obj)->anniversary = readDateJSON(&reader, &isNull);
+        }
+        else {
+            skipValue(&reader);
+        }
+        free(key);
+    }
+    skipSpace(&reader);
+
+    if (reader.isError || *reader.p != '\0' || (*obj)->fn == NULL) {
+        deleteCard(*obj);
+        *obj = NULL;
+        return INV_CARD;
+    }
+    return OK;
+}
+
+/*********************************** Files ***********************************/
+
+char* diffCardFiles(char* fromFile, char* toFile) {
+    Card* from = NULL;
+    Card* to = NULL;
+    CardDiff* diff = NULL;
+    char* JSONstr = NULL;
+
+    if (createCard(fromFile, &from) == OK && validateCard(from) == OK
+            && createCard(toFile, &to) == OK && validateCard(to) == OK && diffCards(from, to, &diff) == OK)
+        JSONstr = cardDiffToJSON(diff);
+
+    deleteCardDiff(diff);
+    deleteCard(from);
+    deleteCard(to);
+    return JSONstr ? JSONstr : duplicateString("");
+}
+
+VCardErrorCode patchCardFile(char* fileName, char* diffJSON) {
+    Card* myCard = NULL;
+    CardDiff* diff = NULL;
+    char* tmpPath;
+    FILE* fp;
+    VCardErrorCode err;
+
+    if (fileName == NULL || diffJSON == NULL) return OTHER_ERROR;
+    if ((err = createCard(fileName, &myCard)) != OK || (err = validateCard(myCard)) != OK
+            || (err = JSONtoCardDiff(diffJSON, &diff)) != OK || (err = applyCardDiff(myCard, diff)) != OK
+            || (err = validateCard(myCard)) != OK) {
+        deleteCardDiff(diff);
+        deleteCard(myCard);
+        return err;
+    }
+    deleteCardDiff(diff);
+
+    // Write beside the card in its own compression and rename over it, so readers never see a partial file
+    if (!(tmpPath = malloc(sizeof(char) * (strlen(fileName) + 5)))) {
+        deleteCard(myCard);
+        return OTHER_ERROR;
+    }
+    sprintf(tmpPath, "%s.tmp", fileName);
+    if (!(fp = createCardFile(tmpPath, compressionFromName(fileName)))) {
+        err = WRITE_ERROR;
+    }
+    else {
+        err = writeCardToStream(fp, myCard);
+        if (fclose(fp) != 0 && err == OK) err = WRITE_ERROR;
+    }
+    if (err == OK && rename(tmpPath, fileName) != 0)
+        err = WRITE_ERROR;
+    if (err != OK) unlink(tmpPath);
+    // The patched card was validated above; a missing marker only costs a later validation
+    else markCardTrusted(fileName);
+
+    free(tmpPath);
+    deleteCard(myCard);
+    return err;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file CardExport.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#define _DEFAULT_SOURCE
+
+#include "CardExport.h"
+#include "ParserFunctions.h"
+
+bool appendPropertyJSON(StringBuffer* buffer, const Property* prop) {
+    ListIterator iter;
+    Parameter* param;
+    char* value;
+    bool isFirst = true;
+    bool result;
+
+    result = appendString(buffer, "{\"group\":") && appendJSONString(buffer, prop->group)
+            && appendString(buffer, ",\"name\":") && appendJSONString(buffer, prop->name)
+            && appendString(buffer, ",\"parameters\":[");
+
+    iter = createIterator(prop->parameters);
+    while (result && (param = nextElement(&iter)) != NULL) {
+        result = appendString(buffer, isFirst ? "{\"name\":" : ",{\"name\":") && appendJSONString(buffer, param->name)
+                && appendString(buffer, ",\"value\":") && appendJSONString(buffer, param->value)
+                && appendString(buffer, "}");
+        isFirst = false;
+    }
+
+    result = result && appendString(buffer, "],\"values\":[");
+    isFirst = true;
+    iter = createIterator(prop->values);
+    while (result && (value = nextElement(&iter)) != NULL) {
+        result = (isFirst || appendString(buffer, ",")) && appendJSONString(buffer, value);
+        isFirst = false;
+    }
+
+    return result && appendString(buffer, "]}");
+}
+
+bool appendDateJSON(StringBuffer* buffer, const DateTime* date) {
+    if (date == NULL) return appendString(buffer, "null");
+
+    return appendString(buffer, date->isText ? "{\"isText\":true" : "{\"isText\":false")
+            && appendString(buffer, ",\"date\":") && appendJSONString(buffer, date->date)
+            && appendString(buffer, ",\"time\":") && appendJSONString(buffer, date->time)
+            && appendString(buffer, ",\"text\":") && appendJSONString(buffer, date->text)
+            && appendString(buffer, date->UTC ? ",\"isUTC\":true}" : ",\"isUTC\":false}");
+}
+
+char* cardToJSONLine(const Card* obj) {
+    StringBuffer buffer;
+    ListIterator iter;
+    Property* prop;
+    bool isFirst = true;
+    bool result;
+
+    if (obj == NULL || !initStringBuffer(&buffer)) return NULL;
+
+    result = appendString(&buffer, "{\"fn\":") && appendPropertyJSON(&buffer, obj->fn)
+            && appendString(&buffer, ",\"properties\":[");
+    iter = createIterator(obj->optionalProperties);
+    while (result && (prop = nextElement(&iter)) != NULL) {
+        result = (isFirst || appendString(&buffer, ",")) && appendPropertyJSON(&buffer, prop);
+        isFirst = false;
+    }
+    result = result && appendString(&buffer, "],\"birthday\":") && appendDateJSON(&buffer, obj->birthday)
+            && appendString(&buffer, ",\"anniversary\":") && appendDateJSON(&buffer, obj->anniversary)
+            && appendString(&buffer, "}\n");
+
+    if (!result) {
+        free(buffer.str);
+        return NULL;
+    }
+    return buffer.str;
+}
+
+char* cardToVCard(const Card* obj) {
+    FILE* fp;
+    char* text = NULL;
+    size_t length = 0;
+    VCardErrorCode err;
+
+    if (obj == NULL || !(fp = open_memstream(&text, &length))) return NULL;
+
+    err = writeCardToStream(fp, obj);
+    if (fclose(fp) != 0 || err != OK) {
+        free(text);
+        return NULL;
+    }
+    return text;
+}
+
+char* exportCard(char* fileName, char* format) {
+    Card* myCard = NULL;
+    char* text = NULL;
+
+    if (fileName == NULL || format == NULL) return duplicateString("");
+    if (strcmp(format, "vcf") != 0 && strcmp(format, "jsonl") != 0) return duplicateString("");
+
+    if (createCard(fileName, &myCard) == OK && validateCard(myCard) == OK)
+        text = strcmp(format, "vcf") == 0 ? cardToVCard(myCard) : cardToJSONLine(myCard);
+    deleteCard(myCard);
+
+    return text ? text : duplicateString("");
+}
@@ -0,0 +1,356 @@
+/**
+ * @file CardFingerprint.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#include "CardFingerprint.h"
+#include "Corpus.h"
+#include "ParserFunctions.h"
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+// Keys collected for one card file during findDuplicates
+typedef struct cardKeys {
+    bool    isParsed;
+    char*   uid;
+    unsigned long long fingerprint;
+    char**  contactKeys;
+    int     contactCount;
+} CardKeys;
+
+// One (key, file) pair.  Sorting these groups equal keys together.
+typedef struct duplicateKey {
+    const char* key;
+    int         file;
+} DuplicateKey;
+
+static unsigned long long hashChar(unsigned long long hash, char c) {
+    return (hash ^ (unsigned char) c) * FNV_PRIME;
+}
+
+static unsigned long long hashText(unsigned long long hash, const char* str, bool isUpper) {
+    if (str == NULL) return hash;
+
+    while (*str) {
+        hash = hashChar(hash, isUpper ? toupper((unsigned char) *str) : *str);
+        str++;
+    }
+    return hash;
+}
+
+/* Finalizer from splitmix64, so that nearby inputs do not give nearby fingerprints. */
+static unsigned long long mixHash(unsigned long long hash) {
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+static int compareUpper(const char* s1, const char* s2) {
+    int result;
+
+    while ((result = toupper((unsigned char) *s1) - toupper((unsigned char) *s2)) == 0 && *s1) {
+        s1++;
+        s2++;
+    }
+    return result;
+}
+
+static int compareNormalizedParameters(const void* first, const void* second) {
+    const Parameter* parameterOne = *(const Parameter* const*) first;
+    const Parameter* parameterTwo = *(const Parameter* const*) second;
+    int result;
+
+    if ((result = compareUpper(parameterOne->name, parameterTwo->name)) != 0) return result;
+    return strcmp(parameterOne->value, parameterTwo->value);
+}
+
+static int compareHashes(const void* first, const void* second) {
+    unsigned long long hashOne = *(const unsigned long long*) first;
+    unsigned long long hashTwo = *(const unsigned long long*) second;
+
+    return (hashOne > hashTwo) - (hashOne < hashTwo);
+}
+
+/* Hashes a property's group, name and sorted parameters, before mixing. */
+static unsigned long long hashPropertyKey(const Property* prop) {
+    unsigned long long hash = FNV_OFFSET;
+    Parameter** params = NULL;
+    Parameter* param;
+    ListIterator iter;
+    int count = 0;
+
+    hash = hashText(hash, prop->group, true);
+    hash = hashChar(hash, '.');
+    hash = hashText(hash, prop->name, true);
+
+    if (prop->parameters && getLength(prop->parameters) > 0) {
+        if ((params = malloc(sizeof(Parameter*) * getLength(prop->parameters)))) {
+            iter = createIterator(prop->parameters);
+            while ((param = nextElement(&iter)) != NULL)
+                params[count++] = param;
+            qsort(params, count, sizeof(Parameter*), compareNormalizedParameters);
+        }
+        for (int i = 0; i < count; i++) {
+            hash = hashChar(hash, ';');
+            hash = hashText(hash, params[i]->name, true);
+            hash = hashChar(hash, '=');
+            hash = hashText(hash, params[i]->value, false);
+        }
+        free(params);
+    }
+
+    return hash;
+}
+
+unsigned long long fingerprintPropertyKey(const Property* prop) {
+    if (prop == NULL) return 0;
+
+    return mixHash(hashPropertyKey(prop));
+}
+
+unsigned long long fingerprintProperty(const Property* prop) {
+    unsigned long long hash;
+    ListIterator iter;
+    char* value;
+
+    if (prop == NULL) return 0;
+
+    hash = hashChar(hashPropertyKey(prop), ':');
+    if (prop->values) {
+        iter = createIterator(prop->values);
+        while ((value = nextElement(&iter)) != NULL) {
+            hash = hashText(hash, value, false);
+            hash = hashChar(hash, ';');
+        }
+    }
+
+    return mixHash(hash);
+}
+
+static unsigned long long fingerprintDate(const char* name, const DateTime* dt) {
+    unsigned long long hash = hashText(FNV_OFFSET, name, false);
+
+    if (dt->isText) {
+        hash = hashText(hash, ";VALUE=TEXT:", false);
+        hash = hashText(hash, dt->text, false);
+    }
+    else {
+        hash = hashChar(hash, ':');
+        hash = hashText(hash, dt->date, false);
+        hash = hashChar(hash, 'T');
+        hash = hashText(hash, dt->time, false);
+        if (dt->UTC) hash = hashChar(hash, 'Z');
+    }
+
+    return mixHash(hash);
+}
+
+unsigned long long fingerprintCard(const Card* obj) {
+    unsigned long long hash = FNV_OFFSET;
+    unsigned long long* hashes;
+    ListIterator iter;
+    Property* prop;
+    int count = 0;
+
+    if (obj == NULL || obj->optionalProperties == NULL) return 0;
+    if (!(hashes = malloc(sizeof(unsigned long long) * (getLength(obj->optionalProperties) + 3)))) return 0;
+
+    // Hash each property on its own and sort the results, so property order does not matter
+    if (obj->fn) hashes[count++] = fingerprintProperty(obj->fn);
+    if (obj->birthday) hashes[count++] = fingerprintDate("BDAY", obj->birthday);
+    if (obj->anniversary) hashes[count++] = fingerprintDate("ANNIVERSARY", obj->anniversary);
+    iter = createIterator(obj->optionalProperties);
+    while ((prop = nextElement(&iter)) != NULL)
+        hashes[count++] = fingerprintProperty(prop);
+    qsort(hashes, count, sizeof(unsigned long long), compareHashes);
+
+    for (int i = 0; i < count; i++) {
+        for (int b = 0; b < 8; b++)
+            hash = hashChar(hash, (char) (hashes[i] >> (b * 8)));
+    }
+
+    free(hashes);
+    return mixHash(hash);
+}
+
+/* Builds "FN|KIND:value" with the FN upper-cased, EMAIL lower-cased and TEL reduced to digits and '+'. */
+static char* contactKey(const char* fn, const char* kind, const char* value) {
+    char* key;
+    char* p;
+
+    if (!(key = malloc(sizeof(char) * (strlen(fn) + strlen(kind) + strlen(value) + 3)))) return NULL;
+
+    p = key;
+    for (; *fn; fn++)
+        *p++ = toupper((unsigned char) *fn);
+    p += sprintf(p, "|%s:", kind);
+    for (; *value; value++) {
+        if (strcmp(kind, "TEL") == 0) {
+            if (isdigit((unsigned char) *value) || *value == '+') *p++ = *value;
+        }
+        else {
+            *p++ = tolower((unsigned char) *value);
+        }
+    }
+    *p = '\0';
+
+    return key;
+}
+
+static void collectCardKeys(int index, const char* file, void* arg) {
+    CardKeys* keys = &((CardKeys*) arg)[index];
+    Card* myCard = NULL;
+    ListIterator iter;
+    Property* prop;
+    char* fn;
+    char* value;
+    char** grown;
+
+    if (createCard((char*) file, &myCard) != OK) {
+        deleteCard(myCard);
+        return;
+    }
+
+    keys->isParsed = true;
+    keys->fingerprint = fingerprintCard(myCard);
+    fn = getFromFront(myCard->fn->values);
+
+    iter = createIterator(myCard->optionalProperties);
+    while ((prop = nextElement(&iter)) != NULL) {
+        if (!(value = getFromFront(prop->values))) continue;
+
+        if (stricasecmp(prop->name, "UID") == 0 && keys->uid == NULL) {
+            keys->uid = duplicateString(value);
+        }
+        else if (stricasecmp(prop->name, "EMAIL") == 0 || stricasecmp(prop->name, "TEL") == 0) {
+            if (!(grown = realloc(keys->contactKeys, sizeof(char*) * (keys->contactCount + 1)))) continue;
+            keys->contactKeys = grown;
+            if ((keys->contactKeys[keys->contactCount] = contactKey(fn, stricasecmp(prop->name, "TEL") == 0 ? "TEL" : "EMAIL", value)))
+                keys->contactCount++;
+        }
+    }
+
+    deleteCard(myCard);
+}
+
+static int compareDuplicateKeys(const void* first, const void* second) {
+    const DuplicateKey* keyOne = (const DuplicateKey*) first;
+    const DuplicateKey* keyTwo = (const DuplicateKey*) second;
+    int result;
+
+    if ((result = strcmp(keyOne->key, keyTwo->key)) != 0) return result;
+    return keyOne->file - keyTwo->file;
+}
+
+/* Sorts the keys and appends every group of two or more distinct files as a JSON array. */
+static void appendDuplicateGroups(StringBuffer* buffer, const char* label, DuplicateKey* keys, int count, char** files) {
+    bool isFirstGroup = true;
+    int start = 0;
+    int end;
+    int distinct;
+
+    qsort(keys, count, sizeof(DuplicateKey), compareDuplicateKeys);
+
+    appendString(buffer, "\"");
+    appendString(buffer, label);
+    appendString(buffer, "\":[");
+    while (start < count) {
+        distinct = 1;
+        for (end = start + 1; end < count && strcmp(keys[end].key, keys[start].key) == 0; end++) {
+            if (keys[end].file != keys[end - 1].file) distinct++;
+        }
+
+        if (distinct > 1) {
+            appendString(buffer, isFirstGroup ? "{\"key\":" : ",{\"key\":");
+            appendJSONString(buffer, keys[start].key);
+            appendString(buffer, ",\"files\":[");
+            for (int i = start; i < end; i++) {
+                if (i > start && keys[i].file == keys[i - 1].file) continue;
+                const char* name = strrchr(files[keys[i].file], '/');
+                if (i > start) appendString(buffer, ",");
+                appendJSONString(buffer, name ? name + 1 : files[keys[i].file]);
+            }
+            appendString(buffer, "]}");
+            isFirstGroup = false;
+        }
+        start = end;
+    }
+    appendString(buffer, "]");
+}
+
+char* findDuplicates(char* dirName) {
+    StringBuffer buffer;
+    CardKeys* keys;
+    DuplicateKey* uidKeys;
+    DuplicateKey* fingerprintKeys;
+    DuplicateKey* contactKeys;
+    char (*fingerprints)[17];
+    char** files;
+    int count;
+    int uidCount = 0;
+    int fingerprintCount = 0;
+    int contactCount = 0;
+
+    if (listCardFiles(dirName, &files, &count) != OK) return duplicateString("{}");
+
+    if (!(keys = calloc(count + 1, sizeof(CardKeys)))) {
+        freeCardFiles(files, count);
+        return duplicateString("{}");
+    }
+    forEachCardFile(files, count, collectCardKeys, keys, 0);
+
+    for (int i = 0; i < count; i++)
+        contactCount += keys[i].contactCount;
+    uidKeys = malloc(sizeof(DuplicateKey) * (count + 1));
+    fingerprintKeys = malloc(sizeof(DuplicateKey) * (count + 1));
+    contactKeys = malloc(sizeof(DuplicateKey) * (contactCount + 1));
+    fingerprints = malloc(sizeof(*fingerprints) * (count + 1));
+    if (!uidKeys || !fingerprintKeys || !contactKeys || !fingerprints || !initStringBuffer(&buffer)) {
+        buffer.str = duplicateString("{}");
+    }
+    else {
+        contactCount = 0;
+        for (int i = 0; i < count; i++) {
+            if (!keys[i].isParsed) continue;
+            if (keys[i].uid) {
+                uidKeys[uidCount].key = keys[i].uid;
+                uidKeys[uidCount++].file = i;
+            }
+            sprintf(fingerprints[i], "%016llx", keys[i].fingerprint);
+            fingerprintKeys[fingerprintCount].key = fingerprints[i];
+            fingerprintKeys[fingerprintCount++].file = i;
+            for (int k = 0; k < keys[i].contactCount; k++) {
+                contactKeys[contactCount].key = keys[i].contactKeys[k];
+                contactKeys[contactCount++].file = i;
+            }
+        }
+
+        appendString(&buffer, "{");
+        appendDuplicateGroups(&buffer, "byUID", uidKeys, uidCount, files);
+        appendString(&buffer, ",");
+        appendDuplicateGroups(&buffer, "byFingerprint", fingerprintKeys, fingerprintCount, files);
+        appendString(&buffer, ",");
+        appendDuplicateGroups(&buffer, "byContact", contactKeys, contactCount, files);
+        appendString(&buffer, "}");
+    }
+
+    for (int i = 0; i < count; i++) {
+        free(keys[i].uid);
+        for (int k = 0; k < keys[i].contactCount; k++)
+            free(keys[i].contactKeys[k]);
+        free(keys[i].contactKeys);
+    }
+    free(keys);
+    free(uidKeys);
+    free(fingerprintKeys);
+    free(contactKeys);
+    free(fingerprints);
+    freeCardFiles(files, count);
+
+    return buffer.str;
+}
@@ -0,0 +1,518 @@
+/**
+ * @file CardQuery.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#include <ctype.h>
+
+#include "CardQuery.h"
+#include "Corpus.h"
+#include "ParserFunctions.h"
+
+typedef struct queryParser {
+    const char* text;
+    int         position;
+    int         depth;
+    bool        isOutOfMemory;
+    CardQuery*  query;
+} QueryParser;
+
+// What one file contributes to a query's result, filled in by a worker thread
+typedef struct querySlot {
+    bool    isValid;
+    bool    isMatch;
+    char*   name;
+} QuerySlot;
+
+typedef struct queryJob {
+    const CardQuery*    query;
+    QuerySlot*          slots;
+} QueryJob;
+
+//***************************************** Compiling *****************************************
+
+static bool isNameChar(char c) {
+    return isalnum((unsigned char) c) || c == '-' || c == '_';
+}
+
+static void skipSpace(QueryParser* parser) {
+    while (isspace((unsigned char) parser->text[parser->position]))
+        parser->position++;
+}
+
+/* Copies length characters of the query, or returns NULL and flags the parser if memory runs out. */
+static char* copyText(QueryParser* parser, const char* start, int length) {
+    char* copy;
+
+    if (!(copy = malloc(sizeof(char) * (length + 1)))) {
+        parser->isOutOfMemory = true;
+        return NULL;
+    }
+    memcpy(copy, start, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+/* Reads a name, group or parameter name.  Returns NULL if there is none. */
+static char* readName(QueryParser* parser) {
+    int start = parser->position;
+
+    while (isNameChar(parser->text[parser->position]))
+        parser->position++;
+    if (parser->position == start) return NULL;
+
+    return copyText(parser, parser->text + start, parser->position - start);
+}
+
+/* Reads a quoted or bare value.  Returns NULL if there is none. */
+static char* readValue(QueryParser* parser) {
+    const char* text = parser->text;
+    int start = parser->position;
+    char* value;
+    int length = 0;
+
+    if (text[start] != '"') {
+        while (text[parser->position] && !isspace((unsigned char) text[parser->position])
+                && !strchr("();\"", text[parser->position]))
+            parser->position++;
+        if (parser->position == start) return NULL;
+        return copyText(parser, text + start, parser->position - start);
+    }
+
+    // The unescaped value is never longer than the quoted one
+    parser->position++;
+    if (!(value = copyText(parser, text + parser->position, strlen(text + parser->position)))) return NULL;
+    while (text[parser->position] && text[parser->position] != '"') {
+        if (text[parser->position] == '\\' && (text[parser->position + 1] == '"' || text[parser->position + 1] == '\\'))
+            parser->position++;
+        value[length++] = text[parser->position++];
+    }
+    if (text[parser->position] != '"') {
+        free(value);
+        return NULL;
+    }
+    parser->position++;
+    value[length] = '\0';
+
+    return value;
+}
+
+/* Consumes keyword if it is the next word, in any case. */
+static bool readKeyword(QueryParser* parser, const char* keyword) {
+    int length = strlen(keyword);
+    const char* next = parser->text + parser->position;
+
+    for (int i = 0; i < length; i++) {
+        if (toupper((unsigned char) next[i]) != keyword[i]) return false;
+    }
+    if (isNameChar(next[length])) return false;
+
+    parser->position += length;
+    return true;
+}
+
+static bool addStep(QueryParser* parser, QueryOp op, int term) {
+    CardQuery* query = parser->query;
+
+    if (query->stepCount == QUERY_MAX_STEPS) return false;
+    query->steps[query->stepCount].op = op;
+    query->steps[query->stepCount++].term = term;
+    return true;
+}
+
+static bool addParam(QueryParser* parser, QueryTerm* term, char* name, char* value) {
+    QueryParam* grown;
+
+    if (!(grown = realloc(term->params, sizeof(QueryParam) * (term->paramCount + 1)))) {
+        parser->isOutOfMemory = true;
+        free(name);
+        free(value);
+        return false;
+    }
+    term->params = grown;
+    term->params[term->paramCount].name = name;
+    term->params[term->paramCount++].value = value;
+    return true;
+}
+
+static bool parseTerm(QueryParser* parser) {
+    CardQuery* query = parser->query;
+    QueryTerm* term;
+    const char* op;
+    char* name;
+    char* value;
+
+    if (query->termCount == QUERY_MAX_TERMS) return false;
+    term = &query->terms[query->termCount++];
+
+    if (!(term->name = readName(parser))) return false;
+    if (parser->text[parser->position] == '.') {
+        parser->position++;
+        term->group = term->name;
+        if (!(term->name = readName(parser))) return false;
+    }
+
+    skipSpace(parser);
+    while (parser->text[parser->position] == ';') {
+        parser->position++;
+        skipSpace(parser);
+        if (!(name = readName(parser))) return false;
+
+        value = NULL;
+        skipSpace(parser);
+        if (parser->text[parser->position] == '=') {
+            parser->position++;
+            skipSpace(parser);
+            if (!(value = readValue(parser))) {
+                free(name);
+                return false;
+            }
+            skipSpace(parser);
+        }
+        if (!addParam(parser, term, name, value)) return false;
+    }
+
+    if (parser->text[parser->position] && (op = strchr("=~^$", parser->text[parser->position]))) {
+        const ValueMatch matches[] = { MATCH_EQUALS, MATCH_CONTAINS, MATCH_PREFIX, MATCH_SUFFIX };
+
+        term->match = matches[op - "=~^$"];
+        parser->position++;
+        skipSpace(parser);
+        if (!(term->value = readValue(parser))) return false;
+    }
+
+    return addStep(parser, QUERY_TERM, query->termCount - 1);
+}
+
+static bool parseOr(QueryParser* parser);
+
+static bool parseUnary(QueryParser* parser) {
+    bool result;
+
+    skipSpace(parser);
+    if (readKeyword(parser, "NOT")) {
+        if (++parser->depth > QUERY_MAX_DEPTH) return false;
+        result = parseUnary(parser) && addStep(parser, QUERY_NOT, 0);
+        parser->depth--;
+        return result;
+    }
+    if (parser->text[parser->position] != '(') return parseTerm(parser);
+
+    parser->position++;
+    if (++parser->depth > QUERY_MAX_DEPTH || !parseOr(parser)) return false;
+    parser->depth--;
+    skipSpace(parser);
+    if (parser->text[parser->position] != ')') return false;
+    parser->position++;
+
+    return true;
+}
+
+static bool parseAnd(QueryParser* parser) {
+    if (!parseUnary(parser)) return false;
+
+    skipSpace(parser);
+    while (readKeyword(parser, "AND")) {
+        if (!parseUnary(parser) || !addStep(parser, QUERY_AND, 0)) return false;
+        skipSpace(parser);
+    }
+    return true;
+}
+
+static bool parseOr(QueryParser* parser) {
+    if (!parseAnd(parser)) return false;
+
+    skipSpace(parser);
+    while (readKeyword(parser, "OR")) {
+        if (!parseAnd(parser) || !addStep(parser, QUERY_OR, 0)) return false;
+        skipSpace(parser);
+    }
+    return true;
+}
+
+CardQuery* compileCardQuery(const char* text, int* errorOffset) {
+    QueryParser parser;
+    bool isCompiled;
+
+    *errorOffset = -1;
+    if (text == NULL) {
+        *errorOffset = 0;
+        return NULL;
+    }
+
+    memset(&parser, 0, sizeof(QueryParser));
+    parser.text = text;
+    if (!(parser.query = calloc(1, sizeof(CardQuery)))) return NULL;
+    parser.query->terms = calloc(QUERY_MAX_TERMS, sizeof(QueryTerm));
+    parser.query->steps = malloc(sizeof(QueryStep) * QUERY_MAX_STEPS);
+    if (!parser.query->terms || !parser.query->steps) {
+        freeCardQuery(parser.query);
+        return NULL;
+    }
+
+    isCompiled = parseOr(&parser);
+    skipSpace(&parser);
+    if (!isCompiled || parser.text[parser.position] != '\0') {
+        if (!parser.isOutOfMemory) *errorOffset = parser.position;
+        freeCardQuery(parser.query);
+        return NULL;
+    }
+
+    return parser.query;
+}
+
+void freeCardQuery(CardQuery* query) {
+    if (query == NULL) return;
+
+    for (int i = 0; query->terms && i < query->termCount; i++) {
+        free(query->terms[i].group);
+        free(query->terms[i].name);
+        for (int j = 0; j < query->terms[i].paramCount; j++) {
+            free(query->terms[i].params[j].name);
+            free(query->terms[i].params[j].value);
+        }
+        free(query->terms[i].params);
+        free(query->terms[i].value);
+    }
+    free(query->terms);
+    free(query->steps);
+    free(query);
+}
+
+//***************************************** Matching *****************************************
+
+/* Compares length characters without regard to case. */
+static bool equalsNoCase(const char* first, const char* second, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (tolower((unsigned char) first[i]) != tolower((unsigned char) second[i])) return false;
+    }
+    return true;
+}
+
+static bool matchesText(ValueMatch match, const char* value, const char* pattern) {
+    size_t valueLength = strlen(value);
+    size_t patternLength = strlen(pattern);
+
+    switch (match) {
+    case MATCH_EQUALS:
+        return valueLength == patternLength && equalsNoCase(value, pattern, patternLength);
+    case MATCH_PREFIX:
+        return valueLength >= patternLength && equalsNoCase(value, pattern, patternLength);
+    case MATCH_SUFFIX:
+        return valueLength >= patternLength && equalsNoCase(value + valueLength - patternLength, pattern, patternLength);
+    case MATCH_CONTAINS:
+        for (size_t i = 0; i + patternLength <= valueLength; i++) {
+            if (equalsNoCase(value + i, pattern, patternLength)) return true;
+        }
+        return false;
+    default:
+        return true;
+    }
+}
+
+/* Whether one item of a comma separated list, with quotes around it or the whole list removed, is item. */
+static bool hasListItem(const char* list, const char* item) {
+    const char* end = list + strlen(list);
+    const char* next;
+    const char* start;
+    const char* stop;
+    size_t itemLength = strlen(item);
+
+    while (list < end) {
+        if (!(next = memchr(list, ',', end - list))) next = end;
+        start = list;
+        stop = next;
+        if (*start == '"') start++;
+        if (stop > start && stop[-1] == '"') stop--;
+        if ((size_t) (stop - start) == itemLength && equalsNoCase(start, item, itemLength)) return true;
+        list = next + 1;
+    }
+    return false;
+}
+
+static bool hasParameter(const Property* prop, const QueryParam* wanted) {
+    ListIterator iter = createIterator(prop->parameters);
+    Parameter* param;
+
+    while ((param = nextElement(&iter)) != NULL) {
+        if (stricasecmp(param->name, wanted->name) != 0) continue;
+        if (wanted->value == NULL || hasListItem(param->value, wanted->value)) return true;
+    }
+    return false;
+}
+
+static bool matchesProperty(const QueryTerm* term, const Property* prop) {
+    ListIterator iter;
+    char* value;
+
+    if (stricasecmp(prop->name, term->name) != 0) return false;
+    if (term->group && stricasecmp(prop->group, term->group) != 0) return false;
+    for (int i = 0; i < term->paramCount; i++) {
+        if (!hasParameter(prop, &term->params[i])) return false;
+    }
+    if (term->match == MATCH_ANY) return true;
+
+    iter = createIterator(prop->values);
+    while ((value = nextElement(&iter)) != NULL) {
+        if (matchesText(term->match, value, term->value)) return true;
+    }
+    return false;
+}
+
+static bool matchesDate(const QueryTerm* term, const char* name, const DateTime* date) {
+    char value[20];
+
+    if (date == NULL || term->group || term->paramCount > 0 || stricasecmp(term->name, name) != 0) return false;
+    if (term->match == MATCH_ANY) return true;
+    if (date->isText) return matchesText(term->match, date->text, term->value);
+
+    snprintf(value, sizeof(value), "%s%s%s%s", date->date, strcmp(date->time, "") != 0 ? "T" : "", date->time,
+            date->UTC ? "Z" : "");
+    return matchesText(term->match, value, term->value);
+}
+
+/*  Whether a content line could be named by one of the query's terms, judging from its raw bytes,
+    so other properties are never built.  Lines whose name cannot be read cheaply are kept.
+*/
+static bool mayMatchLine(const CardQuery* query, const char* line, long length) {
+    long nameStart = 0;
+    long end;
+
+    for (end = 0; end < length && line[end] != ';' && line[end] != ':'; end++) {
+        if (line[end] == '\r' || line[end] == '\\') return true;
+        if (line[end] == '.') nameStart = end + 1;
+    }
+    if (end == length) return true;
+
+    for (int i = 0; i < query->termCount; i++) {
+        if ((long) strlen(query->terms[i].name) == end - nameStart && equalsNoCase(line + nameStart, query->terms[i].name, end - nameStart))
+            return true;
+    }
+    return false;
+}
+
+static bool runSteps(const CardQuery* query, unsigned long long mask) {
+    bool stack[QUERY_MAX_STEPS];
+    int top = 0;
+
+    for (int i = 0; i < query->stepCount; i++) {
+        switch (query->steps[i].op) {
+        case QUERY_TERM:
+            stack[top++] = (mask >> query->steps[i].term) & 1;
+            break;
+        case QUERY_AND:
+            top--;
+            stack[top - 1] = stack[top - 1] && stack[top];
+            break;
+        case QUERY_OR:
+            top--;
+            stack[top - 1] = stack[top - 1] || stack[top];
+            break;
+        case QUERY_NOT:
+            stack[top - 1] = !stack[top - 1];
+            break;
+        }
+    }
+    return top == 1 && stack[0];
+}
+
+bool matchCardQuery(const CardQuery* query, LazyCard* card) {
+    unsigned long long all;
+    unsigned long long mask = 0;
+    Property* prop;
+    const char* line;
+    long length;
+
+    if (query == NULL || card == NULL) return false;
+    all = query->termCount == 64 ? ~0ULL : (1ULL << query->termCount) - 1;
+
+    for (int i = 0; i < card->propertyCount && mask != all; i++) {
+        if ((line = getLazyLine(card, i, &length)) && !mayMatchLine(query, line, length))
+            continue;
+        if (!(prop = getLazyProperty(card, i))) continue;
+
+        for (int t = 0; t < query->termCount; t++) {
+            if (!(mask & (1ULL << t)) && matchesProperty(&query->terms[t], prop)) mask |= 1ULL << t;
+        }
+    }
+    for (int t = 0; t < query->termCount; t++) {
+        if (matchesDate(&query->terms[t], "BDAY", card->birthday) || matchesDate(&query->terms[t], "ANNIVERSARY", card->anniversary))
+            mask |= 1ULL << t;
+    }
+
+    return runSteps(query, mask);
+}
+
+//***************************************** Directories *****************************************
+
+static void queryFile(int index, const char* file, void* arg) {
+    QueryJob* job = (QueryJob*) arg;
+    QuerySlot* slot = &job->slots[index];
+    LazyCard* card = NULL;
+    Property* fn;
+
+    if (createLazyCard((char*) file, &card) == OK && card->validation == OK) {
+        slot->isValid = true;
+        if (matchCardQuery(job->query, card) && (fn = getLazyProperty(card, 0))) {
+            slot->name = duplicateString(getFromFront(fn->values));
+            slot->isMatch = slot->name != NULL;
+        }
+    }
+    deleteLazyCard(card);
+}
+
+char* queryCardFiles(char* dirName, char* text) {
+    StringBuffer buffer;
+    CardQuery* query;
+    QueryJob job;
+    char** files;
+    char num[64];
+    int count;
+    int invalid = 0;
+    int errorOffset;
+    bool isFirst = true;
+
+    if (!(query = compileCardQuery(text, &errorOffset))) {
+        if (errorOffset < 0) return NULL;
+        sprintf(num, "Error: Invalid query at character %d", errorOffset + 1);
+        return duplicateString(num);
+    }
+    if (dirName == NULL || listCardFiles(dirName, &files, &count) != OK) {
+        freeCardQuery(query);
+        return duplicateString("Error: Cannot read directory");
+    }
+
+    job.query = query;
+    if (!(job.slots = calloc(count + 1, sizeof(QuerySlot))) || !initStringBuffer(&buffer)) {
+        free(job.slots);
+        freeCardFiles(files, count);
+        freeCardQuery(query);
+        return NULL;
+    }
+
+    forEachCardFile(files, count, queryFile, &job, 0);
+
+    appendString(&buffer, "{\"matches\":[");
+    for (int i = 0; i < count; i++) {
+        const char* base = strrchr(files[i], '/');
+
+        if (!job.slots[i].isValid) invalid++;
+        if (!job.slots[i].isMatch) continue;
+
+        appendString(&buffer, isFirst ? "{\"file\":" : ",{\"file\":");
+        appendJSONString(&buffer, base ? base + 1 : files[i]);
+        appendString(&buffer, ",\"name\":");
+        appendJSONString(&buffer, job.slots[i].name);
+        appendString(&buffer, "}");
+        free(job.slots[i].name);
+        isFirst = false;
+    }
+    sprintf(num, "],\"cards\":%d,\"invalid\":%d}", count - invalid, invalid);
+    appendString(&buffer, num);
+
+    free(job.slots);
+    freeCardFiles(files, count);
+    freeCardQuery(query);
+    return buffer.str;
+}
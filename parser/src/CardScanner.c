@@ -0,0 +1,493 @@
+/**
+ * @file CardScanner.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#define _DEFAULT_SOURCE
+
+#include "CardScanner.h"
+#include "ParserFunctions.h"
+#include "StringIntern.h"
+
+VCardErrorCode initCardScanner(CardScanner* scanner, FILE* fp) {
+    return initCardScannerBuffer(scanner, fp, NULL, 0);
+}
+
+VCardErrorCode initCardScannerBuffer(CardScanner* scanner, FILE* fp, char* line, size_t capacity) {
+    scanner->fp = fp;
+    scanner->lineLength = 0;
+    scanner->offset = 0;
+    scanner->length = 0;
+    scanner->position = 0;
+    scanner->isLast = false;
+    scanner->isEnd = false;
+    scanner->line = line;
+    scanner->capacity = capacity;
+    if (line == NULL || capacity == 0) {
+        scanner->capacity = BUFFERSIZE;
+        if (!(scanner->line = realloc(line, sizeof(char) * scanner->capacity))) return OTHER_ERROR;
+    }
+    scanner->line[0] = '\0';
+
+    return OK;
+}
+
+/* Appends one byte of a physical line, which may be the CR that ends it, keeping room for the terminator. */
+static VCardErrorCode appendChar(CardScanner* scanner, char c) {
+    size_t capacity;
+    char* grown;
+
+    // A line of MAX_LINE_LENGTH bytes still has its CR appended
+    if (scanner->lineLength > MAX_LINE_LENGTH) return INV_PROP;
+    if (scanner->lineLength + 1 >= scanner->capacity) {
+        capacity = scanner->capacity * 2;
+        if (capacity > (size_t) MAX_LINE_LENGTH + 2) capacity = (size_t) MAX_LINE_LENGTH + 2;
+        if (!(grown = realloc(scanner->line, sizeof(char) * capacity))) return OTHER_ERROR;
+        scanner->line = grown;
+        scanner->capacity = capacity;
+    }
+    scanner->line[scanner->lineLength++] = c;
+
+    return OK;
+}
+
+/* Reads the physical lines of one content line into the line buffer, unfolding them.  The caller holds the stream's lock. */
+static VCardErrorCode readPhysicalLines(CardScanner* scanner) {
+    VCardErrorCode err;
+    int c;
+
+    while (true) {
+        // One physical line, which must end in CRLF
+        while ((c = getc_unlocked(scanner->fp)) != EOF && c != '\n') {
+            if ((err = appendChar(scanner, c)) != OK) return err;
+            scanner->position++;
+        }
+        // A stream that fails, such as a compressed card past MAX_CARD_SIZE, is a bad file rather than a bad line
+        if (c == EOF) return ferror(scanner->fp) ? INV_FILE : INV_PROP;
+        scanner->position++;
+        if (scanner->lineLength == 0 || scanner->line[scanner->lineLength - 1] != '\r') return INV_PROP;
+        scanner->lineLength--;
+
+        // Line unfolding: a leading space continues the previous line
+        if ((c = getc_unlocked(scanner->fp)) == ' ') {
+            scanner->position++;
+            continue;
+        }
+        if (c == EOF && ferror(scanner->fp))
+            return INV_FILE;
+        if (c == EOF)
+            scanner->isLast = true;
+        else
+            ungetc(c, scanner->fp);
+        return OK;
+    }
+}
+
+VCardErrorCode nextContentLine(CardScanner* scanner) {
+    VCardErrorCode err;
+    int c;
+
+    scanner->lineLength = 0;
+    scanner->line[0] = '\0';
+    scanner->offset = scanner->position;
+    if (scanner->isEnd || scanner->isLast || (c = getc(scanner->fp)) == EOF) {
+        scanner->isEnd = true;
+        if (ferror(scanner->fp)) return INV_FILE;
+        // An empty stream is a malformed line, not an empty card
+        return scanner->position == 0 ? INV_PROP : OK;
+    }
+    ungetc(c, scanner->fp);
+
+    // The stream is locked once per content line rather than once per character
+    flockfile(scanner->fp);
+    err = readPhysicalLines(scanner);
+    funlockfile(scanner->fp);
+    if (err != OK) return err;
+
+    scanner->line[scanner->lineLength] = '\0';
+    scanner->length = scanner->position - scanner->offset;
+    return OK;
+}
+
+void freeCardScanner(CardScanner* scanner) {
+    free(scanner->line);
+    scanner->line = NULL;
+}
+
+void splitContentLine(char* line, char** groupName, char** propertyName, char** parameterValues, char** propertyValues) {
+    *propertyValues = strTokenizer(line, ':');
+    *parameterValues = strTokenizer(line, ';');
+    *propertyName = strTokenizer(line, '.');
+    if (*propertyName == NULL) {
+        *propertyName = line;
+        *groupName = NULL;
+    }
+    else {
+        *groupName = line;
+    }
+}
+
+/* Position of the delimiter strTokenizer would split str at, looking only at the first len bytes, or -1. */
+static int findDelimiter(const char* str, int len, char delimiter) {
+    if (len > 0 && str[0] == delimiter) return 0;
+
+    for (int i = 1; i < len; i++) {
+        if (str[i] == delimiter && str[i - 1] != '\\') return i;
+    }
+    return -1;
+}
+
+int countValues(const char* propertyValues) {
+    int count = 1;
+    int len;
+    int i;
+
+    if (propertyValues == NULL) return 0;
+
+    len = strlen(propertyValues);
+    while ((i = findDelimiter(propertyValues, len, ';')) >= 0) {
+        count++;
+        propertyValues += i + 1;
+        len -= i + 1;
+    }
+    return count;
+}
+
+/* Checks parameters the way addParams parses them: every ';'-separated entry needs a non-empty value after '='. */
+static VCardErrorCode checkParams(const char* parameterValues) {
+    int len;
+    int segment;
+    int equals;
+
+    if (parameterValues == NULL) return OK;
+
+    len = strlen(parameterValues);
+    while (true) {
+        if ((segment = findDelimiter(parameterValues, len, ';')) < 0) segment = len;
+        if ((equals = findDelimiter(parameterValues, segment, '=')) < 0) return INV_PROP;
+        if (equals + 1 >= segment) return INV_PROP;
+        if (segment == len) break;
+        parameterValues += segment + 1;
+        len -= segment + 1;
+    }
+    return OK;
+}
+
+VCardErrorCode buildProperty(Property** newProperty, char* groupName, char* propertyName, char* parameterValues, char* propertyValues) {
+    VCardErrorCode err;
+
+    if ((err = createProperty(newProperty)) != OK) return err;
+
+    if (groupName && !((*newProperty)->group = internName(groupName)))
+        err = OTHER_ERROR;
+    if (err == OK && !((*newProperty)->name = internName(propertyName)))
+        err = OTHER_ERROR;
+    if (err == OK && parameterValues)
+        err = addParams(*newProperty, parameterValues);
+    if (err == OK)
+        err = addValues(*newProperty, propertyValues);
+
+    if (err != OK) {
+        deleteProperty(*newProperty);
+        *newProperty = NULL;
+    }
+    return err;
+}
+
+void initCardCheck(CardCheck* check) {
+    initCardCheckLevel(check, VALIDATE_STRICT);
+}
+
+void initCardCheckLevel(CardCheck* check, ValidationLevel level) {
+    memset(check, 0, sizeof(CardCheck));
+    check->isFirstLine = true;
+    check->validation = OK;
+    check->level = level;
+    check->structure = OK;
+}
+
+VCardErrorCode getCheckResult(const CardCheck* check) {
+    if (check->level == VALIDATE_NONE) return OK;
+    if (check->level == VALIDATE_STRUCTURAL) return check->structure;
+
+    return check->validation;
+}
+
+static NameRule ruleForName(const char* name) {
+    char propNames[][11] = {"SOURCE", "XML", "NICNNAME", "PHOTO",
+            "EMAIL", "IMPP", "LANG", "TZ", "GEO", "TITLE", "ROLE",
+            "LOGO", "MEMBER", "RELATED", "CATEGORIES", "NOTE",
+            "SOUND", "URL", "KEY", "FBURL", "CALADRURI", "CALURI"};
+
+    if (stricasecmp(name, "KIND") == 0) return RULE_KIND;
+    if (stricasecmp(name, "N") == 0) return RULE_N;
+    if (stricasecmp(name, "GENDER") == 0) return RULE_GENDER;
+    if (stricasecmp(name, "PRODID") == 0) return RULE_PRODID;
+    if (stricasecmp(name, "REV") == 0) return RULE_REV;
+    if (stricasecmp(name, "UID") == 0) return RULE_UID;
+    if (stricasecmp(name, "ADR") == 0) return RULE_ADR;
+    if (stricasecmp(name, "TEL") == 0) return RULE_TEL;
+    if (stricasecmp(name, "ORG") == 0) return RULE_ORG;
+    if (stricasecmp(name, "CLIENTPIDMAP") == 0) return RULE_CLIENTPIDMAP;
+    if (stricasecmp(name, "BEGIN") == 0 || stricasecmp(name, "END") == 0 || stricasecmp(name, "VERSION") == 0)
+        return RULE_STRUCTURE;
+    if (stricasecmp(name, "BDAY") == 0 || stricasecmp(name, "ANNIVERSARY") == 0) return RULE_DATE;
+
+    for (int i = 0; i < 22; i++) {
+        if (stricasecmp(name, propNames[i]) == 0) return RULE_SINGLE;
+    }
+    return RULE_UNKNOWN;
+}
+
+/* Same rules as validateCard applies to each optional property. */
+static VCardErrorCode validateOptional(CardCheck* check, NameRule rule, int count) {
+    switch (rule) {
+    case RULE_KIND:
+        if (check->hasKind || count != 1) return INV_PROP;
+        check->hasKind = true;
+        return OK;
+    case RULE_N:
+        if (check->hasN || count != 5) return INV_PROP;
+        check->hasN = true;
+        return OK;
+    case RULE_GENDER:
+        if (check->hasGender || (count != 1 && count != 2)) return INV_PROP;
+        check->hasGender = true;
+        return OK;
+    case RULE_PRODID:
+        if (check->hasProdID || count != 1) return INV_PROP;
+        check->hasProdID = true;
+        return OK;
+    case RULE_REV:
+        if (check->hasRev || count != 1) return INV_PROP;
+        check->hasRev = true;
+        return OK;
+    case RULE_UID:
+        if (check->hasUID || count != 1) return INV_PROP;
+        check->hasUID = true;
+        return OK;
+    case RULE_ADR:
+        return count == 7 ? OK : INV_PROP;
+    case RULE_TEL:
+        return count == 1 || count == 2 ? OK : INV_PROP;
+    case RULE_ORG:
+        return count == 0 ? INV_PROP : OK;
+    case RULE_CLIENTPIDMAP:
+        return count == 2 ? OK : INV_PROP;
+    case RULE_STRUCTURE:
+        return INV_CARD;
+    case RULE_DATE:
+        return INV_DT;
+    case RULE_SINGLE:
+        return count == 1 ? OK : INV_PROP;
+    default:
+        return INV_PROP;
+    }
+}
+
+/* Records a line's facts.  The validation rule for an optional property is only looked up if hasRule is set. */
+static void describeLine(LineFacts* facts, const char* propertyName, const char* parameterValues, const char* propertyValues,
+        bool hasRule) {
+    memset(facts, 0, sizeof(LineFacts));
+    if (propertyName == NULL || strcmp(propertyName, "") == 0 || propertyValues == NULL || strcmp(propertyValues, "") == 0) {
+        facts->isEmpty = true;
+        return;
+    }
+
+    facts->isBeginCard = strcmp(propertyName, "BEGIN") == 0 && strcmp(propertyValues, "VCARD") == 0;
+    facts->isVersion = strcmp(propertyName, "VERSION") == 0;
+    facts->isVersionFour = strcmp(propertyValues, "4.0") == 0;
+    facts->isEndCard = strcmp(propertyName, "END") == 0 || strcmp(propertyValues, "VCARD") == 0;
+    facts->isTextDate = parameterValues == NULL || strcmp(parameterValues, "VALUE=text") == 0;
+    facts->paramsError = checkParams(parameterValues);
+    facts->valueCount = countValues(propertyValues);
+
+    if (facts->isVersion) facts->kind = LINE_HEADER;
+    else if (stricasecmp(propertyName, "FN") == 0) facts->kind = LINE_FN;
+    else if (stricasecmp(propertyName, "BDAY") == 0) facts->kind = LINE_BDAY;
+    else if (stricasecmp(propertyName, "ANNIVERSARY") == 0) facts->kind = LINE_ANNIVERSARY;
+    else {
+        facts->kind = LINE_OPTIONAL;
+        facts->rule = hasRule ? ruleForName(propertyName) : RULE_UNKNOWN;
+    }
+}
+
+void describeContentLine(LineFacts* facts, const char* propertyName, const char* parameterValues, const char* propertyValues) {
+    describeLine(facts, propertyName, parameterValues, propertyValues, true);
+}
+
+VCardErrorCode checkLineFacts(CardCheck* check, LineKind* kind, const LineFacts* facts, bool isLast) {
+    *kind = LINE_HEADER;
+    if (facts->isEmpty) return INV_PROP;
+
+    // Same order of checks as readCard
+    if (check->isFirstLine) {
+        if (!facts->isBeginCard) return INV_CARD;
+        check->isFirstLine = false;
+    }
+    else if (facts->isVersion) {
+        if (!facts->isVersionFour) return INV_CARD;
+        check->isVersionFour = true;
+    }
+    else if (facts->kind == LINE_FN) {
+        if (facts->paramsError != OK) return facts->paramsError;
+        *kind = LINE_FN;
+        check->hasFN = true;
+        check->fnValueCount = facts->valueCount;
+    }
+    else if (facts->kind == LINE_BDAY) {
+        *kind = LINE_BDAY;
+        if (facts->isTextDate) check->hasBirthday = true;
+    }
+    else if (facts->kind == LINE_ANNIVERSARY) {
+        *kind = LINE_ANNIVERSARY;
+        if (facts->isTextDate) check->hasAnniversary = true;
+    }
+    else if (isLast) {
+        if (facts->isEndCard) check->isEnd = true;
+    }
+    else {
+        if (facts->paramsError != OK) return facts->paramsError;
+        *kind = LINE_OPTIONAL;
+        check->optionalCount++;
+        if (check->level != VALIDATE_NONE) {
+            if (check->structure == OK && facts->rule == RULE_STRUCTURE)
+                check->structure = INV_CARD;
+            if (check->validation == OK)
+                check->validation = validateOptional(check, facts->rule, facts->valueCount);
+        }
+    }
+
+    return OK;
+}
+
+VCardErrorCode checkContentLine(CardCheck* check, LineKind* kind, const char* propertyName, const char* parameterValues,
+        const char* propertyValues, bool isLast) {
+    LineFacts facts;
+
+    describeLine(&facts, propertyName, parameterValues, propertyValues, check->level != VALIDATE_NONE);
+    return checkLineFacts(check, kind, &facts, isLast);
+}
+
+VCardErrorCode finishCardCheck(CardCheck* check) {
+    if (!check->hasFN) return INV_CARD;
+    if (!check->isVersionFour) return INV_CARD;
+    if (!check->isEnd) return INV_CARD;
+
+    if (check->fnValueCount != 1) check->validation = INV_PROP;
+    return OK;
+}
+
+VCardErrorCode readCardFromScanner(CardScanner* scanner, Card** newCardObject) {
+    CardCheck check;
+    LineKind kind;
+    Property* aProperty = NULL;
+    DateTime* aDateTime = NULL;
+    char* groupName;
+    char* propertyName;
+    char* parameterValues;
+    char* propertyValues;
+    VCardErrorCode err;
+
+    if (!(*newCardObject = malloc(sizeof(Card))))
+        return OTHER_ERROR;
+    (*newCardObject)->fn = NULL;
+    (*newCardObject)->birthday = NULL;
+    (*newCardObject)->anniversary = NULL;
+    if (!((*newCardObject)->optionalProperties = initializeList(printProperty, deleteProperty, compareProperties)))
+        return OTHER_ERROR;
+
+    initCardCheck(&check);
+    while ((err = nextContentLine(scanner)) == OK && !scanner->isEnd) {
+        splitContentLine(scanner->line, &groupName, &propertyName, &parameterValues, &propertyValues);
+        if ((err = checkContentLine(&check, &kind, propertyName, parameterValues, propertyValues, scanner->isLast)) != OK)
+            break;
+
+        if (kind == LINE_FN) {
+            if ((err = buildProperty(&aProperty, groupName, propertyName, parameterValues, propertyValues)) != OK)
+                break;
+            deleteProperty((*newCardObject)->fn);
+            (*newCardObject)->fn = aProperty;
+        }
+        else if (kind == LINE_OPTIONAL) {
+            if ((err = buildProperty(&aProperty, groupName, propertyName, parameterValues, propertyValues)) != OK)
+                break;
+            insertBack((*newCardObject)->optionalProperties, aProperty);
+        }
+        else if (kind == LINE_BDAY || kind == LINE_ANNIVERSARY) {
+            DateTime** date = kind == LINE_BDAY ? &(*newCardObject)->birthday : &(*newCardObject)->anniversary;
+
+            aDateTime = NULL;
+            if (createDateTime(&aDateTime, parameterValues, propertyValues) == OK) {
+                deleteDate(*date);
+                *date = aDateTime;
+            }
+        }
+    }
+
+    if (err == OK) err = finishCardCheck(&check);
+    return err;
+}
+
+VCardErrorCode summarizeStream(FILE* fp, char** name, int* opLength, bool* isInvalid) {
+    CardScanner scanner;
+    VCardErrorCode err;
+
+    *name = NULL;
+    *opLength = 0;
+    *isInvalid = false;
+
+    if ((err = initCardScanner(&scanner, fp)) != OK) return err;
+    err = summarizeScanner(&scanner, name, opLength, isInvalid);
+    freeCardScanner(&scanner);
+
+    return err;
+}
+
+VCardErrorCode summarizeScanner(CardScanner* scanner, char** name, int* opLength, bool* isInvalid) {
+    return summarizeScannerLevel(scanner, VALIDATE_STRICT, name, opLength, isInvalid);
+}
+
+VCardErrorCode summarizeScannerLevel(CardScanner* scanner, ValidationLevel level, char** name, int* opLength, bool* isInvalid) {
+    CardCheck check;
+    LineKind kind;
+    Property* fn = NULL;
+    char* groupName;
+    char* propertyName;
+    char* parameterValues;
+    char* propertyValues;
+    VCardErrorCode err;
+
+    *name = NULL;
+    *opLength = 0;
+    *isInvalid = false;
+
+    initCardCheckLevel(&check, level);
+
+    // Only FN is built, and only so its first value comes out exactly as addValues stores it
+    while ((err = nextContentLine(scanner)) == OK && !scanner->isEnd) {
+        splitContentLine(scanner->line, &groupName, &propertyName, &parameterValues, &propertyValues);
+        if ((err = checkContentLine(&check, &kind, propertyName, parameterValues, propertyValues, scanner->isLast)) != OK)
+            break;
+
+        if (kind == LINE_FN) {
+            deleteProperty(fn);
+            if ((err = buildProperty(&fn, groupName, propertyName, parameterValues, propertyValues)) != OK)
+                break;
+        }
+    }
+
+    if (err == OK) err = finishCardCheck(&check);
+    if (err == OK && getCheckResult(&check) != OK) {
+        err = getCheckResult(&check);
+        *isInvalid = true;
+    }
+    if (err == OK) {
+        *opLength = check.optionalCount + check.hasBirthday + check.hasAnniversary;
+        if (!(*name = duplicateString(getFromFront(fn->values)))) err = OTHER_ERROR;
+    }
+
+    deleteProperty(fn);
+    return err;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file CardTrust.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#define _DEFAULT_SOURCE
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "CardTrust.h"
+
+#define MARKER_VERSION 1
+
+/* Builds ".<name>.trusted" in the card's directory. */
+static char* markerPath(const char* fileName) {
+    const char* base = strrchr(fileName, '/');
+    size_t dirLength = base ? base - fileName + 1 : 0;
+    char* path;
+
+    base = base ? base + 1 : fileName;
+    if (!(path = malloc(sizeof(char) * (strlen(fileName) + 10)))) return NULL;
+
+    memcpy(path, fileName, dirLength);
+    sprintf(path + dirLength, ".%s.trusted", base);
+    return path;
+}
+
+/* Writes the line a marker holds for the file's current state. */
+static bool describeFile(const char* fileName, char* line, size_t size) {
+    struct stat st;
+
+    if (stat(fileName, &st) != 0 || !S_ISREG(st.st_mode)) return false;
+
+    snprintf(line, size, "%d %llu %lld %lld.%09ld %lld.%09ld\n", MARKER_VERSION, (unsigned long long) st.st_ino,
+            (long long) st.st_size, (long long) st.st_mtim.tv_sec, st.st_mtim.tv_nsec,
+            (long long) st.st_ctim.tv_sec, st.st_ctim.tv_nsec);
+    return true;
+}
+
+VCardErrorCode markCardTrusted(const char* fileName) {
+    char line[128];
+    char* path;
+    FILE* fp;
+    VCardErrorCode err = OK;
+
+    if (fileName == NULL || !describeFile(fileName, line, sizeof(line))) return INV_FILE;
+    if (!(path = markerPath(fileName))) return OTHER_ERROR;
+
+    if (!(fp = fopen(path, "w"))) {
+        free(path);
+        return WRITE_ERROR;
+    }
+    if (fputs(line, fp) == EOF) err = WRITE_ERROR;
+    if (fclose(fp) != 0) err = WRITE_ERROR;
+    if (err != OK) unlink(path);
+
+    free(path);
+    return err;
+}
+
+bool isCardTrusted(const char* fileName) {
+    char expected[128];
+    char recorded[128];
+    char* path;
+    FILE* fp;
+    bool isTrusted = false;
+
+    if (fileName == NULL || !describeFile(fileName, expected, sizeof(expected))) return false;
+    if (!(path = markerPath(fileName))) return false;
+
+    if ((fp = fopen(path, "r")) != NULL) {
+        isTrusted = fgets(recorded, sizeof(recorded), fp) != NULL && strcmp(recorded, expected) == 0;
+        fclose(fp);
+    }
+
+    free(path);
+    return isTrusted;
+}
+
+void clearCardTrust(const char* fileName) {
+    char* path;
+
+    if (fileName == NULL || !(path = markerPath(fileName))) return;
+
+    unlink(path);
+    free(path);
+}
+
+VCardErrorCode writeTrustedCard(const char* fileName, const Card* obj) {
+    VCardErrorCode err;
+
+    if ((err = validateCard(obj)) != OK) return err;
+    if ((err = writeCard(fileName, obj)) != OK) return err;
+
+    return markCardTrusted(fileName);
+}
+
+ValidationLevel resolveValidationLevel(const char* fileName, ValidationLevel level) {
+    if (level != VALIDATE_TRUSTED) return level;
+
+    return isCardTrusted(fileName) ? VALIDATE_NONE : VALIDATE_STRICT;
+}
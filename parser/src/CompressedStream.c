@@ -0,0 +1,317 @@
+/**
+ * @file CompressedStream.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "CompressedStream.h"
+#include "ParserFunctions.h"
+
+#define CHUNKSIZE 65536
+
+typedef struct compressedStream {
+    // Stream of compressed bytes, from fopen or fmemopen, or the file compressed bytes are written to
+    FILE*           source;
+    Compression     type;
+    bool            isWriting;
+    bool            isEnd;
+    // Decompressed bytes returned so far
+    size_t          produced;
+    // Compressed bytes read, or waiting to be written
+    unsigned char   in[CHUNKSIZE];
+    z_stream        zs;
+#ifdef HAVE_ZSTD
+    ZSTD_DStream*   zds;
+    ZSTD_inBuffer   zin;
+    ZSTD_CStream*   zcs;
+#endif
+} CompressedStream;
+
+static bool endsWith(const char* str, const char* suffix) {
+    if (strlen(str) < strlen(suffix)) return false;
+
+    return strcmp(&str[strlen(str) - strlen(suffix)], suffix) == 0;
+}
+
+Compression compressionFromName(const char* fileName) {
+    if (fileName == NULL) return PLAIN;
+    if (endsWith(fileName, ".vcf.gz")) return GZIP;
+    if (endsWith(fileName, ".vcf.zst")) return ZSTD;
+
+    return PLAIN;
+}
+
+Compression compressionFromData(const char* data, size_t len) {
+    const unsigned char* bytes = (const unsigned char*) data;
+
+    if (data == NULL) return PLAIN;
+    if (len >= 2 && bytes[0] == 0x1f && bytes[1] == 0x8b) return GZIP;
+    if (len >= 4 && bytes[0] == 0x28 && bytes[1] == 0xb5 && bytes[2] == 0x2f && bytes[3] == 0xfd) return ZSTD;
+
+    return PLAIN;
+}
+
+static ssize_t readGzip(CompressedStream* stream, char* buf, size_t size) {
+    size_t n;
+    int ret;
+
+    stream->zs.next_out = (unsigned char*) buf;
+    stream->zs.avail_out = size;
+
+    while (stream->zs.avail_out == size && !stream->isEnd) {
+        if (stream->zs.avail_in == 0) {
+            if ((n = fread(stream->in, 1, CHUNKSIZE, stream->source)) == 0) {
+                stream->isEnd = true;
+                break;
+            }
+            stream->zs.next_in = stream->in;
+            stream->zs.avail_in = n;
+        }
+
+        ret = inflate(&stream->zs, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END) {
+            // Concatenated gzip members are decoded as one stream, like gunzip does
+            if (stream->zs.avail_in > 0 || !feof(stream->source))
+                inflateReset(&stream->zs);
+            else
+                stream->isEnd = true;
+        }
+        else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            return -1;
+        }
+    }
+
+    return size - stream->zs.avail_out;
+}
+
+#ifdef HAVE_ZSTD
+static ssize_t readZstd(CompressedStream* stream, char* buf, size_t size) {
+    ZSTD_outBuffer out = { buf, size, 0 };
+    size_t ret;
+
+    while (out.pos == 0 && !stream->isEnd) {
+        if (stream->zin.pos == stream->zin.size) {
+            if ((stream->zin.size = fread(stream->in, 1, CHUNKSIZE, stream->source)) == 0) {
+                stream->isEnd = true;
+                break;
+            }
+            stream->zin.src = stream->in;
+            stream->zin.pos = 0;
+        }
+
+        ret = ZSTD_decompressStream(stream->zds, &out, &stream->zin);
+        if (ZSTD_isError(ret)) return -1;
+    }
+
+    return out.pos;
+}
+#endif
+
+/* Stops with an error one byte past MAX_CARD_SIZE, so a card of exactly that size still reads. */
+static ssize_t readCompressed(void* cookie, char* buf, size_t size) {
+    CompressedStream* stream = (CompressedStream*) cookie;
+    ssize_t n;
+
+    if (stream->produced > MAX_CARD_SIZE) {
+        errno = EFBIG;
+        return -1;
+    }
+    if (size > MAX_CARD_SIZE + 1 - stream->produced) size = MAX_CARD_SIZE + 1 - stream->produced;
+
+#ifdef HAVE_ZSTD
+    if (stream->type == ZSTD) n = readZstd(stream, buf, size);
+    else
+#endif
+    n = readGzip(stream, buf, size);
+
+    if (n > 0 && (stream->produced += n) > MAX_CARD_SIZE) {
+        errno = EFBIG;
+        return -1;
+    }
+    return n;
+}
+
+/* Deflates size bytes, or finishes the gzip member when isFinal, writing whatever is produced to source. */
+static bool writeGzip(CompressedStream* stream, const char* buf, size_t size, bool isFinal) {
+    size_t n;
+    int ret;
+
+    stream->zs.next_in = (unsigned char*) buf;
+    stream->zs.avail_in = size;
+
+    do {
+        stream->zs.next_out = stream->in;
+        stream->zs.avail_out = CHUNKSIZE;
+        ret = deflate(&stream->zs, isFinal ? Z_FINISH : Z_NO_FLUSH);
+        if (ret == Z_STREAM_ERROR) return false;
+
+        n = CHUNKSIZE - stream->zs.avail_out;
+        if (n > 0 && fwrite(stream->in, 1, n, stream->source) != n) return false;
+    } while (stream->zs.avail_out == 0 || (isFinal && ret != Z_STREAM_END));
+
+    return true;
+}
+
+#ifdef HAVE_ZSTD
+static bool writeZstd(CompressedStream* stream, const char* buf, size_t size, bool isFinal) {
+    ZSTD_inBuffer in = { buf, size, 0 };
+    ZSTD_outBuffer out;
+    size_t ret;
+
+    do {
+        out.dst = stream->in;
+        out.size = CHUNKSIZE;
+        out.pos = 0;
+        ret = ZSTD_compressStream2(stream->zcs, &out, &in, isFinal ? ZSTD_e_end : ZSTD_e_continue);
+        if (ZSTD_isError(ret)) return false;
+
+        if (out.pos > 0 && fwrite(stream->in, 1, out.pos, stream->source) != out.pos) return false;
+    } while (in.pos < in.size || (isFinal && ret != 0));
+
+    return true;
+}
+#endif
+
+static ssize_t writeCompressed(void* cookie, const char* buf, size_t size) {
+    CompressedStream* stream = (CompressedStream*) cookie;
+    bool result;
+
+#ifdef HAVE_ZSTD
+    if (stream->type == ZSTD) result = writeZstd(stream, buf, size, false);
+    else
+#endif
+    result = writeGzip(stream, buf, size, false);
+
+    // A short write tells stdio the stream failed
+    return result ? (ssize_t) size : 0;
+}
+
+static int closeCompressed(void* cookie) {
+    CompressedStream* stream = (CompressedStream*) cookie;
+    int result = 0;
+
+    if (stream->isWriting) {
+#ifdef HAVE_ZSTD
+        if (stream->type == ZSTD && !writeZstd(stream, NULL, 0, true)) result = EOF;
+#endif
+        if (stream->type == GZIP && !writeGzip(stream, NULL, 0, true)) result = EOF;
+        if (stream->type == GZIP) deflateEnd(&stream->zs);
+#ifdef HAVE_ZSTD
+        if (stream->type == ZSTD) ZSTD_freeCStream(stream->zcs);
+#endif
+    }
+    else {
+        if (stream->type == GZIP) inflateEnd(&stream->zs);
+#ifdef HAVE_ZSTD
+        if (stream->type == ZSTD) ZSTD_freeDStream(stream->zds);
+#endif
+    }
+    if (fclose(stream->source) != 0) result = EOF;
+    free(stream);
+
+    return result;
+}
+
+/* Wraps a stream of compressed bytes in a stdio stream of decompressed bytes.  Takes ownership of source. */
+static FILE* wrapCompressed(FILE* source, Compression type) {
+    cookie_io_functions_t functions = { readCompressed, NULL, NULL, closeCompressed };
+    CompressedStream* stream;
+    FILE* fp;
+
+    if (source == NULL) return NULL;
+    if (type == PLAIN) return source;
+#ifndef HAVE_ZSTD
+    if (type == ZSTD) {
+        fclose(source);
+        return NULL;
+    }
+#endif
+
+    if (!(stream = calloc(1, sizeof(CompressedStream)))) {
+        fclose(source);
+        return NULL;
+    }
+    stream->source = source;
+    stream->type = type;
+
+    if (type == GZIP && inflateInit2(&stream->zs, 15 + 16) != Z_OK) {
+        fclose(source);
+        free(stream);
+        return NULL;
+    }
+#ifdef HAVE_ZSTD
+    if (type == ZSTD && (!(stream->zds = ZSTD_createDStream()) || ZSTD_isError(ZSTD_initDStream(stream->zds)))) {
+        ZSTD_freeDStream(stream->zds);
+        fclose(source);
+        free(stream);
+        return NULL;
+    }
+#endif
+
+    if (!(fp = fopencookie(stream, "r", functions))) {
+        closeCompressed(stream);
+        return NULL;
+    }
+    return fp;
+}
+
+FILE* openCardFile(const char* fileName) {
+    if (fileName == NULL) return NULL;
+
+    return wrapCompressed(fopen(fileName, "r"), compressionFromName(fileName));
+}
+
+FILE* openCardBuffer(const char* data, size_t len) {
+    if (data == NULL || len == 0) return NULL;
+
+    return wrapCompressed(fmemopen((void*) data, len, "r"), compressionFromData(data, len));
+}
+
+FILE* createCardFile(const char* fileName, Compression type) {
+    cookie_io_functions_t functions = { NULL, writeCompressed, NULL, closeCompressed };
+    CompressedStream* stream;
+    FILE* source;
+    FILE* fp;
+
+    if (fileName == NULL) return NULL;
+#ifndef HAVE_ZSTD
+    if (type == ZSTD) return NULL;
+#endif
+    if (!(source = fopen(fileName, "w"))) return NULL;
+    if (type == PLAIN) return source;
+
+    if (!(stream = calloc(1, sizeof(CompressedStream)))) {
+        fclose(source);
+        return NULL;
+    }
+    stream->source = source;
+    stream->type = type;
+    stream->isWriting = true;
+
+    if (type == GZIP && deflateInit2(&stream->zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        fclose(source);
+        free(stream);
+        return NULL;
+    }
+#ifdef HAVE_ZSTD
+    if (type == ZSTD && !(stream->zcs = ZSTD_createCStream())) {
+        fclose(source);
+        free(stream);
+        return NULL;
+    }
+#endif
+
+    if (!(fp = fopencookie(stream, "w", functions))) {
+        closeCompressed(stream);
+        return NULL;
+    }
+    return fp;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file Corpus.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#define _DEFAULT_SOURCE
+
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "Corpus.h"
+#include "ParserFunctions.h"
+
+typedef struct corpusJob {
+    char**  files;
+    int     count;
+    int     next;
+    pthread_mutex_t lock;
+    void    (*work)(int index, const char* file, void* arg);
+    void*   arg;
+} CorpusJob;
+
+static int compareFileNames(const void* first, const void* second) {
+    return strcmp(*(char* const*) first, *(char* const*) second);
+}
+
+VCardErrorCode listCardFiles(const char* dirName, char*** files, int* count) {
+    DIR* dir;
+    struct dirent* entry;
+    char** list = NULL;
+    char** grown;
+    int capacity = 0;
+    int n = 0;
+
+    *files = NULL;
+    *count = 0;
+    if (dirName == NULL) return INV_FILE;
+    if (!(dir = opendir(dirName))) return INV_FILE;
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        if (!hasCardExtension(entry->d_name)) continue;
+
+        if (n == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            if (!(grown = realloc(list, sizeof(char*) * capacity))) {
+                freeCardFiles(list, n);
+                closedir(dir);
+                return OTHER_ERROR;
+            }
+            list = grown;
+        }
+        if (!(list[n] = malloc(sizeof(char) * (strlen(dirName) + strlen(entry->d_name) + 2)))) {
+            freeCardFiles(list, n);
+            closedir(dir);
+            return OTHER_ERROR;
+        }
+        sprintf(list[n], "%s/%s", dirName, entry->d_name);
+        n++;
+    }
+    closedir(dir);
+
+    if (n > 0) qsort(list, n, sizeof(char*), compareFileNames);
+    *files = list;
+    *count = n;
+    return OK;
+}
+
+void freeCardFiles(char** files, int count) {
+    if (files == NULL) return;
+
+    for (int i = 0; i < count; i++)
+        free(files[i]);
+    free(files);
+}
+
+static void* corpusWorker(void* data) {
+    CorpusJob* job = (CorpusJob*) data;
+    int i;
+
+    while (true) {
+        pthread_mutex_lock(&job->lock);
+        i = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (i >= job->count) break;
+
+        job->work(i, job->files[i], job->arg);
+    }
+
+    return NULL;
+}
+
+void forEachCardFile(char** files, int count, void (*work)(int index, const char* file, void* arg), void* arg, int threads) {
+    CorpusJob job;
+    pthread_t* workers;
+    int started = 0;
+
+    if (files == NULL || work == NULL || count <= 0) return;
+    if (threads <= 0) threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > count) threads = count;
+    if (threads < 1) threads = 1;
+
+    job.files = files;
+    job.count = count;
+    job.next = 0;
+    job.work = work;
+    job.arg = arg;
+    pthread_mutex_init(&job.lock, NULL);
+
+    // Any thread that cannot be started just leaves more work for the calling thread
+    if ((workers = malloc(sizeof(pthread_t) * threads))) {
+        for (int i = 1; i < threads; i++) {
+            if (pthread_create(&workers[started], NULL, corpusWorker, &job) == 0)
+                started++;
+        }
+    }
+    corpusWorker(&job);
+    for (int i = 0; i < started; i++)
+        pthread_join(workers[i], NULL);
+
+    free(workers);
+    pthread_mutex_destroy(&job.lock);
+}
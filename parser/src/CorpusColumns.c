@@ -0,0 +1,550 @@
+/**
+ * @file CorpusColumns.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#include "CorpusColumns.h"
+#include "Corpus.h"
+#include "LazyCard.h"
+#include "ParserFunctions.h"
+
+// Cards parsed in parallel before being appended, which bounds how many Card graphs are alive at once
+#define BATCHSIZE 256
+#define TOPPARAMETERS 20
+
+static bool resizeArray(void** array, size_t count, size_t size) {
+    void* grown;
+
+    if (!(grown = realloc(*array, count * size))) return false;
+    *array = grown;
+    return true;
+}
+
+static int nextCapacity(int capacity, int needed) {
+    if (capacity == 0) capacity = 1024;
+    while (capacity < needed) capacity *= 2;
+    return capacity;
+}
+
+static bool ensureCards(CorpusColumns* columns, int needed) {
+    int capacity;
+
+    if (needed <= columns->cardCapacity) return true;
+    capacity = nextCapacity(columns->cardCapacity, needed);
+    if (!resizeArray((void**) &columns->cardFile, capacity, sizeof(int))) return false;
+    if (!resizeArray((void**) &columns->cardFirstRow, capacity + 1, sizeof(int))) return false;
+    columns->cardCapacity = capacity;
+    return true;
+}
+
+static bool ensureRows(CorpusColumns* columns, int needed) {
+    int capacity;
+
+    if (needed <= columns->rowCapacity) return true;
+    capacity = nextCapacity(columns->rowCapacity, needed);
+    if (!resizeArray((void**) &columns->rowCard, capacity, sizeof(int))) return false;
+    if (!resizeArray((void**) &columns->rowName, capacity, sizeof(int))) return false;
+    if (!resizeArray((void**) &columns->rowGroup, capacity, sizeof(int))) return false;
+    if (!resizeArray((void**) &columns->rowFirstParam, capacity + 1, sizeof(int))) return false;
+    if (!resizeArray((void**) &columns->rowFirstValue, capacity + 1, sizeof(int))) return false;
+    columns->rowCapacity = capacity;
+    return true;
+}
+
+static bool ensureParams(CorpusColumns* columns, int needed) {
+    int capacity;
+
+    if (needed <= columns->paramCapacity) return true;
+    capacity = nextCapacity(columns->paramCapacity, needed);
+    if (!resizeArray((void**) &columns->paramName, capacity, sizeof(int))) return false;
+    if (!resizeArray((void**) &columns->paramValue, capacity, sizeof(int))) return false;
+    columns->paramCapacity = capacity;
+    return true;
+}
+
+static int probeString(const CorpusColumns* columns, const char* str, unsigned long long hash) {
+    size_t i = hash & (columns->slotCapacity - 1);
+
+    while (columns->stringSlots[i] != 0) {
+        if (strcmp(columns->strings[columns->stringSlots[i] - 1], str) == 0) break;
+        i = (i + 1) & (columns->slotCapacity - 1);
+    }
+    return i;
+}
+
+static bool growSlots(CorpusColumns* columns) {
+    int capacity = columns->slotCapacity == 0 ? 1024 : columns->slotCapacity * 2;
+    int* slots;
+    int* old = columns->stringSlots;
+
+    if (!(slots = calloc(capacity, sizeof(int)))) return false;
+    columns->stringSlots = slots;
+    columns->slotCapacity = capacity;
+    for (int id = 0; id < columns->stringCount; id++)
+        slots[probeString(columns, columns->strings[id], hashString(columns->strings[id]))] = id + 1;
+    free(old);
+
+    return true;
+}
+
+/* Returns the dictionary id of str, adding it if needed, or -1 if memory runs out. */
+static int addColumnString(CorpusColumns* columns, const char* str, bool isName) {
+    char* key;
+    int slot;
+
+    if (!(key = duplicateString(str))) return -1;
+    if (isName) {
+        for (int i = 0; key[i]; i++)
+            key[i] = toupper((unsigned char) key[i]);
+    }
+
+    if ((columns->stringCount + 1) * 2 > columns->slotCapacity && !growSlots(columns)) {
+        free(key);
+        return -1;
+    }
+    slot = probeString(columns, key, hashString(key));
+    if (columns->stringSlots[slot] != 0) {
+        free(key);
+        return columns->stringSlots[slot] - 1;
+    }
+
+    if (columns->stringCount == columns->stringCapacity) {
+        int capacity = nextCapacity(columns->stringCapacity, columns->stringCount + 1);
+
+        if (!resizeArray((void**) &columns->strings, capacity, sizeof(char*))) {
+            free(key);
+            return -1;
+        }
+        columns->stringCapacity = capacity;
+    }
+    columns->strings[columns->stringCount] = key;
+    columns->stringSlots[slot] = ++columns->stringCount;
+
+    return columns->stringCount - 1;
+}
+
+static bool appendValue(CorpusColumns* columns, const char* value) {
+    size_t length = strlen(value) + 1;
+    size_t capacity;
+
+    if (columns->valueCount == columns->valueCapacity) {
+        int count = nextCapacity(columns->valueCapacity, columns->valueCount + 1);
+
+        if (!resizeArray((void**) &columns->valueOffset, count, sizeof(size_t))) return false;
+        columns->valueCapacity = count;
+    }
+    if (columns->heapUsed + length > columns->heapCapacity) {
+        capacity = columns->heapCapacity == 0 ? 65536 : columns->heapCapacity;
+        while (columns->heapUsed + length > capacity)
+            capacity *= 2;
+        if (!resizeArray((void**) &columns->valueHeap, capacity, sizeof(char))) return false;
+        columns->heapCapacity = capacity;
+    }
+
+    memcpy(columns->valueHeap + columns->heapUsed, value, length);
+    columns->valueOffset[columns->valueCount++] = columns->heapUsed;
+    columns->heapUsed += length;
+    return true;
+}
+
+/* Starts a row for the current card.  Its parameters and values are appended after it. */
+static bool beginRow(CorpusColumns* columns, const char* name, const char* group) {
+    int row = columns->rowCount;
+
+    if (!ensureRows(columns, row + 1)) return false;
+    columns->rowCard[row] = columns->cardCount;
+    if ((columns->rowName[row] = addColumnString(columns, name, true)) < 0) return false;
+    if ((columns->rowGroup[row] = addColumnString(columns, group, false)) < 0) return false;
+    columns->rowFirstParam[row] = columns->paramCount;
+    columns->rowFirstValue[row] = columns->valueCount;
+    columns->rowCount++;
+    return true;
+}
+
+/* Closes the last row, so rowFirstParam and rowFirstValue always have a trailing entry. */
+static void endRow(CorpusColumns* columns) {
+    columns->rowFirstParam[columns->rowCount] = columns->paramCount;
+    columns->rowFirstValue[columns->rowCount] = columns->valueCount;
+}
+
+static bool appendProperty(CorpusColumns* columns, const Property* prop) {
+    ListIterator iter;
+    Parameter* param;
+    char* value;
+
+    if (!beginRow(columns, prop->name, prop->group)) return false;
+
+    iter = createIterator(prop->parameters);
+    while ((param = nextElement(&iter)) != NULL) {
+        int nameId;
+        int valueId;
+
+        if (!ensureParams(columns, columns->paramCount + 1)) return false;
+        if ((nameId = addColumnString(columns, param->name, true)) < 0) return false;
+        if ((valueId = addColumnString(columns, param->value, false)) < 0) return false;
+        columns->paramName[columns->paramCount] = nameId;
+        columns->paramValue[columns->paramCount++] = valueId;
+    }
+
+    // Columns are kept between queries, so embedded photos and the like are not copied into them
+    iter = createIterator(prop->values);
+    while ((value = nextElement(&iter)) != NULL) {
+        if (!appendValue(columns, strlen(value) >= LARGE_VALUE_SIZE ? "" : value)) return false;
+    }
+
+    endRow(columns);
+    return true;
+}
+
+static bool appendDate(CorpusColumns* columns, const char* name, const DateTime* date) {
+    char value[20];
+    bool result;
+
+    if (!beginRow(columns, name, "")) return false;
+    if (date->isText) {
+        result = appendValue(columns, date->text);
+    }
+    else {
+        snprintf(value, sizeof(value), "%s%s%s%s", date->date, strcmp(date->time, "") != 0 ? "T" : "", date->time,
+                date->UTC ? "Z" : "");
+        result = appendValue(columns, value);
+    }
+
+    endRow(columns);
+    return result;
+}
+
+static bool appendCard(CorpusColumns* columns, int file, const Card* card) {
+    ListIterator iter;
+    Property* prop;
+
+    if (!ensureCards(columns, columns->cardCount + 1)) return false;
+    columns->cardFile[columns->cardCount] = file;
+    columns->cardFirstRow[columns->cardCount] = columns->rowCount;
+
+    if (!appendProperty(columns, card->fn)) return false;
+    iter = createIterator(card->optionalProperties);
+    while ((prop = nextElement(&iter)) != NULL) {
+        if (!appendProperty(columns, prop)) return false;
+    }
+    if (card->birthday && !appendDate(columns, "BDAY", card->birthday)) return false;
+    if (card->anniversary && !appendDate(columns, "ANNIVERSARY", card->anniversary)) return false;
+
+    columns->cardCount++;
+    columns->cardFirstRow[columns->cardCount] = columns->rowCount;
+    return true;
+}
+
+static void parseBatchCard(int index, const char* file, void* arg) {
+    Card** cards = (Card**) arg;
+
+    if (createCard((char*) file, &cards[index]) != OK || validateCard(cards[index]) != OK) {
+        deleteCard(cards[index]);
+        cards[index] = NULL;
+    }
+}
+
+VCardErrorCode buildCorpusColumns(const char* dirName, CorpusColumns** columns) {
+    Card* cards[BATCHSIZE];
+    VCardErrorCode err;
+    bool isComplete = true;
+    int batch;
+
+    if (!(*columns = calloc(1, sizeof(CorpusColumns)))) return OTHER_ERROR;
+    if ((err = listCardFiles(dirName, &(*columns)->files, &(*columns)->fileCount)) != OK) {
+        free(*columns);
+        *columns = NULL;
+        return err;
+    }
+    if (!ensureCards(*columns, 1) || !ensureRows(*columns, 1)) isComplete = false;
+    else {
+        (*columns)->cardFirstRow[0] = 0;
+        endRow(*columns);
+    }
+
+    for (int start = 0; start < (*columns)->fileCount && isComplete; start += BATCHSIZE) {
+        batch = (*columns)->fileCount - start < BATCHSIZE ? (*columns)->fileCount - start : BATCHSIZE;
+        memset(cards, 0, sizeof(cards));
+        forEachCardFile((*columns)->files + start, batch, parseBatchCard, cards, 0);
+
+        // Appended in file order, so card ids follow the sorted file list
+        for (int i = 0; i < batch; i++) {
+            if (cards[i] == NULL)
+                (*columns)->invalidCount++;
+            else if (isComplete && !appendCard(*columns, start + i, cards[i]))
+                isComplete = false;
+            deleteCard(cards[i]);
+        }
+    }
+
+    if (!isComplete) {
+        freeCorpusColumns(*columns);
+        *columns = NULL;
+        return OTHER_ERROR;
+    }
+    return OK;
+}
+
+void freeCorpusColumns(CorpusColumns* columns) {
+    if (columns == NULL) return;
+
+    freeCardFiles(columns->files, columns->fileCount);
+    free(columns->cardFile);
+    free(columns->cardFirstRow);
+    free(columns->rowCard);
+    free(columns->rowName);
+    free(columns->rowGroup);
+    free(columns->rowFirstParam);
+    free(columns->rowFirstValue);
+    free(columns->paramName);
+    free(columns->paramValue);
+    free(columns->valueOffset);
+    free(columns->valueHeap);
+    for (int i = 0; i < columns->stringCount; i++)
+        free(columns->strings[i]);
+    free(columns->strings);
+    free(columns->stringSlots);
+    free(columns);
+}
+
+int findColumnString(const CorpusColumns* columns, const char* str) {
+    int slot;
+
+    if (columns == NULL || str == NULL || columns->slotCapacity == 0) return -1;
+
+    slot = probeString(columns, str, hashString(str));
+    return columns->stringSlots[slot] - 1;
+}
+
+void countByString(const int* column, int rows, int* counts) {
+    for (int i = 0; i < rows; i++)
+        counts[column[i]]++;
+}
+
+void countPerCard(const CorpusColumns* columns, int nameId, int* perCard) {
+    for (int c = 0; c < columns->cardCount; c++)
+        perCard[c] = 0;
+    for (int row = 0; row < columns->rowCount; row++) {
+        if (nameId < 0 || columns->rowName[row] == nameId)
+            perCard[columns->rowCard[row]]++;
+    }
+}
+
+const char* getColumnValue(const CorpusColumns* columns, int row, int index) {
+    if (columns == NULL || row < 0 || row >= columns->rowCount) return NULL;
+    if (index < 0 || columns->rowFirstValue[row] + index >= columns->rowFirstValue[row + 1]) return NULL;
+
+    return columns->valueHeap + columns->valueOffset[columns->rowFirstValue[row] + index];
+}
+
+//***************************************** Statistics *****************************************
+
+typedef struct nameStat {
+    int     id;
+    int     count;
+    int     cards;
+    int     multiple;
+} NameStat;
+
+typedef struct pairStat {
+    long long   key;
+    int         count;
+} PairStat;
+
+static int compareInts(const void* first, const void* second) {
+    int one = *(const int*) first;
+    int two = *(const int*) second;
+
+    return (one > two) - (one < two);
+}
+
+static int compareLongs(const void* first, const void* second) {
+    long long one = *(const long long*) first;
+    long long two = *(const long long*) second;
+
+    return (one > two) - (one < two);
+}
+
+static int compareNameStats(const void* first, const void* second) {
+    const NameStat* one = (const NameStat*) first;
+    const NameStat* two = (const NameStat*) second;
+
+    if (one->count != two->count) return two->count - one->count;
+    return one->id - two->id;
+}
+
+static int comparePairStats(const void* first, const void* second) {
+    const PairStat* one = (const PairStat*) first;
+    const PairStat* two = (const PairStat*) second;
+
+    if (one->count != two->count) return two->count - one->count;
+    return (one->key > two->key) - (one->key < two->key);
+}
+
+static void appendStat(StringBuffer* buffer, const char* label, int value, bool isFirst) {
+    char num[12];
+
+    sprintf(num, "%d", value);
+    appendString(buffer, isFirst ? "\"" : ",\"");
+    appendString(buffer, label);
+    appendString(buffer, "\":");
+    appendString(buffer, num);
+}
+
+/* Counts properties per name, and the cards holding one or more than one of each, in one pass over the rows. */
+static bool appendNameStats(StringBuffer* buffer, const CorpusColumns* columns) {
+    NameStat* stats;
+    int* lastCard;
+    int* inCard;
+    int used = 0;
+    int id;
+
+    stats = calloc(columns->stringCount + 1, sizeof(NameStat));
+    lastCard = malloc(sizeof(int) * (columns->stringCount + 1));
+    inCard = calloc(columns->stringCount + 1, sizeof(int));
+    if (!stats || !lastCard || !inCard) {
+        free(stats);
+        free(lastCard);
+        free(inCard);
+        return false;
+    }
+    for (id = 0; id < columns->stringCount; id++) {
+        stats[id].id = id;
+        lastCard[id] = -1;
+    }
+
+    for (int row = 0; row < columns->rowCount; row++) {
+        id = columns->rowName[row];
+        stats[id].count++;
+        if (lastCard[id] != columns->rowCard[row]) {
+            lastCard[id] = columns->rowCard[row];
+            inCard[id] = 0;
+        }
+        if (++inCard[id] == 1) stats[id].cards++;
+        else if (inCard[id] == 2) stats[id].multiple++;
+    }
+
+    for (id = 0; id < columns->stringCount; id++) {
+        if (stats[id].count > 0) stats[used++] = stats[id];
+    }
+    qsort(stats, used, sizeof(NameStat), compareNameStats);
+
+    appendString(buffer, ",\"propertyNames\":[");
+    for (int i = 0; i < used; i++) {
+        appendString(buffer, i == 0 ? "{\"name\":" : ",{\"name\":");
+        appendJSONString(buffer, columns->strings[stats[i].id]);
+        appendStat(buffer, "count", stats[i].count, false);
+        appendStat(buffer, "cards", stats[i].cards, false);
+        appendStat(buffer, "multiple", stats[i].multiple, false);
+        appendString(buffer, "}");
+    }
+    appendString(buffer, "]");
+
+    free(stats);
+    free(lastCard);
+    free(inCard);
+    return true;
+}
+
+static bool appendCountHistogram(StringBuffer* buffer, const CorpusColumns* columns) {
+    int* perCard;
+    int end;
+
+    if (!(perCard = malloc(sizeof(int) * (columns->cardCount + 1)))) return false;
+    countPerCard(columns, -1, perCard);
+    qsort(perCard, columns->cardCount, sizeof(int), compareInts);
+
+    appendString(buffer, ",\"propertyCounts\":[");
+    for (int start = 0; start < columns->cardCount; start = end) {
+        for (end = start + 1; end < columns->cardCount && perCard[end] == perCard[start]; end++);
+
+        appendString(buffer, start == 0 ? "{" : ",{");
+        appendStat(buffer, "properties", perCard[start], true);
+        appendStat(buffer, "cards", end - start, false);
+        appendString(buffer, "}");
+    }
+    appendString(buffer, "]");
+
+    free(perCard);
+    return true;
+}
+
+static bool appendParameterStats(StringBuffer* buffer, const CorpusColumns* columns) {
+    long long* keys;
+    PairStat* pairs;
+    int pairCount = 0;
+    int end;
+
+    keys = malloc(sizeof(long long) * (columns->paramCount + 1));
+    pairs = malloc(sizeof(PairStat) * (columns->paramCount + 1));
+    if (!keys || !pairs) {
+        free(keys);
+        free(pairs);
+        return false;
+    }
+
+    // Each pair becomes one integer key, so grouping is a sort and a run-length pass
+    for (int i = 0; i < columns->paramCount; i++)
+        keys[i] = ((long long) columns->paramName[i] << 32) | columns->paramValue[i];
+    qsort(keys, columns->paramCount, sizeof(long long), compareLongs);
+    for (int start = 0; start < columns->paramCount; start = end) {
+        for (end = start + 1; end < columns->paramCount && keys[end] == keys[start]; end++);
+        pairs[pairCount].key = keys[start];
+        pairs[pairCount++].count = end - start;
+    }
+    qsort(pairs, pairCount, sizeof(PairStat), comparePairStats);
+
+    appendString(buffer, ",\"parameters\":[");
+    for (int i = 0; i < pairCount && i < TOPPARAMETERS; i++) {
+        appendString(buffer, i == 0 ? "{\"name\":" : ",{\"name\":");
+        appendJSONString(buffer, columns->strings[pairs[i].key >> 32]);
+        appendString(buffer, ",\"value\":");
+        appendJSONString(buffer, columns->strings[pairs[i].key & 0xffffffff]);
+        appendStat(buffer, "count", pairs[i].count, false);
+        appendString(buffer, "}");
+    }
+    appendString(buffer, "]");
+
+    free(keys);
+    free(pairs);
+    return true;
+}
+
+CorpusColumns* loadCorpusColumns(char* dirName) {
+    CorpusColumns* columns;
+
+    if (dirName == NULL || buildCorpusColumns(dirName, &columns) != OK) return NULL;
+
+    return columns;
+}
+
+char* getColumnStats(const CorpusColumns* columns) {
+    StringBuffer buffer;
+
+    if (columns == NULL || !initStringBuffer(&buffer)) return duplicateString("{}");
+
+    appendString(&buffer, "{");
+    appendStat(&buffer, "cards", columns->cardCount, true);
+    appendStat(&buffer, "invalid", columns->invalidCount, false);
+    appendStat(&buffer, "properties", columns->rowCount, false);
+    if (!appendNameStats(&buffer, columns) || !appendCountHistogram(&buffer, columns)
+            || !appendParameterStats(&buffer, columns)) {
+        free(buffer.str);
+        return duplicateString("{}");
+    }
+    appendString(&buffer, "}");
+
+    return buffer.str;
+}
+
+char* getCorpusStats(char* dirName) {
+    CorpusColumns* columns;
+    char* stats;
+
+    if (!(columns = loadCorpusColumns(dirName))) return duplicateString("{}");
+    stats = getColumnStats(columns);
+    freeCorpusColumns(columns);
+
+    return stats;
+}
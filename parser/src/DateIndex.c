@@ -0,0 +1,336 @@
+/**
+ * @file DateIndex.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#include <time.h>
+
+#include "DateIndex.h"
+#include "Corpus.h"
+#include "LazyCard.h"
+#include "ParserFunctions.h"
+
+// What one file contributes to the index, filled in by a worker thread
+typedef struct dateSlot {
+    bool        isValid;
+    char*       name;
+    DateEntry   birthday;
+    DateEntry   anniversary;
+} DateSlot;
+
+static void setEntry(DateEntry* entry, const DateTime* date, bool isAnniversary) {
+    entry->monthDay = date ? date->monthDay : 0;
+    entry->fullDate = date ? date->fullDate : 0;
+    entry->isAnniversary = isAnniversary;
+}
+
+static void collectDates(int index, const char* file, void* arg) {
+    DateSlot* slot = &((DateSlot*) arg)[index];
+    LazyCard* card = NULL;
+    Property* fn;
+
+    if (createLazyCard((char*) file, &card) == OK && card->validation == OK && (fn = getLazyProperty(card, 0))) {
+        slot->name = duplicateString(getFromFront(fn->values));
+        slot->isValid = slot->name != NULL;
+        setEntry(&slot->birthday, card->birthday, false);
+        setEntry(&slot->anniversary, card->anniversary, true);
+    }
+    deleteLazyCard(card);
+}
+
+static int compareByMonthDay(const void* first, const void* second) {
+    const DateEntry* one = (const DateEntry*) first;
+    const DateEntry* two = (const DateEntry*) second;
+
+    if (one->monthDay != two->monthDay) return one->monthDay - two->monthDay;
+    if (one->card != two->card) return one->card - two->card;
+    return one->isAnniversary - two->isAnniversary;
+}
+
+static int compareByFullDate(const void* first, const void* second) {
+    const DateEntry* one = (const DateEntry*) first;
+    const DateEntry* two = (const DateEntry*) second;
+
+    if (one->fullDate != two->fullDate) return one->fullDate - two->fullDate;
+    if (one->card != two->card) return one->card - two->card;
+    return one->isAnniversary - two->isAnniversary;
+}
+
+static void addEntry(DateIndex* index, const DateEntry* entry, int card) {
+    if (entry->monthDay > 0) {
+        index->byMonthDay[index->monthDayCount] = *entry;
+        index->byMonthDay[index->monthDayCount++].card = card;
+    }
+    if (entry->fullDate > 0) {
+        index->byFullDate[index->fullDateCount] = *entry;
+        index->byFullDate[index->fullDateCount++].card = card;
+    }
+}
+
+DateIndex* buildDateIndex(char* dirName) {
+    DateIndex* index;
+    DateSlot* slots;
+    char** files;
+    int count;
+
+    if (dirName == NULL || listCardFiles(dirName, &files, &count) != OK) return NULL;
+
+    index = calloc(1, sizeof(DateIndex));
+    slots = calloc(count + 1, sizeof(DateSlot));
+    if (index) {
+        index->files = malloc(sizeof(char*) * (count + 1));
+        index->names = malloc(sizeof(char*) * (count + 1));
+        index->byMonthDay = malloc(sizeof(DateEntry) * (count * 2 + 1));
+        index->byFullDate = malloc(sizeof(DateEntry) * (count * 2 + 1));
+    }
+    if (!index || !slots || !index->files || !index->names || !index->byMonthDay || !index->byFullDate) {
+        freeDateIndex(index);
+        free(slots);
+        freeCardFiles(files, count);
+        return NULL;
+    }
+
+    forEachCardFile(files, count, collectDates, slots, 0);
+
+    for (int i = 0; i < count; i++) {
+        const char* base;
+
+        if (!slots[i].isValid) continue;
+        base = strrchr(files[i], '/');
+        if (!(index->files[index->cardCount] = duplicateString(base ? base + 1 : files[i]))) {
+            free(slots[i].name);
+            continue;
+        }
+        index->names[index->cardCount] = slots[i].name;
+        addEntry(index, &slots[i].birthday, index->cardCount);
+        addEntry(index, &slots[i].anniversary, index->cardCount);
+        index->cardCount++;
+    }
+    qsort(index->byMonthDay, index->monthDayCount, sizeof(DateEntry), compareByMonthDay);
+    qsort(index->byFullDate, index->fullDateCount, sizeof(DateEntry), compareByFullDate);
+
+    free(slots);
+    freeCardFiles(files, count);
+    return index;
+}
+
+/* Index of the first card whose file is not before file, and whether it is file. */
+static int findCard(const DateIndex* index, const char* file, bool* isFound) {
+    int low = 0;
+    int high = index->cardCount;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+
+        if (strcmp(index->files[mid], file) < 0) low = mid + 1;
+        else high = mid;
+    }
+    *isFound = low < index->cardCount && strcmp(index->files[low], file) == 0;
+    return low;
+}
+
+/* Drops a card's entries and renumbers the cards after it. */
+static void removeEntries(DateEntry* entries, int* count, int card) {
+    int out = 0;
+
+    for (int i = 0; i < *count; i++) {
+        if (entries[i].card == card) continue;
+        entries[out] = entries[i];
+        if (entries[out].card > card) entries[out].card--;
+        out++;
+    }
+    *count = out;
+}
+
+/* Renumbers the cards from card on, to make room for a card inserted there. */
+static void shiftEntries(DateEntry* entries, int count, int card) {
+    for (int i = 0; i < count; i++) {
+        if (entries[i].card >= card) entries[i].card++;
+    }
+}
+
+/* Puts an entry in its sorted place. */
+static void insertEntry(DateEntry* entries, int* count, const DateEntry* entry, int (*compare)(const void*, const void*)) {
+    int low = 0;
+    int high = *count;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+
+        if (compare(&entries[mid], entry) < 0) low = mid + 1;
+        else high = mid;
+    }
+    memmove(entries + low + 1, entries + low, sizeof(DateEntry) * (*count - low));
+    entries[low] = *entry;
+    (*count)++;
+}
+
+VCardErrorCode updateDateIndex(DateIndex* index, char* fileName) {
+    DateSlot slot;
+    DateEntry entry;
+    const char* base;
+    char* file;
+    void* grown;
+    bool isFound;
+    int card;
+
+    if (index == NULL || fileName == NULL) return OTHER_ERROR;
+    base = strrchr(fileName, '/');
+    base = base ? base + 1 : fileName;
+
+    // Drop whatever the index held for the file
+    card = findCard(index, base, &isFound);
+    if (isFound) {
+        free(index->files[card]);
+        free(index->names[card]);
+        memmove(index->files + card, index->files + card + 1, sizeof(char*) * (index->cardCount - card - 1));
+        memmove(index->names + card, index->names + card + 1, sizeof(char*) * (index->cardCount - card - 1));
+        index->cardCount--;
+        removeEntries(index->byMonthDay, &index->monthDayCount, card);
+        removeEntries(index->byFullDate, &index->fullDateCount, card);
+    }
+
+    // Then add what it is now, skipping files listCardFiles would not list
+    memset(&slot, 0, sizeof(slot));
+    if (base[0] != '.') collectDates(0, fileName, &slot);
+    if (!slot.isValid) return OK;
+
+    // Every array keeps a spare slot, as buildDateIndex allocates them
+    if (!(file = duplicateString(base))) {
+        free(slot.name);
+        return OTHER_ERROR;
+    }
+    if ((grown = realloc(index->files, sizeof(char*) * (index->cardCount + 2)))) index->files = grown;
+    if (grown && (grown = realloc(index->names, sizeof(char*) * (index->cardCount + 2)))) index->names = grown;
+    if (grown && (grown = realloc(index->byMonthDay, sizeof(DateEntry) * (index->monthDayCount + 3)))) index->byMonthDay = grown;
+    if (grown && (grown = realloc(index->byFullDate, sizeof(DateEntry) * (index->fullDateCount + 3)))) index->byFullDate = grown;
+    if (!grown) {
+        free(file);
+        free(slot.name);
+        return OTHER_ERROR;
+    }
+
+    memmove(index->files + card + 1, index->files + card, sizeof(char*) * (index->cardCount - card));
+    memmove(index->names + card + 1, index->names + card, sizeof(char*) * (index->cardCount - card));
+    index->files[card] = file;
+    index->names[card] = slot.name;
+    index->cardCount++;
+    shiftEntries(index->byMonthDay, index->monthDayCount, card);
+    shiftEntries(index->byFullDate, index->fullDateCount, card);
+
+    for (int i = 0; i < 2; i++) {
+        entry = i == 0 ? slot.birthday : slot.anniversary;
+        entry.card = card;
+        if (entry.monthDay > 0) insertEntry(index->byMonthDay, &index->monthDayCount, &entry, compareByMonthDay);
+        if (entry.fullDate > 0) insertEntry(index->byFullDate, &index->fullDateCount, &entry, compareByFullDate);
+    }
+    return OK;
+}
+
+void freeDateIndex(DateIndex* index) {
+    if (index == NULL) return;
+
+    for (int i = 0; i < index->cardCount; i++) {
+        free(index->files[i]);
+        free(index->names[i]);
+    }
+    free(index->files);
+    free(index->names);
+    free(index->byMonthDay);
+    free(index->byFullDate);
+    free(index);
+}
+
+/* Index of the first entry whose key is at least key, using monthDay or fullDate. */
+static int lowerBound(const DateEntry* entries, int count, int key, bool isFullDate) {
+    int low = 0;
+    int high = count;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+
+        if ((isFullDate ? entries[mid].fullDate : entries[mid].monthDay) < key) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+/* Appends the entries with keys in [from, to]. */
+static void appendEntries(StringBuffer* buffer, const DateIndex* index, const DateEntry* entries, int count,
+        int from, int to, bool isFullDate, bool* isFirst) {
+    char num[12];
+
+    for (int i = lowerBound(entries, count, from, isFullDate); i < count; i++) {
+        if ((isFullDate ? entries[i].fullDate : entries[i].monthDay) > to) break;
+
+        appendString(buffer, *isFirst ? "{\"file\":" : ",{\"file\":");
+        appendJSONString(buffer, index->files[entries[i].card]);
+        appendString(buffer, ",\"name\":");
+        appendJSONString(buffer, index->names[entries[i].card]);
+        appendString(buffer, entries[i].isAnniversary ? ",\"type\":\"ANNIVERSARY\"" : ",\"type\":\"BDAY\"");
+        sprintf(num, "%d", entries[i].monthDay);
+        appendString(buffer, ",\"monthDay\":");
+        appendString(buffer, num);
+        sprintf(num, "%d", entries[i].fullDate);
+        appendString(buffer, ",\"fullDate\":");
+        appendString(buffer, num);
+        appendString(buffer, "}");
+        *isFirst = false;
+    }
+}
+
+char* getUpcomingDates(DateIndex* index, int today, int days) {
+    StringBuffer buffer;
+    struct tm date;
+    bool isFirst = true;
+    int start;
+    int end;
+
+    if (index == NULL || days <= 0 || !initStringBuffer(&buffer)) return duplicateString("[]");
+
+    // Let mktime carry the window's last day across month and year ends.  Noon avoids DST edges.
+    memset(&date, 0, sizeof(date));
+    date.tm_year = today / 10000 - 1900;
+    date.tm_mon = today / 100 % 100 - 1;
+    date.tm_mday = today % 100 + days - 1;
+    date.tm_hour = 12;
+    date.tm_isdst = -1;
+    if (mktime(&date) == (time_t) -1) {
+        free(buffer.str);
+        return duplicateString("[]");
+    }
+    start = today % 10000;
+    end = (date.tm_mon + 1) * 100 + date.tm_mday;
+
+    appendString(&buffer, "[");
+    if (days >= 366) {
+        // A year or more sees every date once, starting from today
+        appendEntries(&buffer, index, index->byMonthDay, index->monthDayCount, start, 1231, false, &isFirst);
+        appendEntries(&buffer, index, index->byMonthDay, index->monthDayCount, 0, start - 1, false, &isFirst);
+    }
+    else if (start <= end) {
+        appendEntries(&buffer, index, index->byMonthDay, index->monthDayCount, start, end, false, &isFirst);
+    }
+    else {
+        // The window wraps past December 31
+        appendEntries(&buffer, index, index->byMonthDay, index->monthDayCount, start, 1231, false, &isFirst);
+        appendEntries(&buffer, index, index->byMonthDay, index->monthDayCount, 0, end, false, &isFirst);
+    }
+    appendString(&buffer, "]");
+
+    return buffer.str;
+}
+
+char* getDatesInRange(DateIndex* index, int from, int to) {
+    StringBuffer buffer;
+    bool isFirst = true;
+
+    if (index == NULL || from > to || !initStringBuffer(&buffer)) return duplicateString("[]");
+
+    appendString(&buffer, "[");
+    appendEntries(&buffer, index, index->byFullDate, index->fullDateCount, from, to, true, &isFirst);
+    appendString(&buffer, "]");
+
+    return buffer.str;
+}
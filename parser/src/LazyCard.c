@@ -0,0 +1,759 @@
+/**
+ * @file LazyCard.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#define _DEFAULT_SOURCE
+
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "LazyCard.h"
+#include "CardScanner.h"
+#include "CompressedStream.h"
+#include "ParserFunctions.h"
+
+/*  Reads a card file into memory, decompressing it if needed.  Plain files are read rather
+    than mapped: streams keep a card open across writes to the socket, and a mapped file
+    truncated or rewritten in place meanwhile would fault the whole process on its next read.
+*/
+static VCardErrorCode loadCardData(const char* fileName, LazyCard* card) {
+    struct stat st;
+    FILE* fp;
+    char* grown;
+    size_t capacity = 65536;
+    size_t n;
+
+    // Taken before the file is read, so a value read from the file later can tell it was rewritten
+    if (stat(fileName, &st) != 0 || !(fp = openCardFile(fileName))) return INV_FILE;
+    card->mtime = st.st_mtim;
+    card->fileSize = st.st_size;
+
+    // A plain file is read in one go into a buffer of its size; the spare byte lets the read see EOF
+    if (compressionFromName(fileName) == PLAIN && (size_t) st.st_size >= capacity)
+        capacity = st.st_size + 1;
+    if (!(card->data = malloc(capacity))) {
+        fclose(fp);
+        return OTHER_ERROR;
+    }
+    while ((n = fread(card->data + card->size, 1, capacity - card->size, fp)) > 0) {
+        card->size += n;
+        if (card->size == capacity) {
+            if (!(grown = realloc(card->data, capacity * 2))) {
+                fclose(fp);
+                return OTHER_ERROR;
+            }
+            card->data = grown;
+            capacity *= 2;
+        }
+    }
+    // A compressed card stops with an error past MAX_CARD_SIZE
+    if (ferror(fp)) {
+        fclose(fp);
+        return INV_FILE;
+    }
+    fclose(fp);
+    card->dataSize = card->size;
+
+    return OK;
+}
+
+static void releaseLargeValues(LazyCard* card);
+
+/* The card's bytes at an offset in the card, which lies outside any large value cut out of them. */
+static const char* cardBytes(const LazyCard* card, long offset) {
+    long shift = 0;
+
+    for (int i = 0; i < card->largeValueCount && card->largeValues[i].offset < offset; i++)
+        shift += card->largeValues[i].length;
+    return card->data + offset - shift;
+}
+
+/* Copies a raw content line without its CRLF and folds, as the scanner saw it. */
+static char* unfoldLine(const char* raw, long length) {
+    char* line;
+    long j = 0;
+
+    if (!(line = malloc(sizeof(char) * (length + 1)))) return NULL;
+
+    for (long i = 0; i < length; i++) {
+        if (raw[i] == '\r' && i + 1 < length && raw[i + 1] == '\n') {
+            i++;
+            if (i + 1 < length && raw[i + 1] == ' ') i++;
+            continue;
+        }
+        line[j++] = raw[i];
+    }
+    line[j] = '\0';
+
+    return line;
+}
+
+/* FNV-1a style hash taken eight bytes at a time, since lines such as PHOTO can be large. */
+static unsigned long long hashBytes(const char* bytes, long length) {
+    unsigned long long hash = 0xcbf29ce484222325ULL ^ (unsigned long long) length;
+    unsigned long long word;
+    long i = 0;
+
+    for (; i + 8 <= length; i += 8) {
+        memcpy(&word, bytes + i, 8);
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+    for (; i < length; i++) {
+        hash ^= (unsigned char) bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+/* Appends the content lines in data[start, end) to lines, stopping at the first line that does not end in CRLF. */
+static VCardErrorCode scanLines(const char* data, long start, long end, ScannedLine** lines, int* count, int* capacity) {
+    CardScanner scanner;
+    ScannedLine* grown;
+    ScannedLine* line;
+    FILE* fp;
+    char* groupName;
+    char* propertyName;
+    char* parameterValues;
+    char* propertyValues;
+    VCardErrorCode err;
+
+    if (start == end) return OK;
+    if (!(fp = fmemopen((char*) data + start, end - start, "r"))) return OTHER_ERROR;
+    if ((err = initCardScanner(&scanner, fp)) != OK) {
+        fclose(fp);
+        return err;
+    }
+
+    while ((err = nextContentLine(&scanner)) == OK && !scanner.isEnd) {
+        if (*count == *capacity) {
+            if (!(grown = realloc(*lines, sizeof(ScannedLine) * *capacity * 2))) {
+                err = OTHER_ERROR;
+                break;
+            }
+            *lines = grown;
+            *capacity *= 2;
+        }
+        line = &(*lines)[(*count)++];
+        line->offset = start + scanner.offset;
+        line->length = scanner.length;
+        line->hash = hashBytes(data + line->offset, line->length);
+        line->kind = LINE_HEADER;
+        line->property = -1;
+
+        splitContentLine(scanner.line, &groupName, &propertyName, &parameterValues, &propertyValues);
+        describeContentLine(&line->facts, propertyName, parameterValues, propertyValues);
+    }
+    freeCardScanner(&scanner);
+    fclose(fp);
+
+    return err;
+}
+
+static void assignProperty(LazyCard* card, int line, int index, LazyCard* previous, const int* reuse) {
+    card->scanned[line].property = index;
+    card->lines[index].offset = card->scanned[line].offset;
+    card->lines[index].length = card->scanned[line].length;
+
+    if (reuse != NULL && reuse[line] >= 0) {
+        card->properties[index] = previous->properties[reuse[line]];
+        previous->properties[reuse[line]] = NULL;
+    }
+}
+
+/*  Checks the scanned lines the way readCard and validateCard would, then indexes FN
+    and the optional properties.  Where reuse gives a property of previous for a line,
+    it is moved over instead of being built again.  Nothing is moved on failure.
+*/
+static VCardErrorCode indexLines(LazyCard* card, VCardErrorCode scanError, LazyCard* previous, const int* reuse) {
+    CardCheck check;
+    ScannedLine* line;
+    VCardErrorCode err = OK;
+    int fnLine = -1;
+    int index = 1;
+
+    initCardCheck(&check);
+    // A scan that stopped early never reached the last line
+    for (int i = 0; i < card->lineCount && err == OK; i++) {
+        line = &card->scanned[i];
+        err = checkLineFacts(&check, &line->kind, &line->facts, scanError == OK && i == card->lineCount - 1);
+    }
+    if (err == OK) err = scanError;
+    if (err == OK) err = finishCardCheck(&check);
+    card->validation = check.validation;
+    if (err != OK) return err;
+
+    // Slot 0 is kept for FN
+    card->propertyCount = 1 + check.optionalCount;
+    if (!(card->lines = malloc(sizeof(LazyLine) * card->propertyCount))) return OTHER_ERROR;
+    if (!(card->properties = calloc(card->propertyCount, sizeof(Property*)))) return OTHER_ERROR;
+    card->lines[0].offset = -1;
+    card->lines[0].length = 0;
+
+    for (int i = 0; i < card->lineCount; i++) {
+        card->scanned[i].property = -1;
+        if (card->scanned[i].kind == LINE_FN)
+            fnLine = i;
+        else if (card->scanned[i].kind == LINE_OPTIONAL)
+            assignProperty(card, i, index++, previous, reuse);
+    }
+    // Like readCard, the last FN line wins
+    if (fnLine >= 0) assignProperty(card, fnLine, 0, previous, reuse);
+
+    return OK;
+}
+
+static void setLazyDate(DateTime** date, char* parameterValues, char* propertyValues) {
+    DateTime* aDateTime = NULL;
+
+    if (createDateTime(&aDateTime, parameterValues, propertyValues) == OK) {
+        deleteDate(*date);
+        *date = aDateTime;
+    }
+}
+
+static void readLazyDates(LazyCard* card) {
+    ScannedLine* line;
+    char* unfolded;
+    char* groupName;
+    char* propertyName;
+    char* parameterValues;
+    char* propertyValues;
+
+    for (int i = 0; i < card->lineCount; i++) {
+        line = &card->scanned[i];
+        if (line->kind != LINE_BDAY && line->kind != LINE_ANNIVERSARY) continue;
+        if (!(unfolded = unfoldLine(cardBytes(card, line->offset), line->length))) continue;
+
+        splitContentLine(unfolded, &groupName, &propertyName, &parameterValues, &propertyValues);
+        setLazyDate(line->kind == LINE_BDAY ? &card->birthday : &card->anniversary, parameterValues, propertyValues);
+        free(unfolded);
+    }
+}
+
+VCardErrorCode createLazyCard(char* fileName, LazyCard** newCardObject) {
+    LazyCard* card;
+    VCardErrorCode err;
+    int capacity = 16;
+
+    *newCardObject = NULL;
+    if (!hasCardExtension(fileName)) return INV_FILE;
+    if (!(card = calloc(1, sizeof(LazyCard)))) return OTHER_ERROR;
+
+    err = loadCardData(fileName, card);
+    // Same result the scanner gives for an empty stream
+    if (err == OK && card->size == 0) err = INV_PROP;
+    if (err == OK && !(card->scanned = malloc(sizeof(ScannedLine) * capacity))) err = OTHER_ERROR;
+    if (err == OK)
+        err = indexLines(card, scanLines(card->data, 0, card->size, &card->scanned, &card->lineCount, &capacity), NULL, NULL);
+
+    if (err != OK) {
+        deleteLazyCard(card);
+        return err;
+    }
+    readLazyDates(card);
+    releaseLargeValues(card);
+
+    *newCardObject = card;
+    return OK;
+}
+
+/* Whether a line scanned earlier is still a content line with the same bytes, moved by delta. */
+static bool isLineAt(const ScannedLine* line, const LazyCard* card, long delta) {
+    long offset = line->offset + delta;
+    long end = offset + line->length;
+
+    if (offset < 0 || end > (long) card->size) return false;
+    // It must still follow a CRLF and must not be continued by a fold
+    if (offset > 0 && (offset < 2 || card->data[offset - 2] != '\r' || card->data[offset - 1] != '\n')) return false;
+    if (end < (long) card->size && card->data[end] == ' ') return false;
+
+    return hashBytes(card->data + offset, line->length) == line->hash;
+}
+
+/* Points each line of card in [from, to) at a property of old built from a line of the same length and hash in [oldFrom, oldTo), each used once. */
+static void matchLines(const LazyCard* old, int oldFrom, int oldTo, const LazyCard* card, int from, int to, int* reuse) {
+    const ScannedLine* line;
+    const ScannedLine* candidate;
+    int* table;
+    int size = 16;
+    int slot;
+
+    for (int i = from; i < to; i++)
+        reuse[i] = -1;
+    while (size < (oldTo - oldFrom) * 2)
+        size *= 2;
+    if (oldFrom == oldTo || !(table = malloc(sizeof(int) * size))) return;
+
+    // Open addressing on the line hash; -1 is empty and -2 a line already matched
+    for (int i = 0; i < size; i++)
+        table[i] = -1;
+    for (int j = oldFrom; j < oldTo; j++) {
+        if (old->scanned[j].property < 0) continue;
+        for (slot = old->scanned[j].hash & (size - 1); table[slot] != -1; slot = (slot + 1) & (size - 1));
+        table[slot] = j;
+    }
+
+    for (int i = from; i < to; i++) {
+        line = &card->scanned[i];
+        for (slot = line->hash & (size - 1); table[slot] != -1; slot = (slot + 1) & (size - 1)) {
+            if (table[slot] == -2) continue;
+            candidate = &old->scanned[table[slot]];
+            if (candidate->hash == line->hash && candidate->length == line->length) {
+                reuse[i] = candidate->property;
+                table[slot] = -2;
+                break;
+            }
+        }
+    }
+    free(table);
+}
+
+static bool hasDateLine(const LazyCard* card, int from, int to) {
+    for (int i = from; i < to; i++) {
+        if (card->scanned[i].facts.kind == LINE_BDAY || card->scanned[i].facts.kind == LINE_ANNIVERSARY) return true;
+    }
+    return false;
+}
+
+VCardErrorCode refreshLazyCard(LazyCard* obj, char* fileName, int* rescanned) {
+    LazyCard* next;
+    LazyCard previous;
+    int* reuse = NULL;
+    long start;
+    long end;
+    long delta;
+    int first;
+    int last;
+    int windowEnd;
+    int capacity;
+    VCardErrorCode err;
+    VCardErrorCode scanError;
+
+    if (rescanned) *rescanned = 0;
+    if (obj == NULL) return OTHER_ERROR;
+    if (!hasCardExtension(fileName)) return INV_FILE;
+    if (!(next = calloc(1, sizeof(LazyCard)))) return OTHER_ERROR;
+
+    if ((err = loadCardData(fileName, next)) == OK && next->size == 0) err = INV_PROP;
+    if (err != OK) {
+        deleteLazyCard(next);
+        return err;
+    }
+
+    delta = (long) next->size - (long) obj->size;
+
+    // Lines are recognized by length and hash, without comparing their bytes.  Lines at the
+    // start still at their offsets and lines at the end moved by the change in size are
+    // kept, and the rest is scanned again.
+    for (first = 0; first < obj->lineCount && isLineAt(&obj->scanned[first], next, 0); first++);
+    start = first > 0 ? obj->scanned[first - 1].offset + obj->scanned[first - 1].length : 0;
+    if (first == obj->lineCount && start == (long) next->size) {
+        obj->mtime = next->mtime;
+        obj->fileSize = next->fileSize;
+        deleteLazyCard(next);
+        return OK;
+    }
+    for (last = obj->lineCount; last > first && obj->scanned[last - 1].offset + delta >= start
+            && isLineAt(&obj->scanned[last - 1], next, delta); last--);
+    end = last < obj->lineCount ? obj->scanned[last].offset + delta : (long) next->size;
+
+    capacity = first + (obj->lineCount - last) + 16;
+    if (!(next->scanned = malloc(sizeof(ScannedLine) * capacity))) {
+        deleteLazyCard(next);
+        return OTHER_ERROR;
+    }
+    memcpy(next->scanned, obj->scanned, sizeof(ScannedLine) * first);
+    next->lineCount = first;
+    scanError = scanLines(next->data, start, end, &next->scanned, &next->lineCount, &capacity);
+    windowEnd = next->lineCount;
+    if (rescanned) *rescanned = windowEnd - first;
+
+    // A scan that stopped early does not reach the kept lines after it
+    if (scanError == OK) {
+        if (capacity < windowEnd + obj->lineCount - last) {
+            ScannedLine* grown = realloc(next->scanned, sizeof(ScannedLine) * (windowEnd + obj->lineCount - last));
+
+            if (!grown) scanError = OTHER_ERROR;
+            else next->scanned = grown;
+        }
+        for (int i = last; scanError == OK && i < obj->lineCount; i++) {
+            next->scanned[next->lineCount] = obj->scanned[i];
+            next->scanned[next->lineCount++].offset += delta;
+        }
+    }
+
+    if (!(reuse = malloc(sizeof(int) * (next->lineCount + 1)))) {
+        deleteLazyCard(next);
+        return OTHER_ERROR;
+    }
+    for (int i = 0; i < first; i++)
+        reuse[i] = obj->scanned[i].property;
+    for (int i = windowEnd; i < next->lineCount; i++)
+        reuse[i] = obj->scanned[last + i - windowEnd].property;
+    matchLines(obj, first, last, next, first, windowEnd, reuse);
+
+    err = indexLines(next, scanError, obj, reuse);
+    free(reuse);
+    if (err != OK) {
+        deleteLazyCard(next);
+        return err;
+    }
+
+    // Dates are read again only if a BDAY or ANNIVERSARY line was among the changed lines
+    if (hasDateLine(obj, first, last) || hasDateLine(next, first, windowEnd)) {
+        readLazyDates(next);
+    }
+    else {
+        next->birthday = obj->birthday;
+        next->anniversary = obj->anniversary;
+        obj->birthday = NULL;
+        obj->anniversary = NULL;
+    }
+
+    releaseLargeValues(next);
+
+    // obj takes the new state, and the old one is freed with every property not moved over
+    previous = *obj;
+    *obj = *next;
+    *next = previous;
+    deleteLazyCard(next);
+
+    return OK;
+}
+
+void deleteLazyCard(LazyCard* obj) {
+    if (obj == NULL) return;
+
+    if (obj->properties) {
+        for (int i = 0; i < obj->propertyCount; i++)
+            deleteProperty(obj->properties[i]);
+        free(obj->properties);
+    }
+    free(obj->data);
+    free(obj->largeValues);
+    free(obj->lines);
+    free(obj->scanned);
+    deleteDate(obj->birthday);
+    deleteDate(obj->anniversary);
+    free(obj);
+}
+
+/*  Process-wide cache of lazy cards for the property and value readers.  A cached card is
+    handed to one reader at a time, since a LazyCard builds properties as it is read; a
+    reader asking while it is out gets a card of its own.  When a file's mtime or size
+    changes, its card is brought up to date with refreshLazyCard, which scans only the
+    changed lines and keeps the properties already built from the rest.
+*/
+typedef struct cachedCard {
+    char*           fileName;
+    struct timespec mtime;
+    off_t           size;
+    LazyCard*       card;
+    bool            isInUse;
+    unsigned long   lastUsed;
+} CachedCard;
+
+static CachedCard cardCache[LAZY_CACHE_SLOTS];
+static size_t cacheBytes = 0;
+static unsigned long cacheClock = 0;
+static pthread_mutex_t cacheLock = PTHREAD_MUTEX_INITIALIZER;
+
+static bool isSameFile(const CachedCard* entry, const struct stat* st) {
+    return entry->mtime.tv_sec == st->st_mtim.tv_sec && entry->mtime.tv_nsec == st->st_mtim.tv_nsec
+            && entry->size == st->st_size;
+}
+
+static void dropCachedCard(CachedCard* entry) {
+    cacheBytes -= entry->card->dataSize;
+    deleteLazyCard(entry->card);
+    free(entry->fileName);
+    memset(entry, 0, sizeof(CachedCard));
+}
+
+/*  Caches a card handed out for the first time, making room by dropping the least recently
+    used idle cards.  The caller holds cacheLock.
+*/
+static bool cacheCard(char* fileName, const struct stat* st, LazyCard* card) {
+    CachedCard* empty;
+    CachedCard* oldest;
+    char* name;
+
+    if (card->dataSize > LAZY_CACHE_BYTES) return false;
+    for (int i = 0; i < LAZY_CACHE_SLOTS; i++) {
+        // Another reader cached the same file meanwhile
+        if (cardCache[i].card && strcmp(cardCache[i].fileName, fileName) == 0) return false;
+    }
+
+    while (true) {
+        empty = NULL;
+        oldest = NULL;
+        for (int i = 0; i < LAZY_CACHE_SLOTS; i++) {
+            if (cardCache[i].card == NULL) {
+                if (empty == NULL) empty = &cardCache[i];
+            }
+            else if (!cardCache[i].isInUse && (oldest == NULL || cardCache[i].lastUsed < oldest->lastUsed)) {
+                oldest = &cardCache[i];
+            }
+        }
+        if (empty && cacheBytes + card->dataSize <= LAZY_CACHE_BYTES) break;
+        if (oldest == NULL) return false;
+        dropCachedCard(oldest);
+    }
+
+    if (!(name = duplicateString(fileName))) return false;
+    empty->fileName = name;
+    empty->mtime = st->st_mtim;
+    empty->size = st->st_size;
+    empty->card = card;
+    empty->isInUse = true;
+    cacheBytes += card->dataSize;
+    return true;
+}
+
+VCardErrorCode acquireLazyCard(char* fileName, LazyCard** newCardObject) {
+    CachedCard* entry = NULL;
+    struct stat st;
+    size_t size;
+    VCardErrorCode err;
+
+    *newCardObject = NULL;
+    if (!hasCardExtension(fileName)) return INV_FILE;
+    // Taken before the file is read, so a change made while reading shows as a new mtime next time
+    if (stat(fileName, &st) != 0) return INV_FILE;
+
+    pthread_mutex_lock(&cacheLock);
+    for (int i = 0; i < LAZY_CACHE_SLOTS && entry == NULL; i++) {
+        if (cardCache[i].card && strcmp(cardCache[i].fileName, fileName) == 0) entry = &cardCache[i];
+    }
+    if (entry && !entry->isInUse) {
+        // Marked in use, the entry is not dropped or handed out while the lock is released
+        entry->isInUse = true;
+        pthread_mutex_unlock(&cacheLock);
+
+        size = entry->card->dataSize;
+        err = isSameFile(entry, &st) ? OK : refreshLazyCard(entry->card, fileName, NULL);
+
+        pthread_mutex_lock(&cacheLock);
+        if (err != OK) {
+            // A failed refresh leaves the card as it was, so it is dropped at its old size
+            dropCachedCard(entry);
+        }
+        else {
+            cacheBytes = cacheBytes - size + entry->card->dataSize;
+            entry->mtime = st.st_mtim;
+            entry->size = st.st_size;
+            *newCardObject = entry->card;
+        }
+        pthread_mutex_unlock(&cacheLock);
+        return err;
+    }
+    pthread_mutex_unlock(&cacheLock);
+
+    if ((err = createLazyCard(fileName, newCardObject)) != OK) return err;
+
+    // A card already out to another reader stays uncached, and is deleted on release
+    if (entry == NULL) {
+        pthread_mutex_lock(&cacheLock);
+        cacheCard(fileName, &st, *newCardObject);
+        pthread_mutex_unlock(&cacheLock);
+    }
+    return OK;
+}
+
+void releaseLazyCard(LazyCard* obj) {
+    if (obj == NULL) return;
+
+    pthread_mutex_lock(&cacheLock);
+    for (int i = 0; i < LAZY_CACHE_SLOTS; i++) {
+        if (cardCache[i].card == obj) {
+            cardCache[i].isInUse = false;
+            cardCache[i].lastUsed = ++cacheClock;
+            pthread_mutex_unlock(&cacheLock);
+            return;
+        }
+    }
+    pthread_mutex_unlock(&cacheLock);
+
+    deleteLazyCard(obj);
+}
+
+int getLazyPropertyCount(const LazyCard* obj) {
+    if (obj == NULL) return 0;
+
+    return obj->propertyCount;
+}
+
+/*  Finds the first ':' strTokenizer would split a raw line at, skipping folds the way
+    unfoldLine does.  What comes before it is copied into head, which holds VALUE_HEAD_SIZE
+    characters; a line whose ':' is further in is treated as having no value part.
+*/
+#define VALUE_HEAD_SIZE 1024
+
+static bool findValue(const char* raw, long length, ValueRef* ref, char* head) {
+    int j = 0;
+
+    for (long i = 0; i < length && j < VALUE_HEAD_SIZE; i++) {
+        if (raw[i] == '\r' && i + 1 < length && raw[i + 1] == '\n') {
+            i++;
+            if (i + 1 < length && raw[i + 1] == ' ') i++;
+            continue;
+        }
+        if (raw[i] == ':' && (j == 0 || head[j - 1] != '\\')) {
+            head[j] = '\0';
+            ref->offset = i + 1;
+            ref->length = length - i - 1;
+            return true;
+        }
+        head[j++] = raw[i];
+    }
+    return false;
+}
+
+/* Sets ref and head if the property's value is one left in the file. */
+static bool findLargeValue(const LazyCard* obj, int index, ValueRef* ref, char* head) {
+    char name[VALUE_HEAD_SIZE + 1];
+    char* groupName;
+    char* propertyName;
+    char* parameterValues;
+    char* propertyValues;
+
+    if (obj == NULL || index < 0 || index >= obj->propertyCount || obj->lines[index].offset < 0) return false;
+    if (obj->lines[index].length < LARGE_VALUE_SIZE) return false;
+    if (!findValue(cardBytes(obj, obj->lines[index].offset), obj->lines[index].length, ref, head)) return false;
+    ref->offset += obj->lines[index].offset;
+
+    strcpy(name, head);
+    splitContentLine(name, &groupName, &propertyName, &parameterValues, &propertyValues);
+    return stricasecmp(propertyName, "PHOTO") == 0 || stricasecmp(propertyName, "LOGO") == 0
+            || stricasecmp(propertyName, "SOUND") == 0 || stricasecmp(propertyName, "KEY") == 0;
+}
+
+/*  Cuts the large values out of the card's bytes once it has been scanned and its dates read, so a
+    card kept in the cache holds only its text.  Their locations are kept, and a ValueStream reads
+    them from the file.  If memory runs out the card simply keeps every byte.
+*/
+static void releaseLargeValues(LazyCard* card) {
+    char head[VALUE_HEAD_SIZE + 1];
+    ValueRef ref;
+    ValueRef* values;
+    char* data;
+    long removed = 0;
+    long from = 0;
+    size_t n = 0;
+    int count = 0;
+
+    if (!(values = malloc(sizeof(ValueRef) * (card->propertyCount + 1)))) return;
+    // Scanned lines are in file order, so the values are too
+    for (int i = 0; i < card->lineCount; i++) {
+        if (card->scanned[i].property >= 0 && findLargeValue(card, card->scanned[i].property, &ref, head)) {
+            values[count++] = ref;
+            removed += ref.length;
+        }
+    }
+    if (count == 0 || !(data = malloc(card->size - removed + 1))) {
+        free(values);
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        memcpy(data + n, card->data + from, values[i].offset - from);
+        n += values[i].offset - from;
+        from = values[i].offset + values[i].length;
+    }
+    memcpy(data + n, card->data + from, card->size - from);
+    n += card->size - from;
+
+    free(card->data);
+    card->data = data;
+    card->dataSize = n;
+    card->largeValues = values;
+    card->largeValueCount = count;
+}
+
+const char* getLazyLine(const LazyCard* obj, int index, long* length) {
+    char head[VALUE_HEAD_SIZE + 1];
+    ValueRef ref;
+
+    if (obj == NULL || index < 0 || index >= obj->propertyCount || obj->lines[index].offset < 0) return NULL;
+
+    *length = obj->lines[index].length;
+    if (findLargeValue(obj, index, &ref, head)) *length = ref.offset - obj->lines[index].offset;
+    return cardBytes(obj, obj->lines[index].offset);
+}
+
+bool isLazyValueInFile(const LazyCard* obj, int index) {
+    char head[VALUE_HEAD_SIZE + 1];
+    ValueRef ref;
+
+    if (!findLargeValue(obj, index, &ref, head)) return false;
+    for (int i = 0; i < obj->largeValueCount; i++) {
+        if (obj->largeValues[i].offset == ref.offset) return true;
+    }
+    return false;
+}
+
+bool findLazyValue(const LazyCard* obj, int index, ValueRef* ref) {
+    char head[VALUE_HEAD_SIZE + 1];
+
+    if (obj == NULL || index < 0 || index >= obj->propertyCount || obj->lines[index].offset < 0) return false;
+    if (!findValue(cardBytes(obj, obj->lines[index].offset), obj->lines[index].length, ref, head)) return false;
+
+    ref->offset += obj->lines[index].offset;
+    return true;
+}
+
+long getLazyValueSize(const LazyCard* obj, int index) {
+    char head[VALUE_HEAD_SIZE + 1];
+    ValueRef ref;
+
+    if (!findLargeValue(obj, index, &ref, head)) return -1;
+
+    return ref.length;
+}
+
+Property* getLazyProperty(LazyCard* obj, int index) {
+    char head[VALUE_HEAD_SIZE + 1];
+    char empty[1] = "";
+    ValueRef ref;
+    char* line;
+    char* groupName;
+    char* propertyName;
+    char* parameterValues;
+    char* propertyValues;
+
+    if (obj == NULL || index < 0 || index >= obj->propertyCount) return NULL;
+    if (obj->properties[index]) return obj->properties[index];
+    if (obj->lines[index].offset < 0) return NULL;
+
+    // A large binary value stays in the file; only the name and parameters are built
+    if (findLargeValue(obj, index, &ref, head)) {
+        splitContentLine(head, &groupName, &propertyName, &parameterValues, &propertyValues);
+        buildProperty(&obj->properties[index], groupName, propertyName, parameterValues, empty);
+        return obj->properties[index];
+    }
+
+    if (!(line = unfoldLine(cardBytes(obj, obj->lines[index].offset), obj->lines[index].length))) return NULL;
+    splitContentLine(line, &groupName, &propertyName, &parameterValues, &propertyValues);
+    buildProperty(&obj->properties[index], groupName, propertyName, parameterValues, propertyValues);
+    free(line);
+
+    return obj->properties[index];
+}
+
+LazyIterator createLazyIterator(LazyCard* obj) {
+    LazyIterator iter;
+
+    iter.card = obj;
+    iter.next = 0;
+    return iter;
+}
+
+Property* nextLazyProperty(LazyIterator* iter) {
+    if (iter == NULL || iter->card == NULL || iter->next >= iter->card->propertyCount) return NULL;
+
+    return getLazyProperty(iter->card, iter->next++);
+}
@@ -0,0 +1,227 @@
+/**
+ * @file ParserContext.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#include "ParserContext.h"
+#include "CardScanner.h"
+#include "CompressedStream.h"
+#include "CardTrust.h"
+
+ParserContext* createParserContext(void) {
+    ParserContext* ctx;
+
+    if (!(ctx = calloc(1, sizeof(ParserContext)))) return NULL;
+    if (!initStringBuffer(&ctx->output) || !initStringBuffer(&ctx->scratch)) {
+        deleteParserContext(ctx);
+        return NULL;
+    }
+    ctx->level = VALIDATE_STRICT;
+    return ctx;
+}
+
+void setParserContextLevel(ParserContext* ctx, ValidationLevel level) {
+    if (ctx != NULL) ctx->level = level;
+}
+
+void deleteParserContext(ParserContext* ctx) {
+    if (ctx == NULL) return;
+
+    free(ctx->line);
+    free(ctx->output.str);
+    free(ctx->scratch.str);
+    free(ctx);
+}
+
+/* Opens a card file and starts a scanner on the context's line buffer. */
+static VCardErrorCode openScanner(ParserContext* ctx, CardScanner* scanner, char* fileName) {
+    FILE* fp;
+    VCardErrorCode err;
+
+    if (!hasCardExtension(fileName)) return INV_FILE;
+    if (!(fp = openCardFile(fileName))) return INV_FILE;
+
+    if ((err = initCardScannerBuffer(scanner, fp, ctx->line, ctx->lineCapacity)) != OK) {
+        fclose(fp);
+        return err;
+    }
+    ctx->line = NULL;
+    ctx->lineCapacity = 0;
+    return OK;
+}
+
+/* Closes the scanner's stream and takes its (possibly grown) line buffer back. */
+static void closeScanner(ParserContext* ctx, CardScanner* scanner, size_t startCapacity) {
+    if (startCapacity > 0 && scanner->capacity > startCapacity) ctx->lineGrowths++;
+    ctx->bytesScanned += scanner->position;
+    ctx->line = scanner->line;
+    ctx->lineCapacity = scanner->capacity;
+    fclose(scanner->fp);
+}
+
+VCardErrorCode createCardCtx(ParserContext* ctx, char* fileName, Card** newCardObject) {
+    CardScanner scanner;
+    size_t startCapacity = ctx->lineCapacity;
+    VCardErrorCode err;
+
+    *newCardObject = NULL;
+    ctx->calls++;
+    if ((err = openScanner(ctx, &scanner, fileName)) != OK) {
+        ctx->errors++;
+        return err;
+    }
+    err = readCardFromScanner(&scanner, newCardObject);
+    closeScanner(ctx, &scanner, startCapacity);
+
+    if (err != OK) {
+        deleteCard(*newCardObject);
+        *newCardObject = NULL;
+        ctx->errors++;
+    }
+    return err;
+}
+
+/* Empties the output buffer for a new result. */
+static size_t beginOutput(ParserContext* ctx) {
+    ctx->output.length = 0;
+    ctx->output.str[0] = '\0';
+    return ctx->output.capacity;
+}
+
+static const char* endOutput(ParserContext* ctx, size_t startCapacity, bool isComplete) {
+    if (ctx->output.capacity > startCapacity) ctx->outputGrowths++;
+    if (!isComplete) beginOutput(ctx);
+
+    return ctx->output.str;
+}
+
+const char* getSummaryFromFileCtx(ParserContext* ctx, char* fileName) {
+    CardScanner scanner;
+    size_t startCapacity = ctx->lineCapacity;
+    size_t outputCapacity = beginOutput(ctx);
+    char* name = NULL;
+    int length = 0;
+    bool isInvalid = false;
+    bool isComplete;
+    VCardErrorCode err;
+
+    ctx->calls++;
+    if ((err = openScanner(ctx, &scanner, fileName)) == OK) {
+        err = summarizeScannerLevel(&scanner, resolveValidationLevel(fileName, ctx->level), &name, &length, &isInvalid);
+        closeScanner(ctx, &scanner, startCapacity);
+    }
+
+    if (err != OK) {
+        ctx->errors++;
+        isComplete = appendSummaryError(&ctx->output, fileName, isInvalid);
+    }
+    else {
+        isComplete = appendSummaryJSON(&ctx->output, fileName, name, length);
+    }
+    free(name);
+
+    return endOutput(ctx, outputCapacity, isComplete);
+}
+
+/* Joins a property's values the way valuesToJSON does, into the scratch buffer. */
+static bool joinValues(ParserContext* ctx, const List* values) {
+    ListIterator iter = createIterator((List*) values);
+    char* value;
+    bool isComplete = true;
+
+    ctx->scratch.length = 0;
+    ctx->scratch.str[0] = '\0';
+    if ((value = nextElement(&iter)) != NULL) {
+        isComplete = appendString(&ctx->scratch, value);
+        while (isComplete && (value = nextElement(&iter)) != NULL)
+            isComplete = appendString(&ctx->scratch, ", ") && appendString(&ctx->scratch, value);
+    }
+    return isComplete;
+}
+
+static bool appendPropertyText(ParserContext* ctx, int number, const char* name, const List* values) {
+    char num[12];
+
+    sprintf(num, "%d", number);
+    return joinValues(ctx, values)
+            && appendString(&ctx->output, number == 1 ? "[{\"number\":\"" : ",{\"number\":\"")
+            && appendString(&ctx->output, num) && appendString(&ctx->output, "\",\"name\":")
+            && appendJSONString(&ctx->output, name) && appendString(&ctx->output, ",\"values\":")
+            && appendJSONString(&ctx->output, ctx->scratch.str) && appendString(&ctx->output, "}");
+}
+
+const char* getPropertiesFromFileCtx(ParserContext* ctx, char* fileName) {
+    Card* myCard = NULL;
+    ListIterator iter;
+    Property* aProperty;
+    size_t outputCapacity = beginOutput(ctx);
+    bool isComplete;
+    int number = 1;
+    VCardErrorCode err;
+
+    if ((err = createCardCtx(ctx, fileName, &myCard)) != OK || validateCardLevel(myCard, resolveValidationLevel(fileName, ctx->level)) != OK) {
+        if (err == OK) ctx->errors++;
+        isComplete = appendSummaryError(&ctx->output, fileName, err == OK);
+        deleteCard(myCard);
+        return endOutput(ctx, outputCapacity, isComplete);
+    }
+
+    // FN is always listed first, and entries match appendPropertyEntry's, as in getPropertiesFromFile
+    isComplete = appendPropertyText(ctx, number, myCard->fn->name, myCard->fn->values);
+    iter = createIterator(myCard->optionalProperties);
+    while (isComplete && (aProperty = nextElement(&iter)) != NULL)
+        isComplete = appendPropertyText(ctx, ++number, aProperty->name, aProperty->values);
+    isComplete = isComplete && appendString(&ctx->output, "]");
+
+    deleteCard(myCard);
+    return endOutput(ctx, outputCapacity, isComplete);
+}
+
+const char* getParserContextStats(ParserContext* ctx) {
+    char text[400];
+
+    beginOutput(ctx);
+    snprintf(text, sizeof(text), "{\"calls\":%lu,\"errors\":%lu,\"bytesScanned\":%lu,\"lineGrowths\":%lu,"
+            "\"outputGrowths\":%lu,\"lineCapacity\":%zu,\"outputCapacity\":%zu,\"scratchCapacity\":%zu}",
+            ctx->calls, ctx->errors, ctx->bytesScanned, ctx->lineGrowths, ctx->outputGrowths,
+            ctx->lineCapacity, ctx->output.capacity, ctx->scratch.capacity);
+    if (!appendString(&ctx->output, text)) beginOutput(ctx);
+
+    return ctx->output.str;
+}
+
+// Context used by the *Into functions, one per thread and kept for the thread's lifetime
+static _Thread_local ParserContext* threadContext = NULL;
+
+ParserContext* getThreadParserContext(void) {
+    if (threadContext == NULL) threadContext = createParserContext();
+
+    return threadContext;
+}
+
+static int copyResult(const char* text, char* buffer, int size) {
+    size_t needed;
+
+    if (text == NULL) return 0;
+    needed = strlen(text) + 1;
+    if (buffer != NULL && size > 0 && needed <= (size_t) size) memcpy(buffer, text, needed);
+
+    return needed;
+}
+
+int getSummaryFromFileInto(char* fileName, char* buffer, int size) {
+    ParserContext* ctx;
+
+    if (!(ctx = getThreadParserContext())) return 0;
+
+    return copyResult(getSummaryFromFileCtx(ctx, fileName), buffer, size);
+}
+
+int getPropertiesFromFileInto(char* fileName, char* buffer, int size) {
+    ParserContext* ctx;
+
+    if (!(ctx = getThreadParserContext())) return 0;
+
+    return copyResult(getPropertiesFromFileCtx(ctx, fileName), buffer, size);
+}
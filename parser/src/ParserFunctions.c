@@ -5,106 +5,18 @@
  **/
  
 #include "ParserFunctions.h"
-
-VCardErrorCode readProperty(FILE* fp, char** line) {
-    char buffer[BUFFERSIZE];
-    int c;
-    int checkNext = TRUE;
-
-    if (!feof(fp)) {
-        fgets(buffer, BUFFERSIZE, fp);
-        // Check line ending for CRLF
-        if (strlen(buffer) > 1)
-            if (buffer[strlen(buffer) - 2] == '\r' && buffer[strlen(buffer) - 1] == '\n') 
-                buffer[strlen(buffer) - 2] = '\0';
-            else
-                return INV_PROP;
-        else 
-            return INV_PROP;
-
-        if (!(*line = duplicateString(buffer))) {
-            return OTHER_ERROR;
-        }
-    }
-
-    // Line unfolding
-    while (!feof(fp) && checkNext) {
-        c = fgetc(fp);
-        if (((char) c) == ' ') {
-            fgets(buffer, BUFFERSIZE, fp);
-            // Check line ending for CRLF
-            if (strlen(buffer) > 1)
-                if (buffer[strlen(buffer) - 2] == '\r' && buffer[strlen(buffer) - 1] == '\n') 
-                    buffer[strlen(buffer) - 2] = '\0';
-                else
-                    return INV_PROP;
-            else 
-                return INV_PROP;
-
-            if (!(*line = realloc(*line, sizeof(char) * (strlen(*line) + strlen(buffer) + 1)))) {
-                return OTHER_ERROR;
-            }
-            strcat(*line, buffer);
-        }
-        else {
-            ungetc(c, fp);
-            checkNext = FALSE;
-        }
-    }
-
-    return OK;
-}
-
-VCardErrorCode divideProperty(char* line, char** groupName, char** propertyName, char** parameterValue, char** propertyValue) {
-    char* strptr1 = NULL;
-    char* strptr2 = NULL;
-    char* strptr3 = NULL;
-    char* strptr4 = NULL;
-
-    strptr4 = strTokenizer(line, ':');
-    strptr3 = strTokenizer(line, ';');
-    strptr2 = strTokenizer(line, '.');
-    if (strptr2 == NULL) {
-        strptr2 = line;
-    }
-    else {
-        strptr1 = line;
-    }
-        
-    if (strptr1) {
-        if (!(*groupName = duplicateString(strptr1))) {
-            return OTHER_ERROR;
-        }
-    }
-    if (strptr2) {
-        if (!(*propertyName = duplicateString(strptr2))) {
-            return OTHER_ERROR;
-        }
-    }
-    if (strptr3) {
-        if (!(*parameterValue = duplicateString(strptr3))) {
-            return OTHER_ERROR;
-        }
-    }
-    if (strptr4) {
-        if (!(*propertyValue = duplicateString(strptr4))) {
-            return OTHER_ERROR;
-        }
-    }
-    //printf("%s || %s || %s || %s\n", *groupName, *propertyName, *parameterValue, *propertyValue);
-    return OK;
-}
+#include "StringIntern.h"
 
 VCardErrorCode createProperty(Property** newProperty) {
     if (!(*newProperty = malloc(sizeof(Property)))) {
         return OTHER_ERROR;
     }
 
-    if (!((*newProperty)->name = duplicateString(""))) {
+    if (!((*newProperty)->name = internName(""))) {
         return OTHER_ERROR;
     }
 
-    if (!((*newProperty)->group = duplicateString(""))) {
+    if (!((*newProperty)->group = internName(""))) {
         return OTHER_ERROR;
     }
 
@@ -119,10 +31,15 @@ VCardErrorCode createProperty(Property** newProperty) {
     return OK;
 }
 
-VCardErrorCode createParameter(Parameter** newParameter, char* theValue) {
+VCardErrorCode createParameter(Parameter** newParameter, const char* theName, const char* theValue) {
     if (!(*newParameter = malloc(sizeof(Parameter) + (sizeof(char) * (strlen(theValue) + 1))))) {
         return OTHER_ERROR;
     }
+    if (!((*newParameter)->name = internName(theName))) {
+        free(*newParameter);
+        return OTHER_ERROR;
+    }
+    strcpy((*newParameter)->value, theValue);
 
     return OK;
 }
@@ -139,6 +56,7 @@ VCardErrorCode createDateTime(DateTime** newDateTime, char* parameterValue, char
             strcpy((*newDateTime)->date, "");
             strcpy((*newDateTime)->time, "");
             strcpy((*newDateTime)->text, propertyValue);
+            setDateKeys(*newDateTime);
         }
         else {
             return INV_PROP;
@@ -183,11 +101,44 @@ VCardErrorCode createDateTime(DateTime** newDateTime, char* parameterValue, char
             }
             strcpy((*newDateTime)->time, strptr);
         } 
+        setDateKeys(*newDateTime);
     }
     
     return OK;
 }
 
+static bool isDigits(const char* str, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!isdigit((unsigned char) str[i])) return false;
+    }
+    return true;
+}
+
+/* Derives monthDay and fullDate from the date text.  Text dates and reduced forms such as YYYY-MM get 0. */
+void setDateKeys(DateTime* dateTime) {
+    const char* date = dateTime->date;
+    int month;
+    int day;
+
+    dateTime->monthDay = 0;
+    dateTime->fullDate = 0;
+    if (dateTime->isText) return;
+
+    if (strlen(date) == 8 && isDigits(date, 8)) {
+        month = (date[4] - '0') * 10 + (date[5] - '0');
+        day = (date[6] - '0') * 10 + (date[7] - '0');
+        if (month < 1 || month > 12 || day < 1 || day > 31) return;
+        dateTime->monthDay = month * 100 + day;
+        dateTime->fullDate = atoi(date);
+    }
+    else if (strlen(date) == 6 && date[0] == '-' && date[1] == '-' && isDigits(date + 2, 4)) {
+        month = (date[2] - '0') * 10 + (date[3] - '0');
+        day = (date[4] - '0') * 10 + (date[5] - '0');
+        if (month < 1 || month > 12 || day < 1 || day > 31) return;
+        dateTime->monthDay = month * 100 + day;
+    }
+}
+
 VCardErrorCode addParams(Property* theProperty, char* parameterValues) {
     VCardErrorCode err = OK;
     if (parameterValues == NULL) {
@@ -205,11 +156,9 @@ VCardErrorCode addParams(Property* theProperty, char* parameterValues) {
         strptr3 = strTokenizer(strptr2, '=');
         if (strptr3 == NULL) return INV_PROP;
         if (strcmp(strptr3, "") == 0) return INV_PROP;
-        err = createParameter(&aParameter, strptr3);
+        err = createParameter(&aParameter, strptr2, strptr3);
         if (err != OK) return err;
         insertBack(theProperty->parameters, aParameter);
-        strncpy(aParameter->name, strptr2, 200);
-        strcpy(aParameter->value, strptr3);
         strptr2 = strptr1;
         strptr1 = strTokenizer(strptr2, ';');
     } while (strptr2);
@@ -302,3 +251,91 @@ int stricasecmp(const char* s1, const char* s2) {
     return result;
 }
 /* End of code reuse. */
+
+/* 64-bit FNV-1a hash, used to key on-disk and in-memory lookup tables. */
+unsigned long long hashString(const char* str) {
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+
+    while (*str) {
+        hash ^= (unsigned char) *str++;
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+/* Accepts plain .vcf files and their gzip and zstd compressed forms. */
+bool hasCardExtension(const char* fileName) {
+    char* extension;
+
+    if (fileName == NULL) return false;
+    if (!(extension = strstr(fileName, ".vcf"))) return false;
+    while (strstr(extension + 1, ".vcf")) 
+        extension = strstr(extension + 1, ".vcf");
+
+    return strcmp(extension, ".vcf") == 0 || strcmp(extension, ".vcf.gz") == 0 || strcmp(extension, ".vcf.zst") == 0;
+}
+
+/* Returns a newly allocated copy of str with quotes, backslashes and control characters escaped for JSON. */
+char* escapeJSON(const char* str) {
+    char* escaped;
+    char* p;
+
+    if (str == NULL) return NULL;
+    if (!(escaped = malloc(sizeof(char) * (strlen(str) * 6 + 1)))) return NULL;
+
+    for (p = escaped; *str; str++) {
+        if (*str == '"' || *str == '\\') {
+            *p++ = '\\';
+            *p++ = *str;
+        }
+        else if ((unsigned char) *str < 0x20) {
+            p += sprintf(p, "\\u%04x", (unsigned char) *str);
+        }
+        else {
+            *p++ = *str;
+        }
+    }
+    *p = '\0';
+
+    return escaped;
+}
+
+bool initStringBuffer(StringBuffer* buffer) {
+    buffer->length = 0;
+    buffer->capacity = 256;
+    if (!(buffer->str = malloc(sizeof(char) * buffer->capacity))) return false;
+    buffer->str[0] = '\0';
+
+    return true;
+}
+
+bool appendString(StringBuffer* buffer, const char* str) {
+    size_t length = strlen(str);
+    size_t capacity = buffer->capacity;
+    char* grown;
+
+    while (buffer->length + length + 1 > capacity)
+        capacity *= 2;
+    if (capacity != buffer->capacity) {
+        if (!(grown = realloc(buffer->str, sizeof(char) * capacity))) return false;
+        buffer->str = grown;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->str + buffer->length, str, length + 1);
+    buffer->length += length;
+
+    return true;
+}
+
+/* Appends str as a quoted, escaped JSON string. */
+bool appendJSONString(StringBuffer* buffer, const char* str) {
+    char* escaped;
+    bool result;
+
+    if (!(escaped = escapeJSON(str))) return false;
+    result = appendString(buffer, "\"") && appendString(buffer, escaped) && appendString(buffer, "\"");
+    free(escaped);
+
+    return result;
+}
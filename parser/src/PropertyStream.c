@@ -0,0 +1,86 @@
+/**
+ * @file PropertyStream.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#include <limits.h>
+
+#include "PropertyStream.h"
+
+PropertyStream* openPropertyStream(char* fileName) {
+    PropertyStream* stream;
+    VCardErrorCode err;
+
+    if (fileName == NULL || !(stream = calloc(1, sizeof(PropertyStream)))) return NULL;
+    if (!(stream->fileName = duplicateString(fileName)) || !initStringBuffer(&stream->chunk)) {
+        closePropertyStream(stream);
+        return NULL;
+    }
+
+    if ((err = acquireLazyCard(fileName, &stream->card)) == OK && stream->card->validation != OK) {
+        stream->isInvalid = true;
+        releaseLazyCard(stream->card);
+        stream->card = NULL;
+    }
+    return stream;
+}
+
+const char* nextPropertyChunk(PropertyStream* stream, int maxBytes) {
+    bool isComplete = true;
+
+    stream->chunk.length = 0;
+    stream->chunk.str[0] = '\0';
+    if (stream->isDone) return stream->chunk.str;
+
+    if (stream->card == NULL) {
+        stream->isDone = true;
+        if (!appendSummaryError(&stream->chunk, stream->fileName, stream->isInvalid)) stream->chunk.str[0] = '\0';
+        return stream->chunk.str;
+    }
+
+    if (stream->next == 0) isComplete = appendString(&stream->chunk, "[");
+    while (isComplete && stream->next < getLazyPropertyCount(stream->card) && stream->chunk.length < (size_t) maxBytes) {
+        isComplete = (stream->next == 0 || appendString(&stream->chunk, ","))
+                && appendLazyPropertyEntry(&stream->chunk, stream->next + 1, stream->card, stream->next);
+        stream->next++;
+    }
+    if (isComplete && stream->next == getLazyPropertyCount(stream->card)) {
+        isComplete = appendString(&stream->chunk, "]");
+        stream->isDone = true;
+    }
+
+    // A property that cannot be built ends the listing.  Earlier chunks have already gone
+    // out, so the listing is left unfinished and isFailed tells the caller to abandon it.
+    if (!isComplete) {
+        stream->isDone = true;
+        stream->isFailed = true;
+        stream->chunk.length = 0;
+        stream->chunk.str[0] = '\0';
+    }
+    return stream->chunk.str;
+}
+
+bool isPropertyStreamFailed(PropertyStream* stream) {
+    return stream != NULL && stream->isFailed;
+}
+
+char* listProperties(char* fileName) {
+    PropertyStream* stream;
+    char* text;
+
+    if (!(stream = openPropertyStream(fileName))) return NULL;
+    text = duplicateString(nextPropertyChunk(stream, INT_MAX));
+    closePropertyStream(stream);
+
+    return text;
+}
+
+void closePropertyStream(PropertyStream* stream) {
+    if (stream == NULL) return;
+
+    releaseLazyCard(stream->card);
+    free(stream->fileName);
+    free(stream->chunk.str);
+    free(stream);
+}
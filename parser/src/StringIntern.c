@@ -0,0 +1,47 @@
+/**
+ * @file StringIntern.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#include <stdint.h>
+
+#include "StringIntern.h"
+#include "ParserFunctions.h"
+
+#define NAME_SLOT 16
+
+// Names from RFC 6350, 2426 and 6474, sorted for bsearch.  Each fills a fixed slot of one
+// array, so releaseName can tell a shared name from a copy by its address.
+static const char knownNames[][NAME_SLOT] = {
+    "", "ADR", "AGENT", "ALTID", "ANNIVERSARY", "BDAY", "BEGIN", "BIRTHPLACE", "CALADRURI",
+    "CALSCALE", "CALURI", "CATEGORIES", "CC", "CHARSET", "CLASS", "CLIENTPIDMAP", "CONTACT-URI",
+    "DEATHDATE", "DEATHPLACE", "EMAIL", "ENCODING", "END", "EXPERTISE", "FBURL", "FN", "GENDER",
+    "GEO", "HOBBY", "IMPP", "INDEX", "INTEREST", "KEY", "KIND", "LABEL", "LANG", "LANGUAGE",
+    "LEVEL", "LOGO", "MAILER", "MEDIATYPE", "MEMBER", "N", "NAME", "NICKNAME", "NOTE", "ORG",
+    "ORG-DIRECTORY", "PHOTO", "PID", "PREF", "PRODID", "RELATED", "REV", "ROLE", "SORT-AS",
+    "SORT-STRING", "SOUND", "SOURCE", "TEL", "TITLE", "TYPE", "TZ", "UID", "URL", "VALUE",
+    "VERSION", "XML"
+};
+
+#define KNOWN_COUNT (sizeof(knownNames) / sizeof(knownNames[0]))
+
+static int compareKnownName(const void* key, const void* name) {
+    return strcmp((const char*) key, (const char*) name);
+}
+
+const char* internName(const char* str) {
+    const char* known;
+
+    if (str == NULL) return NULL;
+
+    if ((known = bsearch(str, knownNames, KNOWN_COUNT, NAME_SLOT, compareKnownName))) return known;
+    return duplicateString(str);
+}
+
+void releaseName(const char* name) {
+    uintptr_t address = (uintptr_t) name;
+
+    if (address >= (uintptr_t) knownNames && address < (uintptr_t) (knownNames + KNOWN_COUNT)) return;
+    free((char*) name);
+}
@@ -0,0 +1,609 @@
+/**
+ * @file SummaryIndex.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#define _DEFAULT_SOURCE
+
+#include <stdint.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "SummaryIndex.h"
+#include "ParserFunctions.h"
+#include "CompressedStream.h"
+#include "CardScanner.h"
+#include "PropertyStream.h"
+#include "Corpus.h"
+#include "CardTrust.h"
+
+#define INDEX_MAGIC 0x31584449
+#define INDEX_VERSION 2
+#define INDEX_MIN_CAPACITY 1024
+#define INDEX_MIN_HEAP 65536
+
+typedef struct indexHeader {
+    uint32_t    magic;
+    uint32_t    version;
+    // Number of record slots.  Always a power of two.
+    uint32_t    capacity;
+    uint32_t    count;
+    uint64_t    heapSize;
+    uint64_t    heapUsed;
+    // Set once growIndex has replaced this file; processes still mapping it must reopen the path
+    uint32_t    isRetired;
+    uint32_t    reserved;
+} IndexHeader;
+
+typedef struct indexRecord {
+    uint64_t    hash;
+    // Offsets of NUL-terminated strings in the heap.  Offset 0 is the empty string.
+    uint64_t    fileOffset;
+    uint64_t    nameOffset;
+    // Offset of the cached property listing, or 0 if it has not been built since the last change
+    uint64_t    propertiesOffset;
+    // -1 while the record describes an upload that has not been written yet
+    int64_t     mtimeSec;
+    int64_t     mtimeNsec;
+    int64_t     size;
+    int32_t     opLength;
+    // VCardErrorCode of the last summary, and whether it came from validateCard
+    int32_t     result;
+    int32_t     isInvalid;
+    int32_t     isUsed;
+} IndexRecord;
+
+struct summaryIndex {
+    char*   path;
+    int     fd;
+    size_t  mapSize;
+    char*   map;
+    // flock'd around every access, so processes sharing the file see consistent records
+    int     lockFd;
+};
+
+#define HEADER(map) ((IndexHeader*) (map))
+#define RECORDS(map) ((IndexRecord*) ((map) + sizeof(IndexHeader)))
+#define HEAP(map) ((map) + sizeof(IndexHeader) + HEADER(map)->capacity * sizeof(IndexRecord))
+
+static size_t indexFileSize(uint32_t capacity, uint64_t heapSize) {
+    return sizeof(IndexHeader) + capacity * sizeof(IndexRecord) + heapSize;
+}
+
+static VCardErrorCode initIndexFile(int fd, uint32_t capacity, uint64_t heapSize) {
+    IndexHeader header;
+    char empty = '\0';
+
+    if (ftruncate(fd, 0) != 0) return WRITE_ERROR;
+    if (ftruncate(fd, indexFileSize(capacity, heapSize)) != 0) return WRITE_ERROR;
+
+    header.magic = INDEX_MAGIC;
+    header.version = INDEX_VERSION;
+    header.capacity = capacity;
+    header.count = 0;
+    header.heapSize = heapSize;
+    header.heapUsed = 1;
+    header.isRetired = 0;
+    header.reserved = 0;
+    if (pwrite(fd, &header, sizeof(header), 0) != sizeof(header)) return WRITE_ERROR;
+    if (pwrite(fd, &empty, 1, indexFileSize(capacity, 0)) != 1) return WRITE_ERROR;
+
+    return OK;
+}
+
+static char* mapIndexFile(int fd, size_t* mapSize) {
+    struct stat st;
+    char* map;
+
+    if (fstat(fd, &st) != 0) return NULL;
+    if (st.st_size < sizeof(IndexHeader)) return NULL;
+    if ((map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) return NULL;
+
+    if (HEADER(map)->magic != INDEX_MAGIC || HEADER(map)->version != INDEX_VERSION
+            || indexFileSize(HEADER(map)->capacity, HEADER(map)->heapSize) != st.st_size) {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+    *mapSize = st.st_size;
+    return map;
+}
+
+static IndexRecord* findRecord(char* map, const char* fileName, uint64_t hash) {
+    IndexRecord* records = RECORDS(map);
+    uint32_t mask = HEADER(map)->capacity - 1;
+    uint32_t i = hash & mask;
+
+    while (records[i].isUsed) {
+        if (records[i].hash == hash && strcmp(HEAP(map) + records[i].fileOffset, fileName) == 0)
+            break;
+        i = (i + 1) & mask;
+    }
+
+    return &records[i];
+}
+
+static uint64_t heapAppend(char* map, const char* str) {
+    IndexHeader* header = HEADER(map);
+    uint64_t offset = header->heapUsed;
+    size_t length = strlen(str) + 1;
+
+    if (length == 1) return 0;
+    if (offset + length > header->heapSize) return 0;
+
+    memcpy(HEAP(map) + offset, str, length);
+    header->heapUsed += length;
+    return offset;
+}
+
+/* Bytes of the heap still referenced by records, counting the empty string at offset 0. */
+static uint64_t liveHeapBytes(char* map) {
+    IndexRecord* records = RECORDS(map);
+    uint64_t live = 1;
+
+    for (uint32_t i = 0; i < HEADER(map)->capacity; i++) {
+        if (!records[i].isUsed) continue;
+        if (records[i].fileOffset) live += strlen(HEAP(map) + records[i].fileOffset) + 1;
+        if (records[i].nameOffset) live += strlen(HEAP(map) + records[i].nameOffset) + 1;
+        if (records[i].propertiesOffset) live += strlen(HEAP(map) + records[i].propertiesOffset) + 1;
+    }
+    return live;
+}
+
+/*  Rebuilds the index into a new file of the given size, compacting the heap, then atomically
+    replaces the old file.  Called with the current size to only drop dead strings.
+*/
+static VCardErrorCode growIndex(SummaryIndex* index, uint32_t capacity, uint64_t heapSize) {
+    IndexRecord* oldRecords = RECORDS(index->map);
+    IndexRecord* newRecord;
+    char* tmpPath;
+    char* map;
+    size_t mapSize;
+    int fd;
+
+    if (!(tmpPath = malloc(sizeof(char) * (strlen(index->path) + 5)))) return OTHER_ERROR;
+    sprintf(tmpPath, "%s.tmp", index->path);
+
+    if ((fd = open(tmpPath, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0) {
+        free(tmpPath);
+        return WRITE_ERROR;
+    }
+    if (initIndexFile(fd, capacity, heapSize) != OK || !(map = mapIndexFile(fd, &mapSize))) {
+        close(fd);
+        unlink(tmpPath);
+        free(tmpPath);
+        return WRITE_ERROR;
+    }
+
+    for (uint32_t i = 0; i < HEADER(index->map)->capacity; i++) {
+        if (!oldRecords[i].isUsed) continue;
+        const char* oldFile = HEAP(index->map) + oldRecords[i].fileOffset;
+        newRecord = findRecord(map, oldFile, oldRecords[i].hash);
+        *newRecord = oldRecords[i];
+        newRecord->fileOffset = heapAppend(map, oldFile);
+        newRecord->nameOffset = heapAppend(map, HEAP(index->map) + oldRecords[i].nameOffset);
+        newRecord->propertiesOffset = heapAppend(map, HEAP(index->map) + oldRecords[i].propertiesOffset);
+        HEADER(map)->count++;
+    }
+
+    if (rename(tmpPath, index->path) != 0) {
+        munmap(map, mapSize);
+        close(fd);
+        unlink(tmpPath);
+        free(tmpPath);
+        return WRITE_ERROR;
+    }
+    free(tmpPath);
+
+    HEADER(index->map)->isRetired = 1;
+    munmap(index->map, index->mapSize);
+    close(index->fd);
+    index->fd = fd;
+    index->map = map;
+    index->mapSize = mapSize;
+
+    return OK;
+}
+
+/* Stores a summary, and the property listing if properties is not NULL.  Storing without a listing
+   drops any cached one.  The caller holds the exclusive lock. */
+static VCardErrorCode storeRecord(SummaryIndex* index, const char* fileName, uint64_t hash, const struct stat* st,
+        VCardErrorCode result, bool isInvalid, const char* name, int opLength, const char* properties) {
+    IndexRecord* record = findRecord(index->map, fileName, hash);
+    size_t needed = strlen(fileName) + strlen(name) + (properties ? strlen(properties) : 0) + 3;
+    uint32_t capacity = HEADER(index->map)->capacity;
+    uint64_t heapSize = HEADER(index->map)->heapSize;
+    uint64_t live;
+    bool isRebuilt = false;
+    VCardErrorCode err;
+
+    // Keep the load factor under 0.7 and make room in the heap before writing anything
+    if (!record->isUsed && (HEADER(index->map)->count + 1) * 10 > capacity * 7) {
+        capacity *= 2;
+        isRebuilt = true;
+    }
+    if (HEADER(index->map)->heapUsed + needed > heapSize) {
+        // Replaced names and listings leave dead strings behind, so the heap is sized from what is
+        // still live.  With at least half of it free after compacting, it keeps its size.
+        live = liveHeapBytes(index->map);
+        while ((live + needed) * 2 > heapSize)
+            heapSize *= 2;
+        isRebuilt = true;
+    }
+    if (isRebuilt) {
+        if ((err = growIndex(index, capacity, heapSize)) != OK) return err;
+        record = findRecord(index->map, fileName, hash);
+    }
+
+    if (!record->isUsed) {
+        record->hash = hash;
+        record->fileOffset = heapAppend(index->map, fileName);
+        HEADER(index->map)->count++;
+    }
+    if (strcmp(HEAP(index->map) + record->nameOffset, name) != 0)
+        record->nameOffset = heapAppend(index->map, name);
+    record->propertiesOffset = properties ? heapAppend(index->map, properties) : 0;
+    record->mtimeSec = st->st_mtim.tv_sec;
+    record->mtimeNsec = st->st_mtim.tv_nsec;
+    record->size = st->st_size;
+    record->opLength = opLength;
+    record->result = result;
+    record->isInvalid = isInvalid;
+    record->isUsed = 1;
+
+    return OK;
+}
+
+/* Maps the file now at the index's path, after another process has replaced the one mapped. */
+static VCardErrorCode reopenIndex(SummaryIndex* index) {
+    char* map;
+    size_t mapSize;
+    int fd;
+
+    if ((fd = open(index->path, O_RDWR)) < 0) return INV_FILE;
+    if (!(map = mapIndexFile(fd, &mapSize))) {
+        close(fd);
+        return INV_FILE;
+    }
+
+    munmap(index->map, index->mapSize);
+    close(index->fd);
+    index->fd = fd;
+    index->map = map;
+    index->mapSize = mapSize;
+    return OK;
+}
+
+/* Takes the cross-process lock (LOCK_SH or LOCK_EX) and makes sure the current file is mapped. */
+static VCardErrorCode lockIndex(SummaryIndex* index, int operation) {
+    if (flock(index->lockFd, operation) != 0) return OTHER_ERROR;
+
+    // Only a lock holder can retire a file, so once the current one is mapped it stays current
+    if (HEADER(index->map)->isRetired && reopenIndex(index) != OK) {
+        flock(index->lockFd, LOCK_UN);
+        return OTHER_ERROR;
+    }
+    return OK;
+}
+
+static void unlockIndex(SummaryIndex* index) {
+    flock(index->lockFd, LOCK_UN);
+}
+
+/*  Whether a record still describes the file.  Only reads the record, since the caller may hold
+    just the shared lock.  A pending upload never matches until confirmUploadSummary gives it the
+    written file's stat.
+*/
+static bool isRecordCurrent(const IndexRecord* record, const struct stat* st) {
+    if (!record->isUsed || record->mtimeSec == -1) return false;
+
+    return record->mtimeSec == st->st_mtim.tv_sec && record->mtimeNsec == st->st_mtim.tv_nsec
+            && record->size == st->st_size;
+}
+
+SummaryIndex* openSummaryIndex(const char* indexFile) {
+    SummaryIndex* index;
+    char* lockPath;
+
+    if (indexFile == NULL) return NULL;
+    if (!(index = malloc(sizeof(SummaryIndex)))) return NULL;
+    if (!(index->path = duplicateString(indexFile))) {
+        free(index);
+        return NULL;
+    }
+    if (!(lockPath = malloc(sizeof(char) * (strlen(indexFile) + 6)))) {
+        free(index->path);
+        free(index);
+        return NULL;
+    }
+    sprintf(lockPath, "%s.lock", indexFile);
+    index->lockFd = open(lockPath, O_RDWR | O_CREAT, 0644);
+    free(lockPath);
+    if (index->lockFd < 0) {
+        free(index->path);
+        free(index);
+        return NULL;
+    }
+
+    // Processes opening the index together must not both initialize it
+    flock(index->lockFd, LOCK_EX);
+    if ((index->fd = open(indexFile, O_RDWR | O_CREAT, 0644)) < 0) {
+        close(index->lockFd);
+        free(index->path);
+        free(index);
+        return NULL;
+    }
+
+    // A missing, truncated or foreign file is simply reinitialized; it is only a cache
+    if (!(index->map = mapIndexFile(index->fd, &index->mapSize))) {
+        if (initIndexFile(index->fd, INDEX_MIN_CAPACITY, INDEX_MIN_HEAP) != OK
+                || !(index->map = mapIndexFile(index->fd, &index->mapSize))) {
+            close(index->fd);
+            close(index->lockFd);
+            free(index->path);
+            free(index);
+            return NULL;
+        }
+    }
+    unlockIndex(index);
+
+    return index;
+}
+
+void closeSummaryIndex(SummaryIndex* index) {
+    if (index == NULL) return;
+
+    munmap(index->map, index->mapSize);
+    close(index->fd);
+    close(index->lockFd);
+    free(index->path);
+    free(index);
+}
+
+char* getSummaryFromIndex(SummaryIndex* index, char* fileName) {
+    char* name = NULL;
+    char* JSONstr;
+    int length = 0;
+    bool isInvalid = false;
+
+    if (index == NULL) return getSummaryFromFile(fileName);
+    if (fileName == NULL) return NULL;
+
+    if (getIndexedSummary(index, fileName, &name, &length, &isInvalid) != OK)
+        return summaryErrorToJSON(fileName, isInvalid);
+
+    JSONstr = summaryToJSON(fileName, name, length);
+    free(name);
+    return JSONstr;
+}
+
+VCardErrorCode getIndexedSummary(SummaryIndex* index, char* fileName, char** name, int* opLength, bool* isInvalid) {
+    IndexRecord* record;
+    struct stat st;
+    uint64_t hash;
+    VCardErrorCode err;
+
+    *name = NULL;
+    *opLength = 0;
+    *isInvalid = false;
+    if (fileName == NULL) return OTHER_ERROR;
+    if (index == NULL) return summarizeFile(fileName, name, opLength, isInvalid);
+    if (stat(fileName, &st) != 0) return INV_FILE;
+
+    hash = hashString(fileName);
+    if (lockIndex(index, LOCK_SH) != OK) return summarizeFile(fileName, name, opLength, isInvalid);
+    record = findRecord(index->map, fileName, hash);
+    if (isRecordCurrent(record, &st)) {
+        err = record->result;
+        *opLength = record->opLength;
+        *isInvalid = record->isInvalid;
+        if (err == OK && !(*name = duplicateString(HEAP(index->map) + record->nameOffset))) err = OTHER_ERROR;
+        unlockIndex(index);
+        return err;
+    }
+    unlockIndex(index);
+
+    // Parse without holding the lock, so other processes are not kept waiting
+    err = summarizeFile(fileName, name, opLength, isInvalid);
+    if (lockIndex(index, LOCK_EX) == OK) {
+        storeRecord(index, fileName, hash, &st, err, *isInvalid, err == OK ? *name : "", *opLength, NULL);
+        unlockIndex(index);
+    }
+    if (err != OK) {
+        free(*name);
+        *name = NULL;
+    }
+    return err;
+}
+
+char* getPropertiesFromIndex(SummaryIndex* index, char* fileName) {
+    IndexRecord* record;
+    PropertyStream* stream;
+    struct stat st;
+    uint64_t hash;
+    char* name = NULL;
+    char* JSONstr = NULL;
+    int length = 0;
+    bool isInvalid = false;
+    VCardErrorCode err;
+
+    if (index == NULL) return listProperties(fileName);
+    if (fileName == NULL) return NULL;
+    if (stat(fileName, &st) != 0) return summaryErrorToJSON(fileName, false);
+
+    hash = hashString(fileName);
+    if (lockIndex(index, LOCK_SH) != OK) return listProperties(fileName);
+    record = findRecord(index->map, fileName, hash);
+    if (isRecordCurrent(record, &st)) {
+        if (record->result != OK)
+            JSONstr = summaryErrorToJSON(fileName, record->isInvalid);
+        else if (record->propertiesOffset != 0)
+            JSONstr = duplicateString(HEAP(index->map) + record->propertiesOffset);
+    }
+    unlockIndex(index);
+    if (JSONstr != NULL) return JSONstr;
+
+    // The record is refreshed as a whole, so its summary and listing always describe the same file
+    if ((err = summarizeFile(fileName, &name, &length, &isInvalid)) == OK) {
+        if (!(stream = openPropertyStream(fileName))) {
+            free(name);
+            return NULL;
+        }
+        JSONstr = duplicateString(nextPropertyChunk(stream, INT_MAX));
+        if (stream->card == NULL) {
+            err = INV_CARD;
+            isInvalid = stream->isInvalid;
+        }
+        closePropertyStream(stream);
+    }
+
+    if (lockIndex(index, LOCK_EX) == OK) {
+        storeRecord(index, fileName, hash, &st, err, isInvalid, err == OK ? name : "", length, err == OK ? JSONstr : NULL);
+        unlockIndex(index);
+    }
+    free(name);
+
+    if (err != OK) {
+        free(JSONstr);
+        return summaryErrorToJSON(fileName, isInvalid);
+    }
+    return JSONstr;
+}
+
+char* getSummaryFromBuffer(SummaryIndex* index, char* fileName, const char* data, size_t len) {
+    FILE* fp;
+    struct stat st;
+    char* name = NULL;
+    char* JSONstr;
+    int length = 0;
+    bool isInvalid = false;
+    VCardErrorCode err;
+
+    if (fileName == NULL) return NULL;
+    if (!hasCardExtension(fileName))
+        return duplicateString("Error: Could not create card");
+
+    // The file will be read by its extension, so bytes compressed otherwise would pass here and fail there
+    if (compressionFromData(data, len) != compressionFromName(fileName) || !(fp = openCardBuffer(data, len)))
+        return duplicateString("Error: Could not create card");
+    err = summarizeStream(fp, &name, &length, &isInvalid);
+    fclose(fp);
+    if (err != OK) {
+        free(name);
+        return duplicateString(isInvalid ? "Error: Not a valid card" : "Error: Could not create card");
+    }
+
+    // Record the summary as pending until confirmUploadSummary sees the written file
+    if (index != NULL && lockIndex(index, LOCK_EX) == OK) {
+        memset(&st, 0, sizeof(st));
+        st.st_mtim.tv_sec = -1;
+        st.st_size = len;
+        storeRecord(index, fileName, hashString(fileName), &st, OK, false, name, length, NULL);
+        unlockIndex(index);
+    }
+
+    JSONstr = summaryToJSON(fileName, name, length);
+    free(name);
+    return JSONstr;
+}
+
+VCardErrorCode confirmUploadSummary(SummaryIndex* index, char* fileName) {
+    IndexRecord* record;
+    struct stat st;
+    VCardErrorCode err = INV_FILE;
+
+    if (index == NULL || fileName == NULL) return OTHER_ERROR;
+    if (stat(fileName, &st) != 0) return INV_FILE;
+
+    if (lockIndex(index, LOCK_EX) != OK) return OTHER_ERROR;
+    record = findRecord(index->map, fileName, hashString(fileName));
+    // A size that differs means something other than the validated upload is at the path now
+    if (record->isUsed && record->mtimeSec == -1 && record->size == st.st_size) {
+        record->mtimeSec = st.st_mtim.tv_sec;
+        record->mtimeNsec = st.st_mtim.tv_nsec;
+        err = OK;
+    }
+    unlockIndex(index);
+
+    return err;
+}
+
+// One file's part in refreshSummaryIndex.  Stale files are summarized by a worker thread.
+typedef struct refreshSlot {
+    struct stat     st;
+    bool            isStale;
+    VCardErrorCode  result;
+    bool            isInvalid;
+    char*           name;
+    int             opLength;
+} RefreshSlot;
+
+typedef struct refreshJob {
+    ValidationLevel level;
+    RefreshSlot*    slots;
+} RefreshJob;
+
+static void summarizeStale(int index, const char* file, void* arg) {
+    RefreshJob* job = (RefreshJob*) arg;
+    RefreshSlot* slot = &job->slots[index];
+
+    if (slot->isStale)
+        slot->result = summarizeFileLevel(file, resolveValidationLevel(file, job->level), &slot->name, &slot->opLength, &slot->isInvalid);
+}
+
+VCardErrorCode refreshSummaryIndex(SummaryIndex* index, char** files, int count, ValidationLevel level) {
+    RefreshJob job;
+    int staleCount = 0;
+
+    if (index == NULL || (files == NULL && count > 0)) return OTHER_ERROR;
+    if (!(job.slots = calloc(count + 1, sizeof(RefreshSlot)))) return OTHER_ERROR;
+    job.level = level;
+
+    // Files are stat'd before they are parsed, so a change made meanwhile leaves the record stale
+    if (lockIndex(index, LOCK_SH) != OK) {
+        free(job.slots);
+        return OTHER_ERROR;
+    }
+    for (int i = 0; i < count; i++) {
+        if (stat(files[i], &job.slots[i].st) != 0) continue;
+        if (!isRecordCurrent(findRecord(index->map, files[i], hashString(files[i])), &job.slots[i].st)) {
+            job.slots[i].isStale = true;
+            staleCount++;
+        }
+    }
+    unlockIndex(index);
+
+    if (staleCount > 0) {
+        forEachCardFile(files, count, summarizeStale, &job, 0);
+
+        if (lockIndex(index, LOCK_EX) == OK) {
+            for (int i = 0; i < count; i++) {
+                RefreshSlot* slot = &job.slots[i];
+
+                if (slot->isStale)
+                    storeRecord(index, files[i], hashString(files[i]), &slot->st, slot->result, slot->isInvalid,
+                            slot->result == OK ? slot->name : "", slot->opLength, NULL);
+            }
+            unlockIndex(index);
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+        free(job.slots[i].name);
+    free(job.slots);
+    return OK;
+}
+
+int getSummaryIndexCount(SummaryIndex* index) {
+    int count;
+
+    if (index == NULL || lockIndex(index, LOCK_SH) != OK) return -1;
+    count = HEADER(index->map)->count;
+    unlockIndex(index);
+
+    return count;
+}
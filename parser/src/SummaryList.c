@@ -0,0 +1,387 @@
+/**
+ * @file SummaryList.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#include <sys/stat.h>
+
+#include "SummaryList.h"
+#include "Corpus.h"
+#include "CardTrust.h"
+#include "ParserFunctions.h"
+
+// What one file contributes to the list, filled in by a worker thread
+typedef struct summarySlot {
+    bool    isValid;
+    char*   name;
+    int     opLength;
+} SummarySlot;
+
+typedef struct summaryJob {
+    ValidationLevel level;
+    SummarySlot*    slots;
+} SummaryJob;
+
+// An entry's sort fields copied side by side, so qsort compares without following entry indices
+typedef struct sortItem {
+    unsigned long long  prefix;
+    const char*         key;
+    int                 opLength;
+    int                 entry;
+} SortItem;
+
+static void summarizeSlot(int index, const char* file, void* arg) {
+    SummaryJob* job = (SummaryJob*) arg;
+    SummarySlot* slot = &job->slots[index];
+    bool isInvalid;
+
+    if (summarizeFileLevel(file, resolveValidationLevel(file, job->level), &slot->name, &slot->opLength, &isInvalid) == OK)
+        slot->isValid = true;
+}
+
+/* Folds a name to lower case, ASCII letters and the Latin-1 capitals that UTF-8 writes as 0xC3 0x80 to 0xC3 0x9E. */
+static char* foldName(const char* name) {
+    const unsigned char* in = (const unsigned char*) name;
+    size_t length = strlen(name);
+    unsigned char* key;
+
+    if (!(key = malloc(sizeof(char) * (length + 1)))) return NULL;
+    for (size_t i = 0; i <= length; i++) {
+        if (in[i] >= 'A' && in[i] <= 'Z') {
+            key[i] = in[i] + ('a' - 'A');
+        }
+        else if (in[i] == 0xC3 && in[i + 1] >= 0x80 && in[i + 1] <= 0x9E && in[i + 1] != 0x97) {
+            // The multiplication sign 0xC3 0x97 sits among the capitals but has no lower case
+            key[i] = in[i];
+            key[i + 1] = in[i + 1] + 0x20;
+            i++;
+        }
+        else {
+            key[i] = in[i];
+        }
+    }
+    return (char*) key;
+}
+
+static unsigned long long keyPrefix(const char* key) {
+    unsigned long long prefix = 0;
+    int i;
+
+    for (i = 0; i < 8 && key[i]; i++)
+        prefix = (prefix << 8) | (unsigned char) key[i];
+    return prefix << (8 * (8 - i));
+}
+
+static int compareNames(const void* first, const void* second) {
+    const SortItem* one = (const SortItem*) first;
+    const SortItem* two = (const SortItem*) second;
+    int result;
+
+    if (one->prefix != two->prefix) return one->prefix < two->prefix ? -1 : 1;
+    if ((result = strcmp(one->key, two->key)) != 0) return result;
+    return one->entry - two->entry;
+}
+
+static int compareCounts(const void* first, const void* second) {
+    const SortItem* one = (const SortItem*) first;
+    const SortItem* two = (const SortItem*) second;
+
+    if (one->opLength != two->opLength) return one->opLength - two->opLength;
+    return compareNames(first, second);
+}
+
+/* Sorts the entries with compare and writes their indices to order. */
+static bool sortEntries(const SummaryList* list, int (*compare)(const void*, const void*), int* order) {
+    SortItem* items;
+
+    if (!(items = malloc(sizeof(SortItem) * (list->count + 1)))) return false;
+    for (int i = 0; i < list->count; i++) {
+        items[i].prefix = list->entries[i].keyPrefix;
+        items[i].key = list->entries[i].key;
+        items[i].opLength = list->entries[i].opLength;
+        items[i].entry = i;
+    }
+    qsort(items, list->count, sizeof(SortItem), compare);
+    for (int i = 0; i < list->count; i++)
+        order[i] = items[i].entry;
+
+    free(items);
+    return true;
+}
+
+/* Fills in an entry's sort key from its name. */
+static bool setEntryKey(SummaryEntry* entry) {
+    if (!(entry->key = foldName(entry->name))) {
+        entry->keyPrefix = 0;
+        return false;
+    }
+    entry->keyPrefix = keyPrefix(entry->key);
+    return true;
+}
+
+SummaryList* buildSummaryList(char* dirName, char* indexFile, ValidationLevel level) {
+    SummaryList* list;
+    SummaryIndex* index = NULL;
+    SummaryJob job;
+    SummaryEntry* entry;
+    char** files;
+    int count;
+    bool isInvalid;
+    bool isComplete = true;
+
+    if (dirName == NULL || listCardFiles(dirName, &files, &count) != OK) return NULL;
+
+    job.level = level;
+    job.slots = calloc(count + 1, sizeof(SummarySlot));
+    if ((list = calloc(1, sizeof(SummaryList)))) {
+        list->invalidFiles = malloc(sizeof(char*) * (count + 1));
+        list->entries = malloc(sizeof(SummaryEntry) * (count + 1));
+        list->byName = malloc(sizeof(int) * (count + 1));
+        list->byCount = malloc(sizeof(int) * (count + 1));
+    }
+    if (!job.slots || !list || !list->invalidFiles || !list->entries || !list->byName || !list->byCount) {
+        freeSummaryList(list);
+        free(job.slots);
+        freeCardFiles(files, count);
+        return NULL;
+    }
+
+    // The index is opened here rather than passed in, since a build may run on another thread than
+    // the caller's own handle.  Only files whose records are stale are parsed.
+    if (indexFile != NULL && (index = openSummaryIndex(indexFile)) && refreshSummaryIndex(index, files, count, level) != OK) {
+        closeSummaryIndex(index);
+        index = NULL;
+    }
+    if (index != NULL) {
+        for (int i = 0; i < count; i++)
+            job.slots[i].isValid = getIndexedSummary(index, files[i], &job.slots[i].name, &job.slots[i].opLength, &isInvalid) == OK;
+        closeSummaryIndex(index);
+    }
+    else {
+        forEachCardFile(files, count, summarizeSlot, &job, 0);
+    }
+
+    // Entries and invalid files take over the listed paths, so both stay in file name order
+    list->fileCount = count;
+    for (int i = 0; i < count; i++) {
+        if (!job.slots[i].isValid) {
+            list->invalidFiles[list->invalidCount++] = files[i];
+            files[i] = NULL;
+            continue;
+        }
+
+        entry = &list->entries[list->count];
+        entry->file = files[i];
+        entry->name = job.slots[i].name;
+        entry->opLength = job.slots[i].opLength;
+        files[i] = NULL;
+        if (!setEntryKey(entry)) isComplete = false;
+        list->count++;
+    }
+    free(job.slots);
+    freeCardFiles(files, count);
+
+    if (!isComplete || !sortEntries(list, compareNames, list->byName) || !sortEntries(list, compareCounts, list->byCount)) {
+        freeSummaryList(list);
+        return NULL;
+    }
+    return list;
+}
+
+/* Index of the first entry whose file is not before fileName, and whether it is fileName. */
+static int findEntry(const SummaryList* list, const char* fileName, bool* isFound) {
+    int low = 0;
+    int high = list->count;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+
+        if (strcmp(list->entries[mid].file, fileName) < 0) low = mid + 1;
+        else high = mid;
+    }
+    *isFound = low < list->count && strcmp(list->entries[low].file, fileName) == 0;
+    return low;
+}
+
+/* Index of the first invalid file not before fileName, and whether it is fileName. */
+static int findInvalidFile(const SummaryList* list, const char* fileName, bool* isFound) {
+    int low = 0;
+    int high = list->invalidCount;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+
+        if (strcmp(list->invalidFiles[mid], fileName) < 0) low = mid + 1;
+        else high = mid;
+    }
+    *isFound = low < list->invalidCount && strcmp(list->invalidFiles[low], fileName) == 0;
+    return low;
+}
+
+/* Takes an entry out of both orders and renumbers the entries after it. */
+static void removeFromOrder(int* order, int count, int entry) {
+    int out = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (order[i] == entry) continue;
+        order[out++] = order[i] > entry ? order[i] - 1 : order[i];
+    }
+}
+
+/* Renumbers the entries from entry on and puts entry in its sorted place in an order of count - 1 entries. */
+static void insertIntoOrder(const SummaryList* list, int* order, int entry, int (*compare)(const void*, const void*)) {
+    SortItem item;
+    SortItem other;
+    int low = 0;
+    int high = list->count - 1;
+
+    for (int i = 0; i < list->count - 1; i++) {
+        if (order[i] >= entry) order[i]++;
+    }
+
+    item.prefix = list->entries[entry].keyPrefix;
+    item.key = list->entries[entry].key;
+    item.opLength = list->entries[entry].opLength;
+    item.entry = entry;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+
+        other.prefix = list->entries[order[mid]].keyPrefix;
+        other.key = list->entries[order[mid]].key;
+        other.opLength = list->entries[order[mid]].opLength;
+        other.entry = order[mid];
+        if (compare(&other, &item) < 0) low = mid + 1;
+        else high = mid;
+    }
+    memmove(order + low + 1, order + low, sizeof(int) * (list->count - 1 - low));
+    order[low] = entry;
+}
+
+/* Whether listCardFiles would list a path. */
+static bool isListedFile(const char* fileName) {
+    const char* base = strrchr(fileName, '/');
+    struct stat st;
+
+    base = base ? base + 1 : fileName;
+    return base[0] != '.' && hasCardExtension(base) && stat(fileName, &st) == 0;
+}
+
+VCardErrorCode updateSummaryList(SummaryList* list, SummaryIndex* index, char* fileName) {
+    SummaryEntry entry;
+    void* grown;
+    char* path;
+    bool isFound;
+    bool isInvalid;
+    int at;
+
+    if (list == NULL || fileName == NULL) return OTHER_ERROR;
+
+    // Drop whatever the list held for the file
+    at = findEntry(list, fileName, &isFound);
+    if (isFound) {
+        free(list->entries[at].file);
+        free(list->entries[at].name);
+        free(list->entries[at].key);
+        memmove(list->entries + at, list->entries + at + 1, sizeof(SummaryEntry) * (list->count - at - 1));
+        removeFromOrder(list->byName, list->count, at);
+        removeFromOrder(list->byCount, list->count, at);
+        list->count--;
+        list->fileCount--;
+    }
+    else {
+        at = findInvalidFile(list, fileName, &isFound);
+        if (isFound) {
+            free(list->invalidFiles[at]);
+            memmove(list->invalidFiles + at, list->invalidFiles + at + 1, sizeof(char*) * (list->invalidCount - at - 1));
+            list->invalidCount--;
+            list->fileCount--;
+        }
+    }
+    if (!isListedFile(fileName)) return OK;
+
+    // Then add what it is now.  Every array keeps one spare slot, as buildSummaryList allocates them.
+    memset(&entry, 0, sizeof(entry));
+    if (getIndexedSummary(index, fileName, &entry.name, &entry.opLength, &isInvalid) != OK) {
+        if (!(grown = realloc(list->invalidFiles, sizeof(char*) * (list->invalidCount + 2)))) return OTHER_ERROR;
+        list->invalidFiles = grown;
+        if (!(path = duplicateString(fileName))) return OTHER_ERROR;
+        at = findInvalidFile(list, fileName, &isFound);
+        memmove(list->invalidFiles + at + 1, list->invalidFiles + at, sizeof(char*) * (list->invalidCount - at));
+        list->invalidFiles[at] = path;
+        list->invalidCount++;
+        list->fileCount++;
+        return OK;
+    }
+
+    if (!(entry.file = duplicateString(fileName)) || !setEntryKey(&entry)) {
+        free(entry.file);
+        free(entry.name);
+        return OTHER_ERROR;
+    }
+    if ((grown = realloc(list->entries, sizeof(SummaryEntry) * (list->count + 2)))) list->entries = grown;
+    if (grown && (grown = realloc(list->byName, sizeof(int) * (list->count + 2)))) list->byName = grown;
+    if (grown && (grown = realloc(list->byCount, sizeof(int) * (list->count + 2)))) list->byCount = grown;
+    if (!grown) {
+        free(entry.file);
+        free(entry.name);
+        free(entry.key);
+        return OTHER_ERROR;
+    }
+
+    at = findEntry(list, fileName, &isFound);
+    memmove(list->entries + at + 1, list->entries + at, sizeof(SummaryEntry) * (list->count - at));
+    list->entries[at] = entry;
+    list->count++;
+    list->fileCount++;
+    insertIntoOrder(list, list->byName, at, compareNames);
+    insertIntoOrder(list, list->byCount, at, compareCounts);
+    return OK;
+}
+
+void freeSummaryList(SummaryList* list) {
+    if (list == NULL) return;
+
+    for (int i = 0; list->entries && i < list->count; i++) {
+        free(list->entries[i].file);
+        free(list->entries[i].name);
+        free(list->entries[i].key);
+    }
+    for (int i = 0; list->invalidFiles && i < list->invalidCount; i++)
+        free(list->invalidFiles[i]);
+    free(list->invalidFiles);
+    free(list->entries);
+    free(list->byName);
+    free(list->byCount);
+    free(list);
+}
+
+char* getSummaryPage(SummaryList* list, char* sort, int offset, int limit, bool isDescending) {
+    StringBuffer buffer;
+    const SummaryEntry* entry;
+    const int* order = NULL;
+    char num[80];
+    int total = list ? list->count : 0;
+    int index;
+
+    if (!initStringBuffer(&buffer)) return NULL;
+    if (offset < 0) offset = 0;
+    if (limit < 0) limit = 0;
+
+    // File order is the entries' own order
+    if (list && (sort == NULL || strcmp(sort, "file") != 0))
+        order = sort && strcmp(sort, "count") == 0 ? list->byCount : list->byName;
+
+    sprintf(num, "{\"total\":%d,\"invalid\":%d,\"offset\":%d,\"summaries\":[", total, list ? list->invalidCount : 0, offset);
+    appendString(&buffer, num);
+    for (int i = offset; i < total && i - offset < limit; i++) {
+        index = isDescending ? total - 1 - i : i;
+        entry = &list->entries[order ? order[index] : index];
+
+        if (i > offset) appendString(&buffer, ",");
+        appendSummaryJSON(&buffer, entry->file, entry->name, entry->opLength);
+    }
+    appendString(&buffer, "]}");
+
+    return buffer.str;
+}
@@ -4,193 +4,64 @@
  * @date September 2018
  **/
 
+#define _DEFAULT_SOURCE
+
 #include "VCardParser.h"
 #include "ParserFunctions.h"
+#include "StringIntern.h"
+#include "CompressedStream.h"
+#include "CardScanner.h"
+#include "LazyCard.h"
+#include "CardTrust.h"
 
 VCardErrorCode createCard(char* fileName, Card** newCardObject) {
     VCardErrorCode theError = OK;
     FILE* fp = NULL;
-    char* line = NULL;
-    bool isFirstLine = true;
-    bool isVersionFour = false;
-    bool isEnd = false;
-
-    // Pointers to contentline
-    char* groupName = NULL;
-    char* propertyName = NULL;
-    char* parameterValues = NULL;
-    char* propertyValues = NULL;
-
-    // Generic data pointers (to be used)
-    Property* aProperty = NULL;
-    DateTime* aDateTime = NULL;
 
     // Check file name validity
-    if (!(fileName)) 
+    if (!(hasCardExtension(fileName))) 
         return INV_FILE;
-    if (strlen(fileName) < 4) 
+
+    // Open the file, decompressing .vcf.gz and .vcf.zst as it is read
+    if (!(fp = openCardFile(fileName))) 
         return INV_FILE;
-    if (strcmp(&fileName[strlen(fileName) - 4], ".vcf") != 0) 
+
+    theError = readCard(fp, newCardObject);
+    fclose(fp);
+
+    return theError;
+}
+
+VCardErrorCode createCardFromBuffer(const char* data, size_t len, Card** newCardObject) {
+    VCardErrorCode theError = OK;
+    FILE* fp = NULL;
+
+    if (data == NULL || len == 0) 
         return INV_FILE;
 
-    // Open the file
-    if (!(fp = fopen(fileName, "r"))) 
+    // Read the buffer through a memory stream so it goes through the same tokenizer as files
+    if (!(fp = openCardBuffer(data, len))) 
         return INV_FILE;
 
-    // Create the card object
-    if (!(*newCardObject = malloc(sizeof(Card)))) 
-        return OTHER_ERROR;
-        
-    (*newCardObject)->fn = NULL;
-    if (!((*newCardObject)->optionalProperties = initializeList(printProperty,deleteProperty,compareProperties))) 
-        return OTHER_ERROR;
-    (*newCardObject)->birthday = NULL;
-    (*newCardObject)->anniversary = NULL;
-
-    // Read through lines
-    while (!(feof(fp))) {
-        theError = readProperty(fp, &line);
-        if (theError != OK) 
-            break;
-            
-        theError = divideProperty(line, &groupName, &propertyName, &parameterValues, &propertyValues);
-        if (theError != OK)
-            break;
-            
-        if (propertyName == NULL) {
-            theError = INV_PROP;
-            break;
-        }
-        if (strcmp(propertyName, "") == 0) {
-            theError = INV_PROP;
-            break;
-        }
-        if (propertyValues == NULL) {
-            theError = INV_PROP;
-            break;
-        }
-        if (strcmp(propertyValues, "") == 0) {
-            theError = INV_PROP;
-            break;
-        }
+    theError = readCard(fp, newCardObject);
+    fclose(fp);
 
-        /*Special Properties:
-         * General - *BEGIN*, *END*, SOURCE, KIND, XML
-         * Identification - *FN*, N NICKNAME, PHOTO, *BDAY*, *ANNIVERSARY*, GENDER
-         */
-        if (isFirstLine) {
-            if ((strcmp(propertyName, "BEGIN") == 0) && (strcmp(propertyValues, "VCARD") == 0))
-                isFirstLine = false;
-            else {
-                theError = INV_CARD;
-                break;
-            }
-        }
-        else if ((strcmp(propertyName, "VERSION") == 0)) {
-            if ((strcmp(propertyValues, "4.0") != 0)) {
-                theError = INV_CARD;
-                break;
-            }
-            else {
-                isVersionFour = true;
-            }
-        }
-        else if ((stricasecmp(propertyName, "FN") == 0)) {
-            theError = createProperty(&aProperty);
-            
-            if (theError != OK)
-                break;
-            (*newCardObject)->fn = aProperty;
-            
-            if (groupName) {
-                replaceString(&(aProperty->group), groupName);
-                if (!(aProperty->group)) {
-                    theError = OTHER_ERROR;
-                    break;
-                }
-            }
-            replaceString(&(aProperty->name), propertyName);
-            if (!(aProperty->name)) {
-                theError = OTHER_ERROR;
-                break;
-            }
-            if (parameterValues) {
-                theError = addParams(aProperty, parameterValues);
-                if (theError != OK)
-                    break;
-            }
-            theError = addValues(aProperty, propertyValues);
-            if (theError != OK)
-                break;
-        }
-        else if ((stricasecmp(propertyName, "BDAY") == 0)) {
-            createDateTime(&aDateTime, parameterValues, propertyValues);
-            (*newCardObject)->birthday = aDateTime;
-        }
-        else if ((stricasecmp(propertyName, "ANNIVERSARY") == 0)) {
-            createDateTime(&aDateTime, parameterValues, propertyValues);
-            (*newCardObject)->anniversary = aDateTime;
-        }
-        else if (feof(fp)) {
-            if ((strcmp(propertyName, "END") == 0) || (strcmp(propertyValues, "VCARD") == 0)) {
-                isEnd = true;
-            }
-        }
-        else {
-            theError = createProperty(&aProperty);
-            
-            if (theError != OK)
-                break;
-            insertBack((*newCardObject)->optionalProperties, aProperty);
-            
-            if (groupName) {
-                replaceString(&(aProperty->group), groupName);
-                if (!(aProperty->group)) {
-                    theError = OTHER_ERROR;
-                    break;
-                }
-            }
-            replaceString(&(aProperty->name), propertyName);
-            if (!(aProperty->name)) {
-                theError = OTHER_ERROR;
-                break;
-            }
-            if (parameterValues) {
-                theError = addParams(aProperty, parameterValues);
-                if (theError != OK)
-                    break;
-            }
-            theError = addValues(aProperty, propertyValues);
-            if (theError != OK)
-                break;
-        }
+    return theError;
+}
+
+VCardErrorCode readCard(FILE* fp, Card** newCardObject) {
+    CardScanner scanner;
+    VCardErrorCode theError;
+
+    *newCardObject = NULL;
+    if ((theError = initCardScanner(&scanner, fp)) != OK)
+        return theError;
+
+    // Every card is built from scanned lines, so lines have no length limit and the
+    // context, lazy and summary readers apply exactly the same rules
+    theError = readCardFromScanner(&scanner, newCardObject);
+    freeCardScanner(&scanner);
 
-        free(line);
-        free(groupName);
-        free(propertyName);
-        free(parameterValues);
-        free(propertyValues);
-        line = NULL;
-        groupName = NULL;
-        propertyName = NULL;
-        parameterValues = NULL;
-        propertyValues = NULL;
-    }
-
-    free(line);
-    free(groupName);
-    free(propertyName);
-    free(parameterValues);
-    free(propertyValues);
-    fclose(fp);
-    if (theError == OK) {
-        if (! ((*newCardObject)->fn) ) 
-            theError = INV_CARD;
-        else if (isVersionFour == false)
-            theError = INV_CARD;
-        else if (isEnd == false)
-            theError = INV_CARD;
-    }
     return theError;
 }
 
@@ -267,10 +138,10 @@ void deleteProperty(void* toBeDeleted) {
     if (theProperty == NULL)
         return;
 
-    free(theProperty->name);
-    free(theProperty->group);
     freeList(theProperty->parameters);
     freeList(theProperty->values);
+    releaseName(theProperty->name);
+    releaseName(theProperty->group);
     free(theProperty);
 }
 int compareProperties(const void* first,const void* second) {
@@ -289,14 +160,14 @@ char* printProperty(void* toBePrinted) {
         
     char* str = malloc(sizeof(char) * 16);
     strcpy(str, "Property Name: ");
-    char* toCat = printValue(theProperty->name); 
+    char* toCat = printValue((char*) theProperty->name); 
     str = realloc(str, sizeof(char) * (strlen(str) + strlen(toCat) + 1));
     strcat(str, toCat);
     free(toCat);
     
     str = realloc(str, sizeof(char) * (strlen(str) + 14));
     strcat(str, "\nGroup Name: ");
-    toCat = printValue(theProperty->group);
+    toCat = printValue((char*) theProperty->group);
     str = realloc(str, sizeof(char) * (strlen(str) + strlen(toCat) + 1));
     strcat(str, toCat);
     free(toCat);
@@ -322,6 +193,7 @@ void deleteParameter(void* toBeDeleted) {
     if (toBeDeleted == NULL)
         return;
 
+    releaseName(((Parameter*) toBeDeleted)->name);
     free(toBeDeleted);
 }
 int compareParameters(const void* first,const void* second) {
@@ -404,13 +276,23 @@ char* printDate(void* toBePrinted) {
 
 VCardErrorCode writeCard(const char* fileName, const Card* obj) {
     FILE* fp = NULL;
+    VCardErrorCode err;
+
+    if (!(fp = fopen(fileName, "w"))) return WRITE_ERROR;
+
+    err = writeCardToStream(fp, obj);
+    if (fclose(fp) != 0 && err == OK) err = WRITE_ERROR;
+
+    return err;
+}
+
+/* Serializes a card in vCard format to any stream, such as a file or an open_memstream buffer. */
+VCardErrorCode writeCardToStream(FILE* fp, const Card* obj) {
     void* elem = NULL;
     void* elem2 = NULL;
     Property* prop = NULL;
     Parameter* param = NULL;
     
-    if (!(fp = fopen(fileName, "w"))) return WRITE_ERROR;
-    
     if (!(fputs("BEGIN:VCARD\r\n", fp))) return WRITE_ERROR;
     
     if (!(fputs("VERSION:4.0\r\n", fp))) return WRITE_ERROR;
@@ -655,6 +537,27 @@ VCardErrorCode validateCard(const Card* obj) {
     return OK;
 }
 
+VCardErrorCode validateCardLevel(const Card* obj, ValidationLevel level) {
+    ListIterator iter;
+    Property* prop;
+
+    if (level == VALIDATE_NONE) return OK;
+    if (level != VALIDATE_STRUCTURAL) return validateCard(obj);
+
+    // Only the rules validateCard reports as INV_CARD, in the same order
+    if (obj == NULL || obj->fn == NULL || obj->optionalProperties == NULL) return INV_CARD;
+    if (obj->fn->name == NULL) return INV_PROP;
+    if (stricasecmp(obj->fn->name, "FN") != 0) return INV_CARD;
+
+    iter = createIterator(obj->optionalProperties);
+    while ((prop = nextElement(&iter)) != NULL) {
+        if (prop->name && (stricasecmp(prop->name, "BEGIN") == 0 || stricasecmp(prop->name, "END") == 0
+                || stricasecmp(prop->name, "VERSION") == 0))
+            return INV_CARD;
+    }
+    return OK;
+}
+
 char* strListToJSON(const List* strList) {
     ListIterator iter;
     char* JSONstr = NULL;
@@ -797,7 +700,7 @@ Property* JSONtoProp(const char* str) {
         free(JSONstr);
         return NULL;
     }
-    if (!(replaceString(&aProperty->group, p1))) {
+    if (!(aProperty->group = internName(p1))) {
         free(JSONstr);
         deleteProperty(aProperty);
         return NULL;
@@ -829,7 +732,7 @@ Property* JSONtoProp(const char* str) {
         deleteProperty(aProperty);
         return NULL;
     }
-    if (!(replaceString(&aProperty->name, p1))) {
+    if (!(aProperty->name = internName(p1))) {
         free(JSONstr);
         deleteProperty(aProperty);
         return NULL;
@@ -1094,6 +997,7 @@ DateTime* JSONtoDT(const char* str) {
         free(aDT);
         return NULL;
     }
+    setDateKeys(aDT);
     
     free(JSONstr);
     return aDT;
@@ -1154,7 +1058,7 @@ Card* JSONtoCard(const char* str) {
         deleteCard(aCard);
         return NULL;
     }
-    if (!(replaceString(&aProperty->name, "FN"))) {
+    if (!(aProperty->name = internName("FN"))) {
         free(JSONstr);
         deleteCard(aCard);
         deleteProperty(aProperty);
@@ -1182,126 +1086,218 @@ void addProperty(Card* card, const Property* toBeAdded) {
 }
 
 char* getSummaryFromFile(char* fileName) {
-    Card* myCard = NULL;
-    char* text = malloc(sizeof(char) * 50);
-    strcpy(text, "Error");
+    return getSummaryFromFileLevel(fileName, VALIDATE_STRICT);
+}
+
+char* getSummaryFromFileLevel(char* fileName, ValidationLevel level) {
+    char* name = NULL;
+    int length = 0;
+    bool isInvalid = false;
+    VCardErrorCode err;
+
+    if ((err = summarizeFileLevel(fileName, resolveValidationLevel(fileName, level), &name, &length, &isInvalid)) != OK)
+        return summaryErrorToJSON(fileName, isInvalid);
 
+    char* JSONstr = summaryToJSON(fileName, name, length);
+    free(name);
+    return JSONstr;
+}
+
+VCardErrorCode summarizeFile(const char* fileName, char** name, int* opLength, bool* isInvalid) {
+    return summarizeFileLevel(fileName, VALIDATE_STRICT, name, opLength, isInvalid);
+}
+
+VCardErrorCode summarizeFileLevel(const char* fileName, ValidationLevel level, char** name, int* opLength, bool* isInvalid) {
+    CardScanner scanner;
+    FILE* fp = NULL;
+    VCardErrorCode err;
+
+    *name = NULL;
+    *opLength = 0;
+    *isInvalid = false;
+
+    if (!(hasCardExtension(fileName)))
+        return INV_FILE;
+    if (!(fp = openCardFile(fileName)))
+        return INV_FILE;
+
+    if ((err = initCardScanner(&scanner, fp)) == OK) {
+        err = summarizeScannerLevel(&scanner, level, name, opLength, isInvalid);
+        freeCardScanner(&scanner);
+    }
+    fclose(fp);
+    return err;
+}
+
+char* summaryToJSON(const char* fileName, const char* name, int opLength) {
+    StringBuffer JSONstr;
+
+    if (!initStringBuffer(&JSONstr)) return NULL;
+    if (!appendSummaryJSON(&JSONstr, fileName, name, opLength)) {
+        free(JSONstr.str);
+        return NULL;
+    }
+    return JSONstr.str;
+}
+
+/*  Appends the summary object getSummaryFromFile returns.  The file is named without its
+    top-level directory.  Both it and FN are escaped, since either may hold quotes or backslashes.
+*/
+bool appendSummaryJSON(StringBuffer* buffer, const char* fileName, const char* name, int opLength) {
+    const char* file = strchr(fileName, '/');
+    char num[12];
+
+    sprintf(num, "%d", opLength);
+    return appendString(buffer, "{\"file\":") && appendJSONString(buffer, file ? file + 1 : fileName)
+            && appendString(buffer, ", \"name\":") && appendJSONString(buffer, name)
+            && appendString(buffer, ", \"opLength\":\"") && appendString(buffer, num)
+            && appendString(buffer, "\"}");
+}
+
+char* summaryErrorToJSON(const char* fileName, bool isInvalid) {
+    StringBuffer text;
+
+    if (!initStringBuffer(&text)) return NULL;
+    if (!appendSummaryError(&text, fileName, isInvalid)) {
+        free(text.str);
+        return NULL;
+    }
+    return text.str;
+}
+
+/* Appends the error text shared by the summary and property functions. */
+bool appendSummaryError(StringBuffer* buffer, const char* fileName, bool isInvalid) {
+    char text[50];
     FILE* file;
-    if (!(file = fopen(fileName, "r"))) {
+
+    if (isInvalid) {
+        strcpy(text, "Error: Not a valid card");
+    }
+    else if (!(file = fopen(fileName, "r"))) {
         snprintf(text, 49, "Error: \"%s\" not found", fileName);
         text[49] = '\0';
-        return text;
     }
-    fclose(file);
-
-    if ((createCard(fileName, &myCard)) != OK) {
-        deleteCard(myCard);
+    else {
+        fclose(file);
         strcpy(text, "Error: Could not create card");
-        return text;
-    }
-    if (validateCard(myCard) != OK) {
-        deleteCard(myCard);
-        strcpy(text, "Error: Not a valid card");
-        return text;
     }
-    int length = getLength(myCard->optionalProperties);
-    if (myCard->birthday) length++;
-    if (myCard->anniversary) length++;
-    char* JSONstr = malloc(sizeof(char));
-    strcpy(JSONstr, "");
-    char num[5];
-    char *theFile = duplicateString(fileName);
-    char *p1 = strTokenizer(theFile, '/');
-    
-    JSONstr = realloc(JSONstr, sizeof(char) * 10);
-    strcat(JSONstr, "{\"file\":\"");
-    JSONstr = realloc(JSONstr, sizeof(char) * (strlen(JSONstr) + strlen(p1) + 1));
-    strcat(JSONstr, p1);
-    free(theFile);
-    JSONstr = realloc(JSONstr, sizeof(char) * (strlen(JSONstr) + 12));
-    strcat(JSONstr, "\", \"name\":\"");
-    char* name = getFromFront(myCard->fn->values);
-    JSONstr = realloc(JSONstr, sizeof(char) * (strlen(JSONstr) + strlen(name) + 1));
-    strcat(JSONstr, name);
-    JSONstr = realloc(JSONstr, sizeof(char) * (strlen(JSONstr) + 16));
-    strcat(JSONstr, "\", \"opLength\":\"");
-    sprintf(num, "%d", length);
-    JSONstr = realloc(JSONstr, sizeof(char) * (strlen(JSONstr) + 5));
-    strcat(JSONstr, num);
-    JSONstr = realloc(JSONstr, sizeof(char) * (strlen(JSONstr) + 3));
-    strcat(JSONstr, "\"}");
-    
-    deleteCard(myCard);
-    free(text);
-    return JSONstr;
+    return appendString(buffer, text);
 }
 
 char* getPropertiesFromFile(char* fileName) {
+    return getPropertiesFromFileLevel(fileName, VALIDATE_STRICT);
+}
+
+char* getPropertiesFromFileLevel(char* fileName, ValidationLevel level) {
     Card* myCard = NULL;
-    char* text = malloc(sizeof(char) * 50);
-    strcpy(text, "Error");
+    StringBuffer JSONstr;
+    ListIterator iter;
+    Property* aProperty;
+    int n = 1;
+    bool result;
 
-    FILE* file;
-    if (!(file = fopen(fileName, "r"))) {
-        snprintf(text, 49, "Error: \"%s\" not found", fileName);
-        text[49] = '\0';
-        return text;
+    if (createCard(fileName, &myCard) != OK) {
+        deleteCard(myCard);
+        return summaryErrorToJSON(fileName, false);
     }
-    fclose(file);
-
-    if ((createCard(fileName, &myCard)) != OK) {
+    if (validateCardLevel(myCard, resolveValidationLevel(fileName, level)) != OK) {
         deleteCard(myCard);
-        strcpy(text, "Error: Could not create card");
-        return text;
+        return summaryErrorToJSON(fileName, true);
     }
-    if (validateCard(myCard) != OK) {
+    if (!initStringBuffer(&JSONstr)) {
         deleteCard(myCard);
-        strcpy(text, "Error: Not a valid card");
-        return text;
+        return summaryErrorToJSON(fileName, false);
     }
-    
-    char* JSONstr = malloc(sizeof(char));
-    strcpy(JSONstr, "");
-    
-    JSONstr = realloc(JSONstr, sizeof(char) * 38);
-    strcat(JSONstr, "[{\"number\":\"1\",\"name\":\"FN\",\"values\":\"");
-    char* values = valuesToJSON(myCard->fn->values);
-    JSONstr = realloc(JSONstr, sizeof(char) * (strlen(JSONstr) + strlen(values) + 1));
-    strcat(JSONstr, values);
+
+    // Entries are built as getPropertiesRange and the property index build them, with FN first
+    result = appendString(&JSONstr, "[") && appendPropertyEntry(&JSONstr, n, myCard->fn);
+    iter = createIterator(myCard->optionalProperties);
+    while (result && (aProperty = (Property*) nextElement(&iter)) != NULL)
+        result = appendString(&JSONstr, ",") && appendPropertyEntry(&JSONstr, ++n, aProperty);
+    result = result && appendString(&JSONstr, "]");
+    deleteCard(myCard);
+
+    if (!result) {
+        free(JSONstr.str);
+        return summaryErrorToJSON(fileName, false);
+    }
+    return JSONstr.str;
+}
+
+/* Builds one element of the properties array, e.g. {"number":"2","name":"TEL","values":"a, b"}. */
+bool appendPropertyEntry(StringBuffer* buffer, int number, const Property* prop) {
+    char num[12];
+    char* values;
+    bool result;
+
+    if (!(values = valuesToJSON(prop->values))) return false;
+    sprintf(num, "%d", number);
+    result = appendString(buffer, "{\"number\":\"") && appendString(buffer, num)
+            && appendString(buffer, "\",\"name\":") && appendJSONString(buffer, prop->name)
+            && appendString(buffer, ",\"values\":") && appendJSONString(buffer, values)
+            && appendString(buffer, "}");
     free(values);
-    JSONstr = realloc(JSONstr, sizeof(char) * (strlen(JSONstr) + 3));
-    strcat(JSONstr, "\"}");
-    
-    char num[5];
-    int n = 1;
-    ListIterator iter = createIterator((List*)myCard->optionalProperties);
-    Property *aProperty;
-    while((aProperty = (Property*) nextElement(&iter)) != NULL) {
-        JSONstr = realloc(JSONstr, sizeof(char) * (strlen(JSONstr) + 13));
-        strcat(JSONstr, ",{\"number\":\"");
-        n++;
-        sprintf(num, "%d", n);
-        JSONstr = realloc(JSONstr, sizeof(char) * (strlen(JSONstr) + strlen(num) + 1));
-        strcat(JSONstr, num);
-        JSONstr = realloc(JSONstr, sizeof(char) * (strlen(JSONstr) + 11));
-        strcat(JSONstr, "\",\"name\":\"");
-        JSONstr = realloc(JSONstr, sizeof(char) * (strlen(JSONstr) + strlen(aProperty->name) + 1));
-        strcat(JSONstr, aProperty->name);
-        JSONstr = realloc(JSONstr, sizeof(char) * (strlen(JSONstr) + 13));
-        strcat(JSONstr, "\",\"values\":\"");
-        values = valuesToJSON(aProperty->values);
-        JSONstr = realloc(JSONstr, sizeof(char) * (strlen(JSONstr) + strlen(values) + 1));
-        strcat(JSONstr, values);
-        free(values);
-        JSONstr = realloc(JSONstr, sizeof(char) * (strlen(JSONstr) + 3));
-        strcat(JSONstr, "\"}");
+
+    return result;
+}
+
+bool appendLazyPropertyEntry(StringBuffer* buffer, int number, LazyCard* obj, int index) {
+    Property* prop;
+    char size[32];
+    long length;
+
+    if (!(prop = getLazyProperty(obj, index)) || !appendPropertyEntry(buffer, number, prop)) return false;
+    if ((length = getLazyValueSize(obj, index)) < 0) return true;
+
+    // Reopen the entry to add the size of the value left in the file
+    buffer->str[--buffer->length] = '\0';
+    sprintf(size, ",\"size\":%ld}", length);
+    return appendString(buffer, size);
+}
+
+char* getPropertiesRange(char* fileName, int offset, int limit) {
+    LazyCard* card = NULL;
+    StringBuffer JSONstr;
+    char num[12];
+    int end;
+    VCardErrorCode err;
+
+    if (offset < 0) offset = 0;
+    if (limit < 0) limit = 0;
+
+    // Every line is checked, but only properties inside the requested range are built
+    if ((err = acquireLazyCard(fileName, &card)) != OK || card->validation != OK || !initStringBuffer(&JSONstr)) {
+        bool isInvalid = err == OK && card->validation != OK;
+
+        releaseLazyCard(card);
+        return summaryErrorToJSON(fileName, isInvalid);
     }
-    JSONstr = realloc(JSONstr, sizeof(char) * (strlen(JSONstr) + 2));
-    strcat(JSONstr, "]");
-    
-    deleteCard(myCard);
-    free(text);
-    return JSONstr;
+
+    // FN is always property 1, wherever it appears in the file
+    sprintf(num, "%d", getLazyPropertyCount(card));
+    appendString(&JSONstr, "{\"total\":");
+    appendString(&JSONstr, num);
+    sprintf(num, "%d", offset);
+    appendString(&JSONstr, ",\"offset\":");
+    appendString(&JSONstr, num);
+    appendString(&JSONstr, ",\"properties\":[");
+
+    end = limit > getLazyPropertyCount(card) - offset ? getLazyPropertyCount(card) : offset + limit;
+    for (int i = offset; i < end; i++) {
+        if ((i > offset && !appendString(&JSONstr, ",")) || !appendLazyPropertyEntry(&JSONstr, i + 1, card, i)) {
+            free(JSONstr.str);
+            releaseLazyCard(card);
+            return summaryErrorToJSON(fileName, false);
+        }
+    }
+    appendString(&JSONstr, "]}");
+
+    releaseLazyCard(card);
+    return JSONstr.str;
+}
+
+void freeResult(char* result) {
+    free(result);
 }
 
 char* valuesToJSON(const List* strList) {
@@ -1310,6 +1306,7 @@ char* valuesToJSON(const List* strList) {
     char* aValue = NULL;
     
     JSONstr = malloc(sizeof(char));
+    strcpy(JSONstr, "");
     
     if (strList != NULL) {
         iter = createIterator((List*)strList);
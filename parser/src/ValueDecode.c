@@ -0,0 +1,238 @@
+/**
+ * @file ValueDecode.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#include "ValueDecode.h"
+#include "ParserFunctions.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define HAVE_AVX2_DECODE
+#endif
+
+// Value of each character as a base64 digit, standard or URL-safe, or -1
+static const signed char base64Digits[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, 62, -1, 63,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+    -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, 63,
+    -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+/* Decodes up to length characters one at a time, stopping after the first '='.  Returns the characters read. */
+static size_t decodeBase64Scalar(ValueDecoder* decoder, const char* in, size_t length, unsigned char* out, size_t* written) {
+    size_t i;
+    int digit;
+
+    for (i = 0; i < length; i++) {
+        if (in[i] == '=') {
+            decoder->isDone = true;
+            return i + 1;
+        }
+        if ((digit = base64Digits[(unsigned char) in[i]]) < 0) continue;
+
+        decoder->bits = (decoder->bits << 6) | digit;
+        decoder->bitCount += 6;
+        if (decoder->bitCount >= 8) {
+            decoder->bitCount -= 8;
+            out[(*written)++] = (decoder->bits >> decoder->bitCount) & 0xFF;
+            decoder->bits &= (1u << decoder->bitCount) - 1;
+        }
+    }
+    return i;
+}
+
+#ifdef HAVE_AVX2_DECODE
+/*  Decodes 32 standard base64 digits into 24 bytes, with the lookup and packing of
+    Muła and Lemire's "Faster Base64 Encoding and Decoding using AVX2 Instructions".
+    Writes 32 bytes to out.  Returns false, writing nothing, if any character is not a
+    standard digit, so the caller can fall back to the scalar decoder for the block.
+*/
+__attribute__((target("avx2")))
+static bool decodeBlockAVX2(const char* in, unsigned char* out) {
+    const __m256i lowLookup = _mm256_setr_epi8(
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i highLookup = _mm256_setr_epi8(
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i shiftLookup = _mm256_setr_epi8(
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i packBytes = _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i nibbleMask = _mm256_set1_epi8(0x0F);
+    __m256i chars = _mm256_loadu_si256((const __m256i*) in);
+    __m256i high = _mm256_and_si256(_mm256_srli_epi32(chars, 4), nibbleMask);
+    __m256i low = _mm256_and_si256(chars, nibbleMask);
+    __m256i isSlash;
+    __m256i values;
+
+    // A character is a digit only if its low and high nibble classes do not overlap
+    if (!_mm256_testz_si256(_mm256_shuffle_epi8(lowLookup, low), _mm256_shuffle_epi8(highLookup, high))) return false;
+
+    // '/' shares its high nibble with '+', so it is told apart before the shift is looked up
+    isSlash = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('/'));
+    values = _mm256_add_epi8(chars, _mm256_shuffle_epi8(shiftLookup, _mm256_add_epi8(isSlash, high)));
+
+    // Four 6-bit values to three bytes in each 32-bit lane, then the lanes' bytes made contiguous
+    values = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+    values = _mm256_madd_epi16(values, _mm256_set1_epi32(0x00011000));
+    values = _mm256_shuffle_epi8(values, packBytes);
+    values = _mm256_permutevar8x32_epi32(values, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+    _mm256_storeu_si256((__m256i*) out, values);
+
+    return true;
+}
+
+static bool hasAVX2(void) {
+    static int supported = -1;
+
+    if (supported < 0) supported = __builtin_cpu_supports("avx2") ? 1 : 0;
+    return supported == 1;
+}
+#endif
+
+static size_t decodeBase64Run(ValueDecoder* decoder, const char* in, size_t length, unsigned char* out) {
+    size_t written = 0;
+    size_t i = 0;
+
+    if (decoder->isDone) return 0;
+
+#ifdef HAVE_AVX2_DECODE
+    if (hasAVX2()) {
+        // Blocks are decoded only on a quantum boundary.  out holds DECODED_SIZE(length) bytes and
+        // written is at most 3 bytes per 4 characters read, so a block's 32-byte store stays inside it.
+        while (i + 32 <= length && !decoder->isDone) {
+            if (decoder->bitCount == 0 && decodeBlockAVX2(in + i, out + written)) {
+                i += 32;
+                written += 24;
+            }
+            else {
+                // A block with other characters is decoded one at a time, then one more at a time until aligned
+                i += decodeBase64Scalar(decoder, in + i, decoder->bitCount == 0 ? 32 : 1, out, &written);
+            }
+        }
+    }
+#endif
+    if (!decoder->isDone) decodeBase64Scalar(decoder, in + i, length - i, out, &written);
+
+    return written;
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+static size_t decodeQuotedPrintableRun(ValueDecoder* decoder, const char* in, size_t length, unsigned char* out) {
+    const char* escape;
+    size_t written = 0;
+    size_t i = 0;
+    size_t span;
+    char c;
+
+    while (i < length) {
+        if (decoder->pendingCount == 0) {
+            // Plain text up to the next '=' is copied as it is
+            escape = memchr(in + i, '=', length - i);
+            span = escape ? (size_t) (escape - (in + i)) : length - i;
+            memcpy(out + written, in + i, span);
+            written += span;
+            i += span;
+            if (i == length) break;
+            decoder->pending[decoder->pendingCount++] = in[i++];
+            continue;
+        }
+
+        c = in[i];
+        if (hexValue(c) < 0) {
+            // Not an escape: the '=' and any digit after it are kept
+            memcpy(out + written, decoder->pending, decoder->pendingCount);
+            written += decoder->pendingCount;
+            decoder->pendingCount = 0;
+            continue;
+        }
+        if (decoder->pendingCount == 1) {
+            decoder->pending[decoder->pendingCount++] = c;
+            i++;
+            continue;
+        }
+        out[written++] = (hexValue(decoder->pending[1]) << 4) | hexValue(c);
+        decoder->pendingCount = 0;
+        i++;
+    }
+    return written;
+}
+
+void initValueDecoder(ValueDecoder* decoder, ValueEncoding encoding) {
+    memset(decoder, 0, sizeof(ValueDecoder));
+    decoder->encoding = encoding;
+}
+
+size_t decodeValueRun(ValueDecoder* decoder, const char* in, size_t length, unsigned char* out) {
+    switch (decoder->encoding) {
+    case VALUE_BASE64:
+        return decodeBase64Run(decoder, in, length, out);
+    case VALUE_QUOTED_PRINTABLE:
+        return decodeQuotedPrintableRun(decoder, in, length, out);
+    default:
+        memcpy(out, in, length);
+        return length;
+    }
+}
+
+size_t finishValueDecoder(ValueDecoder* decoder, unsigned char* out) {
+    size_t written = decoder->pendingCount;
+
+    memcpy(out, decoder->pending, decoder->pendingCount);
+    decoder->pendingCount = 0;
+    return written;
+}
+
+size_t decodeBase64(const char* in, size_t length, unsigned char* out) {
+    ValueDecoder decoder;
+
+    initValueDecoder(&decoder, VALUE_BASE64);
+    return decodeValueRun(&decoder, in, length, out);
+}
+
+size_t decodeQuotedPrintable(const char* in, size_t length, unsigned char* out) {
+    ValueDecoder decoder;
+    size_t written;
+
+    initValueDecoder(&decoder, VALUE_QUOTED_PRINTABLE);
+    written = decodeValueRun(&decoder, in, length, out);
+    return written + finishValueDecoder(&decoder, out + written);
+}
+
+ValueEncoding getValueEncoding(const Property* prop) {
+    ListIterator iter;
+    Parameter* param;
+
+    if (prop == NULL) return VALUE_TEXT;
+
+    iter = createIterator(prop->parameters);
+    while ((param = nextElement(&iter)) != NULL) {
+        if (stricasecmp(param->name, "ENCODING") != 0) continue;
+        if (stricasecmp(param->value, "b") == 0 || stricasecmp(param->value, "BASE64") == 0) return VALUE_BASE64;
+        if (stricasecmp(param->value, "QUOTED-PRINTABLE") == 0) return VALUE_QUOTED_PRINTABLE;
+    }
+    return VALUE_TEXT;
+}
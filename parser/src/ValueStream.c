@@ -0,0 +1,333 @@
+/**
+ * @file ValueStream.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#define _DEFAULT_SOURCE
+
+#include <ctype.h>
+#include <sys/stat.h>
+
+#include "ValueStream.h"
+#include "CompressedStream.h"
+
+// Longest data: URI header looked at before the ',', and the raw bytes it may span with folds and escapes
+#define DATA_HEADER_SIZE 256
+#define DATA_HEADER_RAW (4 * DATA_HEADER_SIZE)
+
+// Unfolded characters decoded at a time
+#define STAGING_SIZE 65536
+
+// Raw bytes read from the value's source at a time
+#define WINDOW_SIZE 65536
+
+/*  Makes sure the window holds the raw bytes from the stream's position on, at least need of them
+    where the value has that many left.  Bytes before the position may be dropped.  A source that
+    ends early ends the value there.
+*/
+static void fillWindow(ValueStream* stream, long need) {
+    long kept = stream->windowStart + stream->windowLength - stream->position;
+    long wanted;
+    size_t n = 0;
+
+    if (kept >= need || stream->windowStart + stream->windowLength >= stream->end) return;
+
+    memmove(stream->window, stream->window + (stream->position - stream->windowStart), kept);
+    stream->windowStart = stream->position;
+    stream->windowLength = kept;
+
+    wanted = stream->end - (stream->windowStart + kept);
+    if (wanted > WINDOW_SIZE - kept) wanted = WINDOW_SIZE - kept;
+    if (stream->source) n = fread(stream->window + kept, 1, wanted, stream->source);
+    stream->windowLength += n;
+    if ((long) n < wanted) stream->end = stream->windowStart + stream->windowLength;
+}
+
+/* The raw byte at the stream's position, which the window must hold. */
+static char byteAt(const ValueStream* stream, long position) {
+    return stream->window[position - stream->windowStart];
+}
+
+/* Skips folds and the closing CRLF at the stream's position, the way unfoldLine does. */
+static void skipFolds(ValueStream* stream) {
+    fillWindow(stream, 3);
+    while (stream->position + 1 < stream->end && byteAt(stream, stream->position) == '\r' && byteAt(stream, stream->position + 1) == '\n') {
+        stream->position += 2;
+        if (stream->position < stream->end && byteAt(stream, stream->position) == ' ') stream->position++;
+        fillWindow(stream, 3);
+    }
+}
+
+/*  Whether a lower-cased media type may be served from the app's own origin.  The type
+    comes from the card, so only image, audio and application types are kept, and of
+    those none a browser would run as a page or script: HTML, XML (which covers SVG and
+    XHTML) and JavaScript.
+*/
+static bool isSafeMediaType(const char* type) {
+    const char* allowed[] = { "image/", "audio/", "application/" };
+    const char* unsafe[] = { "html", "xml", "script" };
+    bool isAllowed = false;
+
+    for (int i = 0; i < 3; i++) {
+        if (strncmp(type, allowed[i], strlen(allowed[i])) == 0) isAllowed = true;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (strstr(type, unsafe[i])) isAllowed = false;
+    }
+    return isAllowed;
+}
+
+/*  Copies a media type if it is safe to send as a Content-Type, lower-cased.  A type that
+    is well formed but not safe to serve becomes application/octet-stream.
+*/
+static char* copyMediaType(const char* type, int length) {
+    char* copy;
+
+    if (length <= 0 || !strchr(type, '/') || strchr(type, '/') >= type + length) return NULL;
+    for (int i = 0; i < length; i++) {
+        if (!isalnum((unsigned char) type[i]) && !strchr("!#$&^_.+-/", type[i])) return NULL;
+    }
+
+    if (!(copy = malloc(sizeof(char) * (length + 1)))) return NULL;
+    for (int i = 0; i < length; i++)
+        copy[i] = tolower((unsigned char) type[i]);
+    copy[length] = '\0';
+
+    if (!isSafeMediaType(copy)) {
+        free(copy);
+        return duplicateString("application/octet-stream");
+    }
+    return copy;
+}
+
+/* Whether a value starts with "data:", in any case. */
+static bool isDataURI(const char* header) {
+    const char* scheme = "data:";
+
+    for (int i = 0; scheme[i]; i++) {
+        if (tolower((unsigned char) header[i]) != scheme[i]) return false;
+    }
+    return true;
+}
+
+/*  Reads a data: URI's header, up to and including its ',', and moves the stream past it.
+    Leaves the stream where it was if the value is not a data: URI.
+*/
+static void readDataHeader(ValueStream* stream) {
+    char header[DATA_HEADER_SIZE + 1];
+    long start = stream->position;
+    int length = 0;
+    int typeLength;
+
+    // The header is read inside one window, so the stream can go back to its start.  Backslashes
+    // are dropped, since the ';' and ',' of a single-valued data: URI are escaped in a card.
+    fillWindow(stream, DATA_HEADER_RAW + 3);
+    while (length < DATA_HEADER_SIZE && stream->position - start < DATA_HEADER_RAW) {
+        skipFolds(stream);
+        if (stream->position >= stream->end) break;
+        if (byteAt(stream, stream->position) == '\\') {
+            stream->position++;
+            continue;
+        }
+        if ((header[length++] = byteAt(stream, stream->position++)) == ',') break;
+    }
+    header[length] = '\0';
+
+    if (length < 6 || header[length - 1] != ',' || !isDataURI(header)) {
+        stream->position = start;
+        return;
+    }
+
+    // data:[<media type>][;base64],<data>
+    header[--length] = '\0';
+    if (length >= 12 && stricasecmp(header + length - 7, ";base64") == 0) stream->decoder.encoding = VALUE_BASE64;
+    typeLength = strcspn(header + 5, ";");
+    if (typeLength > 0) {
+        free(stream->mediaType);
+        stream->mediaType = copyMediaType(header + 5, typeLength);
+    }
+}
+
+/* Sets the media type from the property's parameters. */
+static void readParameters(ValueStream* stream, const Property* prop) {
+    ListIterator iter = createIterator(prop->parameters);
+    Parameter* param;
+    const char* prefix;
+    char type[64];
+
+    while ((param = nextElement(&iter)) != NULL) {
+        if (stricasecmp(param->name, "MEDIATYPE") == 0) {
+            free(stream->mediaType);
+            stream->mediaType = copyMediaType(param->value, strlen(param->value));
+        }
+        else if (stricasecmp(param->name, "TYPE") == 0 && stream->mediaType == NULL) {
+            // vCard 3.0 names the format alone, as in PHOTO;TYPE=JPEG
+            prefix = stricasecmp(prop->name, "SOUND") == 0 ? "audio/" : stricasecmp(prop->name, "KEY") == 0 ? "application/" : "image/";
+            if (strlen(param->value) < sizeof(type) - strlen(prefix)) {
+                sprintf(type, "%s%s", prefix, param->value);
+                stream->mediaType = copyMediaType(type, strlen(type));
+            }
+        }
+    }
+}
+
+/* Index of the property a stream was asked for, or -1. */
+static int findProperty(LazyCard* card, const char* name, int number) {
+    Property* prop;
+
+    if (number > 0) return number <= getLazyPropertyCount(card) ? number - 1 : -1;
+    if (name == NULL) return -1;
+
+    for (int i = 1; i < getLazyPropertyCount(card); i++) {
+        if ((prop = getLazyProperty(card, i)) && stricasecmp(prop->name, name) == 0) return i;
+    }
+    return -1;
+}
+
+/*  Opens what a value is read from.  A value the card keeps is read from its bytes; one left in
+    the file is read from the file again, skipped to, as long as the file is still the one the
+    card was read from.
+*/
+static bool openValueSource(ValueStream* stream, char* fileName, int index, const ValueRef* ref) {
+    LazyCard* card = stream->card;
+    struct stat st;
+    const char* line;
+    long length;
+    long skip;
+    size_t n;
+
+    stream->position = 0;
+    stream->end = ref->length;
+    if (ref->length == 0) return true;
+
+    if (!isLazyValueInFile(card, index)) {
+        line = getLazyLine(card, index, &length);
+        return line && (stream->source = fmemopen((char*) line + (ref->offset - card->lines[index].offset), ref->length, "r"));
+    }
+
+    if (!(stream->source = openCardFile(fileName))) return false;
+    if (stat(fileName, &st) != 0 || st.st_mtim.tv_sec != card->mtime.tv_sec || st.st_mtim.tv_nsec != card->mtime.tv_nsec
+            || st.st_size != card->fileSize)
+        return false;
+
+    // Compressed files cannot seek, so what comes before the value is decompressed and dropped
+    if (fseek(stream->source, ref->offset, SEEK_SET) != 0) {
+        for (skip = ref->offset; skip > 0; skip -= n) {
+            if ((n = fread(stream->window, 1, skip < WINDOW_SIZE ? skip : WINDOW_SIZE, stream->source)) == 0) return false;
+        }
+    }
+    return true;
+}
+
+ValueStream* openValueStream(char* fileName, const char* name, int number) {
+    ValueStream* stream;
+    Property* prop;
+    ValueRef ref;
+    int index;
+    VCardErrorCode err;
+
+    if (fileName == NULL || !(stream = calloc(1, sizeof(ValueStream)))) return NULL;
+    if (!initStringBuffer(&stream->error) || !(stream->staging = malloc(STAGING_SIZE)) || !(stream->window = malloc(WINDOW_SIZE))) {
+        closeValueStream(stream);
+        return NULL;
+    }
+
+    if ((err = acquireLazyCard(fileName, &stream->card)) != OK || stream->card->validation != OK) {
+        releaseLazyCard(stream->card);
+        stream->card = NULL;
+        appendSummaryError(&stream->error, fileName, err == OK);
+        return stream;
+    }
+
+    if ((index = findProperty(stream->card, name, number)) < 0 || !(prop = getLazyProperty(stream->card, index))
+            || !findLazyValue(stream->card, index, &ref)) {
+        releaseLazyCard(stream->card);
+        stream->card = NULL;
+        appendString(&stream->error, "Error: No such property");
+        return stream;
+    }
+
+    if (!openValueSource(stream, fileName, index, &ref)) {
+        releaseLazyCard(stream->card);
+        stream->card = NULL;
+        appendString(&stream->error, "Error: Could not read value");
+        return stream;
+    }
+
+    initValueDecoder(&stream->decoder, getValueEncoding(prop));
+    readParameters(stream, prop);
+    if (stream->decoder.encoding == VALUE_TEXT) readDataHeader(stream);
+
+    if (stream->mediaType == NULL)
+        stream->mediaType = duplicateString(stream->decoder.encoding == VALUE_TEXT ? "text/plain" : "application/octet-stream");
+    return stream;
+}
+
+const char* getValueMediaType(ValueStream* stream) {
+    if (stream == NULL || stream->card == NULL || stream->mediaType == NULL) return "";
+
+    return stream->mediaType;
+}
+
+const char* getValueError(ValueStream* stream) {
+    if (stream == NULL) return "";
+
+    return stream->error.str;
+}
+
+/* Copies up to size unfolded characters of the value into the staging buffer.  Returns how many. */
+static int stageValue(ValueStream* stream, int size) {
+    const char* data;
+    const char* lineEnd;
+    long span;
+    int n = 0;
+
+    while (n < size) {
+        skipFolds(stream);
+        if (stream->position >= stream->end) break;
+
+        // Everything up to the next CR in the window is copied at once
+        data = stream->window + (stream->position - stream->windowStart);
+        span = stream->windowStart + stream->windowLength - stream->position;
+        if (span > size - n) span = size - n;
+        if ((lineEnd = memchr(data, '\r', span))) span = lineEnd - data;
+        if (span == 0) span = 1;
+
+        memcpy(stream->staging + n, data, span);
+        stream->position += span;
+        n += span;
+    }
+    return n;
+}
+
+int readValueChunk(ValueStream* stream, char* buffer, int size) {
+    int staged;
+    int n = 0;
+
+    if (stream == NULL || stream->card == NULL || buffer == NULL) return -1;
+
+    // Each pass stages no more than the decoder could write into the room left
+    while (!stream->isFinished && size - n > 3) {
+        staged = stageValue(stream, size - n - 3 < STAGING_SIZE ? size - n - 3 : STAGING_SIZE);
+        n += decodeValueRun(&stream->decoder, stream->staging, staged, (unsigned char*) buffer + n);
+
+        if (staged == 0 || stream->decoder.isDone) {
+            n += finishValueDecoder(&stream->decoder, (unsigned char*) buffer + n);
+            stream->isFinished = true;
+        }
+    }
+    return n;
+}
+
+void closeValueStream(ValueStream* stream) {
+    if (stream == NULL) return;
+
+    if (stream->source) fclose(stream->source);
+    releaseLazyCard(stream->card);
+    free(stream->mediaType);
+    free(stream->staging);
+    free(stream->window);
+    free(stream->error.str);
+    free(stream);
+}
@@ -0,0 +1,368 @@
+/**
+ * @file VCardTool.c
+ * @author Joshua Sarabdial
+ * @date October 2026
+ **/
+
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <libgen.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "VCardParser.h"
+#include "ParserFunctions.h"
+#include "CardDiff.h"
+#include "CardExport.h"
+#include "CompressedStream.h"
+#include "Corpus.h"
+
+/*  Command-line bulk converter over the parser library.
+
+        vcardtool [-j threads] input output
+
+    input is a directory of card files, a file of one or more vCards (.vcf, .vcf.gz or
+    .vcf.zst), or a .jsonl file with one card per line as cardToJSONLine writes it.
+    output is a .jsonl file, a .vcf file holding every card, or a directory that receives
+    one file per card written by writeCard, named after its input file when the input is
+    a directory.  Every card is validated with validateCard,
+    and invalid cards are reported and skipped.
+
+    Cards are read on the main thread in batches, then parsed, validated and serialized
+    on every core with forEachCardFile, and written in input order.  A summary of cards/s
+    and MB/s of card text read is printed at the end.
+*/
+
+// Cards converted at a time, bounded by count and by bytes so large PHOTOs do not pile up
+#define BATCH_CARDS 4096
+#define BATCH_BYTES (64 * 1024 * 1024)
+
+// Invalid cards reported one by one before only being counted
+#define MAX_REPORTED 10
+
+typedef enum cf { FORMAT_VCF, FORMAT_JSONL, FORMAT_DIRECTORY } CardFormat;
+
+// One card's text as read, and what converting it produced
+typedef struct toolItem {
+    char*           text;
+    size_t          length;
+    const char*     source;
+    int             number;
+
+    VCardErrorCode  err;
+    char*           output;
+} ToolItem;
+
+typedef struct toolBatch {
+    ToolItem        items[BATCH_CARDS];
+    char*           names[BATCH_CARDS];
+    int             count;
+    size_t          bytes;
+
+    CardFormat      from;
+    CardFormat      to;
+    // Whether the input was a directory, so each output file keeps its input's name
+    bool            isFromDirectory;
+    FILE*           out;
+    const char*     outDir;
+
+    // Totals across batches
+    long            cards;
+    long            invalid;
+    long            written;
+    double          totalBytes;
+    bool            isWriteFailed;
+} ToolBatch;
+
+static bool hasSuffix(const char* str, const char* suffix) {
+    size_t length = strlen(str);
+    size_t suffixLength = strlen(suffix);
+
+    return length >= suffixLength && strcmp(str + length - suffixLength, suffix) == 0;
+}
+
+static double now(void) {
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/*  Names the file a card is written to in an output directory.  Cards from a directory
+    keep their file's name, less any compression extension, and the second and later
+    cards of a file add their number to it; cards from one file are numbered in input order.
+*/
+static void cardPath(const ToolBatch* batch, int index, char* path, size_t size) {
+    const ToolItem* item = &batch->items[index];
+    char source[4096];
+    char* name;
+    size_t length;
+
+    if (!batch->isFromDirectory) {
+        snprintf(path, size, "%s/card%08ld.vcf", batch->outDir, (long) (batch->cards + index + 1));
+        return;
+    }
+
+    snprintf(source, sizeof(source), "%s", item->source);
+    name = basename(source);
+    length = strlen(name);
+    if (hasSuffix(name, ".gz")) length -= 3;
+    else if (hasSuffix(name, ".zst")) length -= 4;
+    name[length] = '\0';
+    if (hasSuffix(name, ".vcf")) name[length - 4] = '\0';
+
+    if (item->number > 1)
+        snprintf(path, size, "%s/%s-%d.vcf", batch->outDir, name, item->number);
+    else
+        snprintf(path, size, "%s/%s.vcf", batch->outDir, name);
+}
+
+/* Parses, validates and serializes one card.  Runs on a worker thread. */
+static void convertItem(int index, const char* name, void* arg) {
+    ToolBatch* batch = (ToolBatch*) arg;
+    ToolItem* item = &batch->items[index];
+    Card* card = NULL;
+    char path[4096];
+
+    if (batch->from == FORMAT_JSONL) item->err = JSONLineToCard(item->text, &card);
+    else item->err = createCardFromBuffer(item->text, item->length, &card);
+    if (item->err == OK) item->err = validateCard(card);
+
+    if (item->err == OK) {
+        switch (batch->to) {
+        case FORMAT_JSONL:
+            if (!(item->output = cardToJSONLine(card))) item->err = OTHER_ERROR;
+            break;
+        case FORMAT_VCF:
+            if (!(item->output = cardToVCard(card))) item->err = WRITE_ERROR;
+            break;
+        default:
+            cardPath(batch, index, path, sizeof(path));
+            item->err = writeCard(path, card);
+        }
+    }
+    deleteCard(card);
+}
+
+/* Converts the cards read so far in parallel, then writes them in order and clears the batch. */
+static void flushBatch(ToolBatch* batch, int threads) {
+    ToolItem* item;
+    char* error;
+
+    if (batch->count == 0) return;
+
+    for (int i = 0; i < batch->count; i++)
+        batch->names[i] = batch->items[i].text;
+    forEachCardFile(batch->names, batch->count, convertItem, batch, threads);
+
+    for (int i = 0; i < batch->count; i++) {
+        item = &batch->items[i];
+        if (item->err != OK) {
+            if (batch->invalid++ < MAX_REPORTED) {
+                error = printError(item->err);
+                fprintf(stderr, "%s: card %d: %s\n", item->source, item->number, error ? error : "");
+                free(error);
+            }
+        }
+        else {
+            if (item->output && fputs(item->output, batch->out) == EOF) batch->isWriteFailed = true;
+            batch->written++;
+        }
+        batch->cards++;
+        free(item->text);
+        free(item->output);
+        item->output = NULL;
+    }
+    batch->count = 0;
+    batch->bytes = 0;
+}
+
+static void addItem(ToolBatch* batch, char* text, size_t length, const char* source, int number, int threads) {
+    ToolItem* item = &batch->items[batch->count++];
+
+    item->text = text;
+    item->length = length;
+    item->source = source;
+    item->number = number;
+    item->err = OK;
+    item->output = NULL;
+    batch->bytes += length;
+    batch->totalBytes += length;
+
+    if (batch->count == BATCH_CARDS || batch->bytes >= BATCH_BYTES) flushBatch(batch, threads);
+}
+
+/* Appends a line to a card being collected. */
+static bool appendLine(char** card, size_t* length, size_t* capacity, const char* line, size_t lineLength) {
+    char* grown;
+
+    if (*length + lineLength + 1 > *capacity) {
+        *capacity = (*length + lineLength + 1) * 2;
+        if (!(grown = realloc(*card, *capacity))) return false;
+        *card = grown;
+    }
+    memcpy(*card + *length, line, lineLength);
+    *length += lineLength;
+    (*card)[*length] = '\0';
+    return true;
+}
+
+/* Whether a line, without its line ending, is text in any case. */
+static bool isLine(const char* line, ssize_t length, const char* text) {
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+        length--;
+    return (size_t) length == strlen(text) && strncasecmp(line, text, length) == 0;
+}
+
+/*  Splits a stream of vCards at their BEGIN:VCARD and END:VCARD lines, since readCard
+    reads a stream as one card.  Lines between cards are ignored.
+*/
+static bool readCards(ToolBatch* batch, FILE* fp, const char* source, int threads) {
+    char* line = NULL;
+    size_t lineCapacity = 0;
+    ssize_t lineLength;
+    char* card = NULL;
+    size_t length = 0;
+    size_t capacity = 0;
+    int number = 0;
+    bool result = true;
+
+    while (result && (lineLength = getline(&line, &lineCapacity, fp)) > 0) {
+        if (card == NULL && !isLine(line, lineLength, "BEGIN:VCARD")) continue;
+        if (card == NULL) capacity = 0;
+
+        if (!(result = appendLine(&card, &length, &capacity, line, lineLength))) break;
+        if (isLine(line, lineLength, "END:VCARD")) {
+            addItem(batch, card, length, source, ++number, threads);
+            card = NULL;
+            length = 0;
+        }
+    }
+    // A card cut off by the end of the stream is passed on, to be reported invalid
+    if (result && card) addItem(batch, card, length, source, ++number, threads);
+    else free(card);
+
+    free(line);
+    return result;
+}
+
+static void readJSONLines(ToolBatch* batch, FILE* fp, const char* source, int threads) {
+    char* line = NULL;
+    size_t lineCapacity = 0;
+    ssize_t lineLength;
+    int number = 0;
+
+    while ((lineLength = getline(&line, &lineCapacity, fp)) > 0) {
+        number++;
+        if (isLine(line, lineLength, "")) continue;
+
+        addItem(batch, line, lineLength, source, number, threads);
+        line = NULL;
+        lineCapacity = 0;
+    }
+    free(line);
+}
+
+static bool readInput(ToolBatch* batch, const char* fileName, int threads) {
+    FILE* fp;
+    bool result = true;
+
+    if (batch->from == FORMAT_JSONL) fp = fopen(fileName, "r");
+    else fp = hasCardExtension(fileName) ? openCardFile(fileName) : fopen(fileName, "r");
+    if (!fp) {
+        fprintf(stderr, "%s: %s\n", fileName, strerror(errno));
+        return false;
+    }
+
+    if (batch->from == FORMAT_JSONL) readJSONLines(batch, fp, fileName, threads);
+    else if (!(result = readCards(batch, fp, fileName, threads))) fprintf(stderr, "%s: out of memory\n", fileName);
+    fclose(fp);
+    return result;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: vcardtool [-j threads] input output\n"
+            "  input   directory of card files, .vcf file of one or more cards, or .jsonl file\n"
+            "  output  .jsonl file, .vcf file, or directory for one .vcf per card\n"
+            "  -j      worker threads; 0, the default, uses one per online CPU\n");
+}
+
+int main(int argc, char** argv) {
+    static ToolBatch batch;
+    struct stat info;
+    char** files = NULL;
+    int count = 0;
+    int threads = 0;
+    int arg = 1;
+    double start;
+    double seconds;
+    bool result = true;
+
+    if (arg + 1 < argc && strcmp(argv[arg], "-j") == 0) {
+        threads = atoi(argv[arg + 1]);
+        arg += 2;
+    }
+    if (argc - arg != 2) {
+        usage();
+        return 2;
+    }
+
+    // Input: a directory of card files, or one file
+    if (stat(argv[arg], &info) != 0) {
+        fprintf(stderr, "%s: %s\n", argv[arg], strerror(errno));
+        return 1;
+    }
+    if (S_ISDIR(info.st_mode)) {
+        if (listCardFiles(argv[arg], &files, &count) != OK) {
+            fprintf(stderr, "%s: cannot list card files\n", argv[arg]);
+            return 1;
+        }
+        batch.from = FORMAT_VCF;
+        batch.isFromDirectory = true;
+    }
+    else {
+        batch.from = hasSuffix(argv[arg], ".jsonl") ? FORMAT_JSONL : FORMAT_VCF;
+    }
+
+    // Output: a file of every card, or a directory of one file per card
+    if (hasSuffix(argv[arg + 1], ".jsonl") || hasSuffix(argv[arg + 1], ".vcf")) {
+        batch.to = hasSuffix(argv[arg + 1], ".jsonl") ? FORMAT_JSONL : FORMAT_VCF;
+        if (!(batch.out = fopen(argv[arg + 1], "w"))) {
+            fprintf(stderr, "%s: %s\n", argv[arg + 1], strerror(errno));
+            freeCardFiles(files, count);
+            return 1;
+        }
+    }
+    else {
+        batch.to = FORMAT_DIRECTORY;
+        batch.outDir = argv[arg + 1];
+        if (mkdir(batch.outDir, 0755) != 0 && errno != EEXIST) {
+            fprintf(stderr, "%s: %s\n", batch.outDir, strerror(errno));
+            freeCardFiles(files, count);
+            return 1;
+        }
+    }
+
+    start = now();
+    if (files) {
+        for (int i = 0; i < count; i++)
+            result = readInput(&batch, files[i], threads) && result;
+    }
+    else {
+        result = readInput(&batch, argv[arg], threads);
+    }
+    flushBatch(&batch, threads);
+    if (batch.out && fclose(batch.out) != 0) batch.isWriteFailed = true;
+    seconds = now() - start;
+
+    if (batch.invalid > MAX_REPORTED) fprintf(stderr, "... %ld more invalid cards\n", batch.invalid - MAX_REPORTED);
+    if (batch.isWriteFailed) fprintf(stderr, "%s: write failed\n", argv[arg + 1]);
+    fprintf(stderr, "%ld cards, %ld written, %ld invalid in %.3f s: %.0f cards/s, %.1f MB/s of card text\n",
+            batch.cards, batch.written, batch.invalid, seconds,
+            seconds > 0 ? batch.cards / seconds : 0.0, seconds > 0 ? batch.totalBytes / seconds / 1e6 : 0.0);
+
+    freeCardFiles(files, count);
+    return result && !batch.isWriteFailed && batch.invalid == 0 ? 0 : 1;
+}
@@ -9,23 +9,6 @@ $(document).ready(function() {
 			//console.log(data);
 			for (var i = 0; i < data.length; i++) {
 				$('#fileList').append("<option>"+data[i]+"</option>");
-				$.ajax({
-					url: '/endpoint',
-					type: 'get',
-					datatype: 'json',
-					data: {
-						file: data[i]
-					},
-					success: function (data2) {
-						let ind = JSON.parse(data2);
-						$('#fileSummary').append("<tr><td><a href=\"/uploads/"+ind.file
-						+"\">"+ind.file+"</a></td><td>"+ind.name+"</td><td>"+ind.opLength
-						+"</td></tr>");
-					},
-					fail: function (error) {
-						console.log(error);
-					}
-				});
 			}
 		},
 		fail: function(error) {
@@ -33,23 +16,88 @@ $(document).ready(function() {
 		}
 	});
 	
+	// Summaries come sorted from the server a page at a time; clicking a header sorts by it, and again reverses it
+	const summaryPageSize = 100;
+	let summarySort = 'name';
+	let summaryOrder = 'asc';
+	let nextSummaryOffset = 0;
+	
+	function loadSummaries() {
+		$.ajax({
+			url: '/summaries',
+			type: 'get',
+			datatype: 'json',
+			data: {
+				sort: summarySort,
+				order: summaryOrder,
+				offset: nextSummaryOffset,
+				limit: summaryPageSize
+			},
+			success: function (data) {
+				let page = typeof data === 'string' ? JSON.parse(data) : data;
+				for (let ind of page.summaries) {
+					$('#fileSummary').append("<tr><td><a href=\"/uploads/"+ind.file
+					+"\">"+ind.file+"</a></td><td>"+ind.name+"</td><td>"+ind.opLength
+					+"</td></tr>");
+				}
+				nextSummaryOffset = page.offset + page.summaries.length;
+				$('#moreSummariesBtn').toggle(nextSummaryOffset < page.total);
+			},
+			fail: function (error) {
+				console.log(error);
+			}
+		});
+	}
+	
+	$('#fileSummary th.sortable').click(function() {
+		let sort = $(this).data('sort');
+		summaryOrder = sort === summarySort && summaryOrder === 'asc' ? 'desc' : 'asc';
+		summarySort = sort;
+		$('#fileSummary tr:gt(0)').remove();
+		nextSummaryOffset = 0;
+		loadSummaries();
+	});
+	document.getElementById("moreSummariesBtn").onclick = function() {loadSummaries()};
+	loadSummaries();
+	
 	document.getElementById("fileList").onchange = function() {changeFunction()};
+	document.getElementById("moreBtn").onclick = function() {loadProperties()};
+	
+	const pageSize = 50;
+	let nextOffset = 0;
 	
 	function changeFunction() {
+		$('#fileProperties tr:gt(0)').remove();
+		nextOffset = 0;
+		loadProperties();
+	}
+	
+	// Fetches the next page of properties for the selected card and appends it to the table
+	function loadProperties() {
 		var x = document.getElementById("fileList").value;
 		$.ajax({
 			url: '/endpoint2',
 			type: 'get',
 			datatype: 'json',
 			data: {
-				file: x
+				file: x,
+				offset: nextOffset,
+				limit: pageSize
 			},
 			success: function (data) {
-				let card = JSON.parse(data);
-				for (let property of card) {
+				// The native addon sends objects with value arrays; the ffi path sends JSON text
+				let page = typeof data === 'string' ? JSON.parse(data) : data;
+				for (let property of page.properties) {
+					let values = Array.isArray(property.values) ? property.values.join(', ') : property.values;
+					// Large values stay in the card file and are linked rather than listed
+					if (property.size !== undefined) {
+						values = "<a href=\"/uploads/"+x+"/photo?number="+property.number+"\">"+property.size+" bytes</a>";
+					}
 					$('#fileProperties').append("<tr><td>"+property.number+"</td><td>"
-					+property.name+"</td><td>"+property.values+"</td></tr>");
-				}			
+					+property.name+"</td><td>"+values+"</td></tr>");
+				}
+				nextOffset = page.offset + page.properties.length;
+				$('#moreBtn').toggle(nextOffset < page.total);
 			},
 		fail: function (error) {
 			console.log(error);